@@ -6,6 +6,29 @@
 #include <queue>     // Includes the priority_queue container needed for Dijkstra's algorithm.
 #include <cmath>     // Includes math functions like max() or sqrt().
 #include <map>       // Includes the map container (key-value pairs), though unused in this specific logic.
+#include <random>    // Includes the mt19937 generator used to build reproducible benchmark maps.
+#include <chrono>    // Includes the high resolution clock used to time the benchmarks.
+#include <algorithm> // Includes reverse() used when stitching routes together.
+#include <unordered_map> // Includes the hash map used to merge parallel roads during preprocessing.
+#include <fstream>   // Includes file streams used to save and load precomputed tables.
+#include <thread>    // Includes std::thread for multi-core batch queries (compile with -pthread).
+#include <atomic>    // Includes atomic counters used to hand out work to the threads.
+#include <mutex>     // Includes the mutex guarding caches shared between threads.
+#include <shared_mutex> // Includes shared_lock, which holds the traffic lock on behalf of a query.
+#include <cstring>   // Includes memcmp/memcpy used for binary graph file headers.
+#include <sstream>   // Includes ostringstream used to format values before printing them.
+#include <condition_variable> // Includes the condition variables that pace the query server's queue.
+#include <deque>     // Includes the queue of requests waiting for a server worker.
+#include <memory>    // Includes shared_ptr, which keeps a client connection open until its last answer is sent.
+#ifndef _WIN32
+#include <sys/mman.h> // Includes mmap() used to map binary graph files into memory.
+#include <sys/stat.h> // Includes fstat() used to find the size of a mapped file.
+#include <fcntl.h>    // Includes open() used to open a graph file for mapping.
+#include <unistd.h>   // Includes close() for the file descriptor.
+#include <sys/socket.h> // Includes the socket calls used by the query server.
+#include <sys/un.h>     // Includes sockaddr_un for Unix domain sockets.
+#include <sys/resource.h> // Includes getrusage() used to report peak memory in the benchmark suite.
+#endif
 
 using namespace std; // Allows using standard library names (like cout, vector) without the std:: prefix.
 
@@ -13,339 +36,7716 @@ using namespace std; // Allows using standard library names (like cout, vector)
 //        CONFIGURATION CONSTANTS
 // ==========================================
 const double PRICE_PETROL = 280.0;  // Sets the global constant price for petrol.
-const double PRICE_DIESEL = 295.0;  // Sets the global constant price for diesel (unused but defined).
-const int MAX_CITIES = 20;          // Defines the maximum number of cities the system can handle.
+const double PRICE_DIESEL = 295.0;  // Sets the global constant price for diesel (used by diesel vehicles).
+const double DRIVER_COST_PER_HOUR = 600.0; // PKR per hour of a driver's time (fleet routing costs).
 const double INF = 1e9;             // Defines a very large number (1 billion) to represent infinity.
+const double EARTH_RADIUS_KM = 6371.0; // Mean radius of the Earth, used for straight-line distances.
+const int PROFILE_SLOTS = 96;       // Breakpoints of a daily traffic profile (one every 15 minutes).
+const double PROFILE_SLOT_MINUTES = 1440.0 / PROFILE_SLOTS; // Minutes between two breakpoints.
+const double PROFILE_STEP = 1.0 / 64; // Multiplier step of a stored profile value (1 + value / 64).
+const unsigned GRAPH_FORMAT_VERSION = 1; // Version of the binary graph file (see saveBinaryGraph).
+
+// Query instrumentation switch. Compile with -DROUTE_METRICS to count heap pushes and stale
+// pops in every query search, time the query phases and collect them in the histograms of
+// queryMetrics(). Without it every METRIC(...) statement is removed by the preprocessor, so
+// the searches run exactly as before.
+#ifdef ROUTE_METRICS
+#define METRIC(...) __VA_ARGS__
+#else
+#define METRIC(...)
+#endif
 
 // ==========================================
 //          DATA STRUCTURES
 // ==========================================
 
-// Enum to define traffic severity levels as named constants.
-enum TrafficLevel {
-    LOW,        // Represents clear roads (Index 0).
-    MODERATE,   // Represents normal traffic (Index 1).
-    HIGH,       // Represents rush hour traffic (Index 2).
-    JAMMED      // Represents severe blockage (Index 3).
-};
+// Enum to define traffic severity levels as named constants.
+enum TrafficLevel : unsigned char { // Stored in one byte inside every Edge.
+    LOW,        // Represents clear roads (Index 0).
+    MODERATE,   // Represents normal traffic (Index 1).
+    HIGH,       // Represents rush hour traffic (Index 2).
+    JAMMED      // Represents severe blockage (Index 3).
+};
+
+// Enum to define different types of roads.
+enum RoadType : unsigned char {  // Stored in one byte inside every Edge.
+    MOTORWAY,   // Represents high-speed motorways.
+    HIGHWAY,    // Represents standard highways.
+    LOCAL       // Represents slower local roads.
+};
+const int ROAD_TYPE_COUNT = 3; // Number of RoadType values (used to size per-type tables).
+
+// Enum to choose which search algorithm findRoute uses.
+enum SearchMode {
+    DIJKSTRA,       // Classic one-to-all Dijkstra from the start city.
+    BIDIRECTIONAL,  // Searches forward from the start and backward from the destination until they meet.
+    ASTAR,          // Goal-directed search guided by the straight-line distance to the destination.
+    CONTRACTION_HIERARCHY, // Query on the preprocessed contraction hierarchy (built on first use).
+    LANDMARKS,      // A* guided by landmark distances and the triangle inequality (ALT).
+    PARTITION_OVERLAY // Multi-level Dijkstra on the customizable partition overlay (CRP, built on first use).
+};
+
+// Enum to choose the vehicle whose fuel use a route is costed for (see VehicleProfile).
+enum VehicleKind {
+    PETROL_CAR,     // Standard petrol car (the default).
+    DIESEL_TRUCK,   // Heavy goods truck running on diesel.
+    BUS             // Intercity diesel bus.
+};
+const int VEHICLE_KIND_COUNT = 3; // Number of VehicleKind values.
+
+// Enum for the fuel a vehicle burns (sets the price per litre).
+enum FuelType {
+    PETROL,         // Priced at PRICE_PETROL.
+    DIESEL          // Priced at PRICE_DIESEL.
+};
+
+// Enum to choose how landmarks for the LANDMARKS mode are picked.
+enum LandmarkStrategy {
+    FARTHEST,       // Each new landmark is the city farthest from all landmarks chosen so far.
+    AVOID           // Each new landmark covers the region where the current bounds are weakest.
+};
+
+// Structure representing a single connection (road) between cities.
+// Only what the searches read lives here, packed into 24 bytes so more roads fit in a cache
+// line; the road name is kept apart in an interned table (see RoutePlanner::roadNames).
+struct Edge {
+    int destination;      // Stores the ID of the city this road leads to.
+    TrafficLevel traffic; // Stores the traffic condition on this road.
+    RoadType type;        // Stores the type of road (Motorway, Highway, etc.).
+    unsigned short profileId; // Time-of-day traffic profile (0 = none, the static traffic applies all day).
+    double distanceKM;    // Stores the length of the road in kilometers.
+    double cost;          // Precomputed distance x traffic multiplier (see RoutePlanner::getEdgeCost).
+};
+
+// Function to compute the great-circle (straight-line over the globe) distance in km.
+double greatCircleKM(double lat1, double lon1, double lat2, double lon2) {
+    const double toRad = M_PI / 180.0;           // Converts degrees to radians.
+    double dLat = (lat2 - lat1) * toRad;
+    double dLon = (lon2 - lon1) * toRad;
+    // Haversine formula, which stays accurate for short distances.
+    double a = sin(dLat / 2) * sin(dLat / 2) +
+               cos(lat1 * toRad) * cos(lat2 * toRad) * sin(dLon / 2) * sin(dLon / 2);
+    return 2.0 * EARTH_RADIUS_KM * asin(min(1.0, sqrt(a)));
+}
+
+// Structure holding a road exactly as it was typed into addRoad, before the graph is compressed.
+struct PendingRoad {
+    int from;  // Stores the ID of the city the road starts from.
+    Edge edge; // Stores the rest of the road details (destination, distance, etc.).
+    int nameId; // Stores the road name's index in the interned name table.
+};
+
+// Structure holding counters about the work done by the last search.
+struct SearchStats {
+    long long settledNodes = 0;  // Number of cities taken off the queue with their final time.
+    long long relaxedEdges = 0;  // Number of roads examined during the search.
+    long long heapPushes = 0;    // Queue entries added (counted with ROUTE_METRICS only).
+    long long stalePops = 0;     // Queue entries skipped because the city was already reached faster (ROUTE_METRICS only).
+};
+
+// Structure used in the Priority Queue to order cities by travel time.
+struct PqNode {
+    int id;           // Stores the city ID.
+    double timeCost;  // Stores the total time taken to reach this city.
+
+    // Overloads the > operator so the Priority Queue works as a Min-Heap (smallest time on top).
+    bool operator>(const PqNode& other) const {
+        return timeCost > other.timeCost; // Returns true if current time is greater than the other.
+    }
+};
+
+// Structure holding a dense origin x destination matrix (row-major, INF if unreachable).
+struct TravelMatrix {
+    int rows = 0, cols = 0;          // Number of origins and destinations.
+    vector<double> minTime;          // Minutes from origin r to destination c at [r * cols + c].
+    vector<double> pathDist;         // Kilometres along that route.
+    vector<double> fuelConsumed;     // Litres of fuel along that route.
+};
+
+// Enum to choose what the budget of an isochrone query limits.
+enum BudgetKind {
+    TIME_BUDGET,    // Minutes of driving.
+    FUEL_BUDGET     // Litres of fuel.
+};
+
+// A road that leaves a reachable city but runs out of budget before its far end.
+struct CutRoad {
+    int road;             // Road index (in the direction it is driven).
+    int from;             // Reachable city the road leaves from.
+    int to;               // City at the far end.
+    double reachedKM;     // Kilometres of the road that can be driven before the budget runs out.
+};
+
+// Result of an isochrone query: everything reachable from one origin within a budget.
+struct IsochroneResult {
+    int origin = 0;       // Origin city ID.
+    double budget = 0;    // Minutes or litres, depending on 'kind'.
+    BudgetKind kind = TIME_BUDGET;
+    vector<int> cities;   // Reachable cities, nearest first (the origin included).
+    vector<double> spent; // Budget used to reach each of them.
+    vector<CutRoad> cutRoads; // Roads cut off by the budget (one entry per direction if cut from both ends).
+    SearchStats stats;    // Work done by the search.
+};
+
+// One leg of a route: the road driven from one city to the next.
+struct RouteLeg {
+    int from;             // City the leg starts at.
+    int to;               // City the leg ends at.
+    int road;             // Road index used (the exact road, even when parallel roads exist).
+    TrafficLevel traffic; // Traffic on the road when the route was planned.
+    RoadType type;        // Type of the road.
+    double distanceKM;    // Length of the road.
+    double minutes;       // Time spent on the road.
+    double fuel;          // Litres used on the road.
+};
+
+// Result of one route query as plain data; printing it is a separate, optional step.
+struct RouteResult {
+    bool found = false;   // False if a city ID is invalid or the cities are not connected.
+    int startNode = 0;    // Origin city ID.
+    int endNode = 0;      // Destination city ID.
+    int speed = 0;        // Average speed in km/h.
+    double departure = -1; // Minutes after midnight for time-dependent routes (-1 = not time-dependent).
+    vector<int> route;    // Cities in travel order.
+    vector<RouteLeg> legs; // One entry per road driven, in travel order.
+    double totalTime = 0; // Minutes.
+    double totalDist = 0; // Kilometres.
+    double totalFuel = 0; // Litres.
+    double fuelCost = 0;  // PKR at the price of the vehicle's fuel.
+    VehicleKind vehicle = PETROL_CAR; // Vehicle the fuel is costed for.
+    double searchMs = 0;  // Wall-clock time the query took.
+    SearchStats stats;    // Work done by the search.
+};
+
+// One trip of a fleet: which vehicle drives between which cities, and how fast.
+struct FleetTrip {
+    VehicleKind vehicle;  // Vehicle driving the trip.
+    int startNode;        // Origin city ID.
+    int endNode;          // Destination city ID.
+    int speed;            // Average speed in km/h.
+};
+
+// Enum to choose what a multi-stop run is ordered to save.
+enum TourObjective {
+    TOUR_TIME,      // Minutes of driving.
+    TOUR_FUEL       // Litres of fuel (along the fastest route between stops).
+};
+
+// Result of a multi-stop run: the stops in visiting order and the route driven between each pair.
+struct TourResult {
+    bool found = false;        // False if a stop ID is invalid or some stop can't be reached.
+    vector<int> stops;         // City IDs in visiting order, from the depot (and back to it on a round trip).
+    vector<RouteResult> legs;  // Route from stops[k] to stops[k + 1].
+    bool roundTrip = true;     // True if the run ends back at the depot.
+    bool exact = false;        // True if the order is optimal, false if it came from local search.
+    int speed = 0;             // Average speed in km/h.
+    VehicleKind vehicle = PETROL_CAR;
+    TourObjective objective = TOUR_TIME;
+    double totalTime = 0;      // Minutes.
+    double totalDist = 0;      // Kilometres.
+    double totalFuel = 0;      // Litres.
+    double fuelCost = 0;       // PKR.
+    double matrixMs = 0;       // Wall-clock time of the stop-to-stop matrix.
+    double solveMs = 0;        // Wall-clock time spent ordering the stops.
+    double legsMs = 0;         // Wall-clock time spent planning the legs.
+};
+
+// One order of a fleet routing problem: where it goes and how much of a vehicle it fills.
+struct DeliveryOrder {
+    int city;             // Destination city ID.
+    double demand;        // Load (same unit as the vehicle capacity).
+};
+
+// A fleet routing problem: orders to deliver from one depot with identical vehicles.
+struct FleetProblem {
+    int depot = 1;                    // City every route starts and ends at.
+    vector<DeliveryOrder> orders;     // Orders to deliver.
+    VehicleKind vehicle = DIESEL_TRUCK; // Vehicle of the whole fleet.
+    double capacity = 100;            // Load one vehicle carries per route.
+    int maxVehicles = 0;              // Vehicles available (0 = as many as needed).
+    int speed = 80;                   // Average speed in km/h.
+    double costPerHour = DRIVER_COST_PER_HOUR; // PKR per hour of driving, added to the fuel cost.
+};
+
+// Result of a fleet routing problem: one round trip from the depot per vehicle used.
+struct FleetPlan {
+    bool found = false;        // False if an ID is invalid, a stop can't be reached or the orders don't fit.
+    vector<TourResult> routes; // Route of every vehicle, with the orders in visiting order.
+    vector<vector<int>> orders; // Index in FleetProblem::orders of the order each stop of a route delivers.
+    vector<double> loads;      // Load carried on every route.
+    double totalTime = 0;      // Minutes, summed over all vehicles.
+    double totalDist = 0;      // Kilometres.
+    double totalFuel = 0;      // Litres.
+    double fuelCost = 0;       // PKR of fuel.
+    double totalCost = 0;      // PKR of fuel plus driver time.
+    double savingsCost = 0;    // PKR of the routes of the savings construction the search started from.
+    int savingsUnassigned = 0; // Orders that savings construction left without a vehicle (vehicle limit).
+    long long solutions = 0;   // Candidate solutions built by ruin and recreate, over all starts.
+    double matrixMs = 0;       // Wall-clock time of the order-to-order matrix.
+    double solveMs = 0;        // Wall-clock time of the search.
+    double legsMs = 0;         // Wall-clock time spent planning the legs.
+};
+
+// One route of a Pareto frontier: no other route is at least as good in time, fuel and distance.
+struct ParetoRoute {
+    double totalTime;             // Minutes.
+    double totalFuel;             // Litres.
+    double totalDist;             // Kilometres.
+    vector<int> route;            // Cities in travel order.
+    vector<int> roads;            // Road index used for every leg.
+};
+
+// Limits an alternative route must meet (see RoutePlanner::planAlternativeRoutes).
+// Times are fractions of the fastest route's time.
+struct AlternativeLimits {
+    int maxRoutes = 3;            // Routes returned at most, the fastest one included.
+    double maxStretch = 0.25;     // Extra time allowed over the fastest route.
+    double maxSharing = 0.8;      // Time an alternative may share with any better option.
+    double localOptimality = 0.25; // Every part of the route up to this long must be a fastest route itself.
+    int maxCandidates = 64;       // Via cities checked at most (best first) before giving up.
+};
+
+// One option returned by planAlternativeRoutes.
+struct AlternativeRoute {
+    RouteResult result;           // The route with its legs and totals.
+    double stretch = 0;           // Extra time over the fastest route, as a fraction of it.
+    double sharing = 0;           // Largest time shared with an option kept before it, as a fraction of the fastest time.
+};
+
+// Shortest-path tree of one start city on the speed-independent road cost.
+struct CostTree {
+    vector<double> cost;          // Cost from the start city to every city (INF if unreachable).
+    vector<int> parent;           // Previous city on the route from the start (-1 = none).
+    vector<int> parentRoad;       // Road index used to reach every city (-1 = none).
+    unsigned long long lastUse = 0; // Cache clock value of the latest query that used the tree.
+};
+
+// Turns a requested thread count into a real one (0 or less means "all cores").
+int resolveThreadCount(int threads) {
+    if (threads > 0) return threads;
+    return max(1, (int)thread::hardware_concurrency());
+}
+
+// Runs work(index, threadId) for every index in [0, count) on 'threads' threads, with
+// threadId < resolveThreadCount(threads). Indices are handed out one at a time, so uneven
+// work items balance themselves.
+template <typename Work>
+void parallelFor(int count, int threads, Work work) {
+    threads = max(1, min(resolveThreadCount(threads), count));
+    atomic<int> next(0);
+    auto worker = [&](int threadId) {
+        for (int i = next++; i < count; i = next++) work(i, threadId);
+    };
+    vector<thread> pool;
+    for (int t = 1; t < threads; t++) pool.emplace_back(worker, t);
+    worker(0); // The calling thread works too.
+    for (auto& t : pool) t.join();
+}
+
+// ==========================================
+//      VEHICLE PROFILES
+// ==========================================
+// Fuel model of one kind of vehicle. Efficiency (km/L) starts from a base value per road
+// type, drops by a fixed amount below 'lowSpeed' (engine outside its efficient range) and
+// quadratically above 'highSpeed' (air drag), never below 'minEfficiency'. The litres per
+// km of every (speed, road type) pair are computed once when the profile is built, so a
+// search costs the fuel of a road with one multiplication by a table entry.
+class VehicleProfile {
+public:
+    static constexpr int MAX_TABLE_SPEED = 300; // Faster speeds use this row (every curve is at its floor by then).
+
+private:
+    string name;                      // Name shown on receipts.
+    FuelType fuel;                    // Fuel burnt (sets the price).
+    double baseEfficiency[ROAD_TYPE_COUNT]; // km/L inside the efficient speed range, per road type.
+    double lowSpeed, lowSpeedPenalty; // Below lowSpeed km/h, efficiency drops by lowSpeedPenalty km/L.
+    double highSpeed, dragDivisor;    // Above highSpeed it drops by (excess speed)^2 / dragDivisor.
+    double minEfficiency;             // Lowest efficiency at any speed.
+    vector<double> perKm;             // Litres per km, ROAD_TYPE_COUNT entries per speed 0..MAX_TABLE_SPEED.
+
+    // The efficiency curve itself (only used to fill the table).
+    double curve(int speed, RoadType type) const {
+        double base = baseEfficiency[type];
+        if (speed > highSpeed) {
+            double excess = speed - highSpeed;
+            return max(minEfficiency, base - (excess * excess) / dragDivisor);
+        } else if (speed < lowSpeed) {
+            return base - lowSpeedPenalty;
+        }
+        return base;
+    }
+
+public:
+    VehicleProfile(const string& vehicleName, FuelType fuelType, double motorway, double highway, double local,
+                   double lowSpeedLimit, double lowPenalty, double highSpeedLimit, double drag, double floor)
+        : name(vehicleName), fuel(fuelType), lowSpeed(lowSpeedLimit), lowSpeedPenalty(lowPenalty),
+          highSpeed(highSpeedLimit), dragDivisor(drag), minEfficiency(floor) {
+        baseEfficiency[MOTORWAY] = motorway;
+        baseEfficiency[HIGHWAY] = highway;
+        baseEfficiency[LOCAL] = local;
+        perKm.resize((size_t)(MAX_TABLE_SPEED + 1) * ROAD_TYPE_COUNT);
+        for (int speed = 0; speed <= MAX_TABLE_SPEED; speed++) {
+            for (int t = 0; t < ROAD_TYPE_COUNT; t++) {
+                perKm[(size_t)speed * ROAD_TYPE_COUNT + t] = 1.0 / curve(speed, (RoadType)t);
+            }
+        }
+    }
+
+    // Litres per km on every road type at 'speed': index the result with an Edge's type.
+    const double* litresPerKm(int speed) const {
+        return &perKm[(size_t)max(0, min(speed, MAX_TABLE_SPEED)) * ROAD_TYPE_COUNT];
+    }
+
+    // Efficiency in km/L at 'speed' on a road type.
+    double efficiency(int speed, RoadType type) const { return 1.0 / litresPerKm(speed)[type]; }
+
+    const string& getName() const { return name; }
+    FuelType getFuel() const { return fuel; }
+    double getFuelPrice() const { return fuel == DIESEL ? PRICE_DIESEL : PRICE_PETROL; } // PKR per litre.
+};
+
+// Returns the built-in profile of a vehicle kind (built on first use, then shared).
+const VehicleProfile& getVehicleProfile(VehicleKind kind) {
+    static const VehicleProfile profiles[VEHICLE_KIND_COUNT] = {
+        //             name            fuel    motorway highway local  low speed/penalty  high speed/drag  floor
+        VehicleProfile("Petrol Car",   PETROL, 16.0,    16.0,   12.0,  40, 3.0,           90, 400,         5.0),
+        VehicleProfile("Diesel Truck", DIESEL, 4.5,     4.2,    3.0,   30, 0.8,           70, 1200,        1.5),
+        VehicleProfile("Bus",          DIESEL, 5.5,     5.2,    3.6,   30, 1.0,           80, 1000,        2.0)
+    };
+    return profiles[kind];
+}
+
+// Turns a vehicle name ("car", "truck" or "bus") into a VehicleKind. Returns false for an unknown name.
+bool parseVehicleName(const string& name, VehicleKind& kind) {
+    static const pair<const char*, VehicleKind> names[] = {{"car", PETROL_CAR}, {"truck", DIESEL_TRUCK}, {"bus", BUS}};
+    for (auto& entry : names) {
+        if (name == entry.first) { kind = entry.second; return true; }
+    }
+    return false;
+}
+
+// ==========================================
+//      MAPPED GRAPH STORAGE
+// ==========================================
+// Array that either owns its items (a vector) or views items stored elsewhere, such as a
+// memory-mapped graph file. Reads and in-place writes work the same either way; anything
+// that changes the size first copies a viewed array into its own vector.
+template <typename T>
+class GraphArray {
+private:
+    vector<T> owned;      // Items when the array owns them.
+    T* items = nullptr;   // First item (owned.data() or the viewed memory).
+    size_t count = 0;     // Number of items.
+
+    void refresh() { items = owned.data(); count = owned.size(); }
+    void own() { if (items != owned.data()) { owned.assign(items, items + count); refresh(); } }
+
+public:
+    GraphArray() {}
+    // Copies always own their items.
+    GraphArray(const GraphArray& other) : owned(other.begin(), other.end()) { refresh(); }
+    GraphArray& operator=(const GraphArray& other) {
+        if (this != &other) { owned.assign(other.begin(), other.end()); refresh(); }
+        return *this;
+    }
+
+    T& operator[](size_t i) { return items[i]; }
+    const T& operator[](size_t i) const { return items[i]; }
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    T* data() { return items; }
+    const T* data() const { return items; }
+    T* begin() { return items; }
+    T* end() { return items + count; }
+    const T* begin() const { return items; }
+    const T* end() const { return items + count; }
+
+    // Takes over the contents of 'other' (and hands back the old owned items).
+    void swap(vector<T>& other) { owned.swap(other); refresh(); }
+    void assign(size_t n, const T& value) { owned.assign(n, value); refresh(); }
+    void clear() { vector<T>().swap(owned); refresh(); }
+    void resize(size_t n, const T& value = T()) { own(); owned.resize(n, value); refresh(); }
+    void push_back(const T& value) { own(); owned.push_back(value); refresh(); }
+    void append(const T* first, const T* last) { own(); owned.insert(owned.end(), first, last); refresh(); }
+
+    // Views n items at 'memory' (which must outlive the view), dropping any owned items.
+    void view(T* memory, size_t n) { vector<T>().swap(owned); items = memory; count = n; }
+};
+
+// Table of strings packed into one character array: string i is chars[start[i]] ..
+// chars[start[i + 1] - 1]. Stored this way it can be mapped straight from a graph file.
+class NameTable {
+private:
+    GraphArray<unsigned> start; // Offset of every string, plus the end of the last one.
+    GraphArray<char> chars;     // All strings back to back (no terminators).
+
+public:
+    int size() const { return start.empty() ? 0 : (int)start.size() - 1; }
+    string operator[](int i) const { return string(chars.data() + start[i], start[i + 1] - start[i]); }
+
+    void push_back(const string& name) {
+        if (start.empty()) start.push_back(0);
+        chars.append(name.data(), name.data() + name.size());
+        start.push_back((unsigned)chars.size());
+    }
+
+    // Adds empty strings until the table holds n strings.
+    void resize(int n) { while (size() < n) push_back(""); }
+
+    // Replaces string i. Replacing the last string is cheap; any other one repacks the table.
+    void set(int i, const string& name) {
+        if (i == size() - 1) {
+            chars.resize(start[i]);
+            start.resize(i + 1);
+            push_back(name);
+            return;
+        }
+        NameTable packed;
+        for (int k = 0; k < size(); k++) packed.push_back(k == i ? name : (*this)[k]);
+        *this = packed;
+    }
+
+    GraphArray<unsigned>& starts() { return start; }
+    GraphArray<char>& characters() { return chars; }
+};
+
+// Read-only-on-disk mapping of a whole file. The mapping is private and writable: pages are
+// shared with every other process mapping the same file (one copy in the page cache) until
+// this process writes to one, e.g. a live traffic update, which then gets its own copy.
+// Without mmap (Windows) the file is read into memory instead.
+class MappedFile {
+private:
+    char* memory = nullptr;   // Start of the mapping.
+    size_t length = 0;        // Size of the file in bytes.
+#ifdef _WIN32
+    vector<double> buffer;    // File contents (double keeps 8-byte alignment).
+#endif
+
+public:
+    MappedFile() {}
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    ~MappedFile() { close(); }
+
+    char* data() { return memory; }
+    size_t size() const { return length; }
+
+    // Maps the file at 'path'. Returns false if it can't be opened or is empty.
+    bool open(const string& path) {
+        close();
+#ifdef _WIN32
+        ifstream in(path, ios::binary | ios::ate);
+        if (!in) return false;
+        length = (size_t)in.tellg();
+        buffer.assign(length / sizeof(double) + 1, 0);
+        in.seekg(0);
+        if (length == 0 || !in.read((char*)buffer.data(), length)) { length = 0; return false; }
+        memory = (char*)buffer.data();
+#else
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) return false;
+        struct stat info;
+        if (fstat(fd, &info) != 0 || info.st_size <= 0) { ::close(fd); return false; }
+        void* mapped = mmap(nullptr, (size_t)info.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+        ::close(fd);                  // The mapping stays valid without the descriptor.
+        if (mapped == MAP_FAILED) return false;
+        memory = (char*)mapped;
+        length = (size_t)info.st_size;
+#endif
+        return true;
+    }
+
+    void close() {
+#ifdef _WIN32
+        vector<double>().swap(buffer);
+#else
+        if (memory) munmap(memory, length);
+#endif
+        memory = nullptr;
+        length = 0;
+    }
+
+    void swap(MappedFile& other) {
+        std::swap(memory, other.memory);
+        std::swap(length, other.length);
+#ifdef _WIN32
+        buffer.swap(other.buffer);
+#endif
+    }
+};
+
+// Reader/writer lock that lets a waiting writer in first: once lock() is waiting, new
+// lock_shared() calls wait too, so a traffic update only waits for the queries already
+// running. (std::shared_mutex on glibc lets new readers in ahead of a waiting writer, and
+// an update could wait for seconds while several threads keep querying.) Works with
+// shared_lock and unique_lock. Not recursive: a thread holding it shared must not take it again.
+class WriterFirstMutex {
+private:
+    mutex state;                  // Guards the three counters below.
+    condition_variable readerGate; // Readers wait here while a writer is active or waiting.
+    condition_variable writerGate; // Writers wait here for the running readers to leave.
+    int readers = 0;              // Threads holding the lock shared.
+    int waitingWriters = 0;       // Threads waiting in lock().
+    bool writing = false;         // True while a writer holds the lock.
+
+public:
+    void lock_shared() {
+        unique_lock<mutex> guard(state);
+        readerGate.wait(guard, [&] { return !writing && waitingWriters == 0; });
+        readers++;
+    }
+
+    void unlock_shared() {
+        lock_guard<mutex> guard(state);
+        if (--readers == 0 && waitingWriters > 0) writerGate.notify_one();
+    }
+
+    void lock() {
+        unique_lock<mutex> guard(state);
+        waitingWriters++;
+        writerGate.wait(guard, [&] { return !writing && readers == 0; });
+        waitingWriters--;
+        writing = true;
+    }
+
+    void unlock() {
+        lock_guard<mutex> guard(state);
+        writing = false;
+        if (waitingWriters > 0) writerGate.notify_one(); // Queued updates go before new queries.
+        else readerGate.notify_all();
+    }
+};
+
+// Sections of a binary graph file, in file order.
+enum GraphSectionId {
+    SECTION_OFFSETS,          // edgeOffset: int x (cityCount + 2).
+    SECTION_EDGES,            // edges: Edge x roadCount.
+    SECTION_NAME_IDS,         // edgeNameId: int x roadCount.
+    SECTION_TWINS,            // twinRoad: int x roadCount.
+    SECTION_LATITUDES,        // cityLat: double x (cityCount + 1).
+    SECTION_LONGITUDES,       // cityLon: double x (cityCount + 1).
+    SECTION_CITY_NAME_STARTS, // City name table offsets: unsigned x (cityCount + 2).
+    SECTION_CITY_NAME_CHARS,  // City name characters.
+    SECTION_ROAD_NAME_STARTS, // Road name table offsets: unsigned x (names + 1).
+    SECTION_ROAD_NAME_CHARS,  // Road name characters.
+    SECTION_PROFILES,         // Traffic profile bytes: PROFILE_SLOTS per profile.
+    GRAPH_SECTION_COUNT
+};
+
+// Fixed header at the start of a binary graph file. All numbers are stored in the writer's
+// native layout; byteOrder and edgeBytes reject files from a machine that lays them out
+// differently. Every section starts on a 64-byte boundary so it can be used in place.
+struct GraphFileHeader {
+    char magic[8];            // "RPGRAPH" and a terminating zero.
+    unsigned version;         // GRAPH_FORMAT_VERSION of the writer.
+    unsigned byteOrder;       // 0x01020304 as the writer stored it.
+    unsigned edgeBytes;       // sizeof(Edge) of the writer.
+    unsigned profileSlots;    // PROFILE_SLOTS of the writer.
+    int cityCount;            // Highest city ID.
+    int reserved;             // Zero (keeps the fields below 8-byte aligned).
+    unsigned long long roadCount; // Number of directed roads.
+    double minEdgeCost;       // Smallest positive road cost (see RoutePlanner::minEdgeCost).
+    double maxEdgeCost;       // Largest road cost.
+    unsigned long long sectionOffset[GRAPH_SECTION_COUNT]; // Byte offset of every section.
+    unsigned long long sectionBytes[GRAPH_SECTION_COUNT];  // Byte length of every section.
+};
+
+// ==========================================
+//      CONTRACTION HIERARCHIES
+// ==========================================
+// Preprocessed speed-up structure for point-to-point queries. Cities are contracted one by
+// one in order of importance; whenever removing a city would break a shortest route between
+// two of its neighbours, a shortcut arc replacing the two roads is added. A query then only
+// walks "upward" (towards more important cities) from both ends.
+// Arc weights are clear-road-equivalent kilometres (distance x traffic multiplier). Every road
+// time is that weight x 60 / speed, so one hierarchy serves every driving speed.
+class ContractionHierarchy {
+private:
+    // Structure for one arc of the hierarchy: either an original road or a shortcut.
+    struct Arc {
+        int a, b;         // The two cities joined by the arc.
+        double weight;    // Clear-road-equivalent length of the arc.
+        int edgeAB;       // Original road index used from a to b (roads only).
+        int edgeBA;       // Original road index used from b to a (roads only).
+        int child1;       // Shortcuts only: arc joining a and the middle city.
+        int child2;       // Shortcuts only: arc joining the middle city and b.
+        int middle;       // Shortcuts only: the contracted city the shortcut skips (-1 for roads).
+        double km[ROAD_TYPE_COUNT]; // Kilometres of every road type the arc covers (for fuel).
+    };
+
+    // Structure for one arc of the upward search graph.
+    struct UpArc {
+        int target;       // The more important city at the other end.
+        double weight;    // Weight of the arc.
+        int arc;          // Index into the arcs array (used for unpacking).
+    };
+
+    static const int SIMULATE_SETTLE_LIMIT = 30;   // Witness search budget when only estimating a priority.
+    static const int CONTRACT_SETTLE_LIMIT = 200; // Witness search budget when really contracting.
+
+    int nodeCount;               // Number of cities (IDs 1..nodeCount).
+    atomic<bool> ready;          // True once build() has finished (read by queries without a lock).
+    vector<Arc> arcs;            // All roads and shortcuts.
+    vector<int> rank;            // Contraction order of every city (higher = more important).
+    vector<int> upOffset;        // CSR offsets of the upward graph.
+    vector<UpArc> upArcs;        // Arcs from every city to more important neighbours.
+
+    // Scratch space of one point-to-point query; only the touched entries are reset after each query.
+    struct QuerySpace {
+        vector<double> dist[2];  // Upward distance from the start [0] / destination [1].
+        vector<int> viaArc[2];   // Arc used to reach every city on each side.
+        vector<int> touched[2];  // Cities whose entries must be reset.
+    };
+
+    // Reusable contraction state.
+    vector<vector<int>> nbr;     // Arcs of every not yet contracted city.
+    vector<char> contracted;     // Whether a city has already been contracted.
+    vector<double> witnessDist;  // Distances of the local witness search.
+    vector<int> witnessTouched;  // Cities touched by the witness search.
+    vector<PqNode> witnessHeap;  // Binary heap of the witness search.
+    vector<int> neighbourArc;    // Cheapest arc from the city being contracted to each neighbour.
+    vector<int> level;           // Depth of every city in the hierarchy built so far.
+
+    // Returns the city at the other end of an arc.
+    int otherEnd(const Arc& arc, int from) const { return arc.a == from ? arc.b : arc.a; }
+
+    // Local Dijkstra from 'source' that ignores city 'skip' and stops after 'limit' is
+    // exceeded or 'maxSettled' cities are settled. Leaves distances in witnessDist.
+    // The heap lives in witnessHeap so its buffer is reused by every search.
+    void witnessSearch(int source, int skip, double limit, int maxSettled) {
+        for (int x : witnessTouched) witnessDist[x] = INF;
+        witnessTouched.clear();
+        witnessHeap.clear();
+        witnessDist[source] = 0;
+        witnessTouched.push_back(source);
+        witnessHeap.push_back({source, 0});
+        int settled = 0;
+        while (!witnessHeap.empty()) {
+            pop_heap(witnessHeap.begin(), witnessHeap.end(), greater<PqNode>());
+            PqNode top = witnessHeap.back();
+            witnessHeap.pop_back();
+            if (top.timeCost > witnessDist[top.id]) continue;
+            if (top.timeCost > limit || ++settled > maxSettled) break; // Gives up: a shortcut is assumed necessary.
+            for (int id : nbr[top.id]) {
+                int x = otherEnd(arcs[id], top.id);
+                if (x == skip) continue;
+                double d = top.timeCost + arcs[id].weight;
+                if (d < witnessDist[x]) {
+                    if (witnessDist[x] == INF) witnessTouched.push_back(x);
+                    witnessDist[x] = d;
+                    witnessHeap.push_back({x, d});
+                    push_heap(witnessHeap.begin(), witnessHeap.end(), greater<PqNode>());
+                }
+            }
+        }
+    }
+
+    // Contracts city v (or, when simulate is true, only counts what it would do).
+    // Returns the number of shortcuts needed; also reports how many neighbours v has.
+    int contractNode(int v, bool simulate, int& degree) {
+        // Keeps only the cheapest arc to every neighbour.
+        vector<int> neighbours;
+        for (int id : nbr[v]) {
+            int u = otherEnd(arcs[id], v);
+            if (neighbourArc[u] == -1) neighbours.push_back(u), neighbourArc[u] = id;
+            else if (arcs[id].weight < arcs[neighbourArc[u]].weight) neighbourArc[u] = id;
+        }
+        degree = (int)neighbours.size();
+
+        int shortcuts = 0;
+        for (size_t i = 0; i < neighbours.size(); i++) {
+            int u = neighbours[i];
+            double toV = arcs[neighbourArc[u]].weight;
+            double limit = 0; // Longest route through v that a witness must beat.
+            for (size_t j = i + 1; j < neighbours.size(); j++) limit = max(limit, toV + arcs[neighbourArc[neighbours[j]]].weight);
+            if (limit == 0) continue;
+            witnessSearch(u, v, limit, simulate ? SIMULATE_SETTLE_LIMIT : CONTRACT_SETTLE_LIMIT);
+            for (size_t j = i + 1; j < neighbours.size(); j++) {
+                int w = neighbours[j];
+                double via = toV + arcs[neighbourArc[w]].weight;
+                if (witnessDist[w] <= via) continue; // A route avoiding v is just as short.
+                shortcuts++;
+                if (simulate) continue;
+                // Adds the shortcut u - w that replaces u - v - w.
+                const Arc& left = arcs[neighbourArc[u]];
+                const Arc& right = arcs[neighbourArc[w]];
+                Arc shortcut = {u, w, via, -1, -1, neighbourArc[u], neighbourArc[w], v, {0, 0, 0}};
+                for (int t = 0; t < ROAD_TYPE_COUNT; t++) shortcut.km[t] = left.km[t] + right.km[t];
+                arcs.push_back(shortcut);
+                nbr[u].push_back((int)arcs.size() - 1);
+                nbr[w].push_back((int)arcs.size() - 1);
+            }
+        }
+        for (int u : neighbours) neighbourArc[u] = -1; // Resets the scratch array.
+        return shortcuts;
+    }
+
+    // Priority of a city: contract cities that add few shortcuts, whose neighbours have not
+    // been contracted yet and that sit low in the hierarchy first, so it stays flat and balanced.
+    int computePriority(int v, const vector<int>& deletedNeighbours) {
+        int degree;
+        int shortcuts = contractNode(v, true, degree);
+        return 2 * (shortcuts - degree) + deletedNeighbours[v] + level[v];
+    }
+
+    // Appends the original roads of an arc, walked starting at city 'from', to route/roads.
+    void unpackArc(int id, int from, vector<int>& route, vector<int>& roads) const {
+        const Arc& arc = arcs[id];
+        if (arc.middle == -1) {
+            roads.push_back(from == arc.a ? arc.edgeAB : arc.edgeBA);
+            route.push_back(otherEnd(arc, from));
+        } else if (from == arc.a) {
+            unpackArc(arc.child1, arc.a, route, roads);
+            unpackArc(arc.child2, arc.middle, route, roads);
+        } else {
+            unpackArc(arc.child2, arc.b, route, roads);
+            unpackArc(arc.child1, arc.middle, route, roads);
+        }
+    }
+
+public:
+    // Structure for one city reached by an upward search (used by the many-to-many matrix).
+    struct UpwardEntry {
+        int node;                   // The city reached.
+        double weight;              // Upward cost from the search origin.
+        double km[ROAD_TYPE_COUNT]; // Kilometres of every road type along that upward route.
+    };
+
+    // Per-thread scratch space for upwardSearch, so many searches can run at once.
+    struct UpwardWorkspace {
+        vector<double> dist;        // Upward cost of every city (INF if untouched).
+        vector<int> viaArc;         // Arc used to reach every city.
+        vector<int> entryOf;        // Position of every settled city in the 'reached' list.
+        vector<int> touched;        // Cities to reset before the next search.
+        vector<PqNode> heap;        // Binary heap buffer.
+    };
+
+    // Constructor: starts empty; build() must run before queries.
+    ContractionHierarchy() {
+        nodeCount = 0;
+        ready = false;
+    }
+
+    // Returns true if the hierarchy matches the current graph.
+    bool isReady() const { return ready; }
+
+    // Drops the hierarchy (called whenever the road network changes).
+    void clear() {
+        ready = false;
+        vector<Arc>().swap(arcs);
+        vector<UpArc>().swap(upArcs);
+    }
+
+    // Returns how many shortcut arcs the preprocessing added.
+    int getShortcutCount() const {
+        int count = 0;
+        for (auto& arc : arcs) if (arc.middle != -1) count++;
+        return count;
+    }
+
+    // Offline preprocessing: orders the cities, contracts them and builds the upward graph.
+    // edgeCost[i] is the weight of road i of the CSR graph given by offset/edges.
+    void build(int cityCount, const GraphArray<int>& offset, const GraphArray<Edge>& edges, const vector<double>& edgeCost) {
+        clear();
+        nodeCount = cityCount;
+        nbr.assign(nodeCount + 1, vector<int>());
+        contracted.assign(nodeCount + 1, 0);
+        witnessDist.assign(nodeCount + 1, INF);
+        witnessTouched.clear();
+        neighbourArc.assign(nodeCount + 1, -1);
+        rank.assign(nodeCount + 1, 0);
+        level.assign(nodeCount + 1, 0);
+
+        // 1. One arc per pair of neighbouring cities, keeping the cheapest road each way.
+        //    Ties keep the first road, exactly like the strict '<' of the Dijkstra relaxation.
+        unordered_map<long long, int> pairArc;
+        pairArc.reserve(edges.size());
+        for (int u = 1; u <= nodeCount; u++) {
+            for (int i = offset[u]; i < offset[u + 1]; i++) {
+                int v = edges[i].destination;
+                if (v == u) continue; // A loop never helps a shortest route.
+                int a = min(u, v), b = max(u, v);
+                long long key = (long long)a * (nodeCount + 1) + b;
+                auto found = pairArc.find(key);
+                if (found == pairArc.end()) {
+                    found = pairArc.emplace(key, (int)arcs.size()).first;
+                    arcs.push_back({a, b, INF, -1, -1, -1, -1, -1, {0, 0, 0}});
+                    nbr[a].push_back(found->second);
+                    nbr[b].push_back(found->second);
+                }
+                Arc& arc = arcs[found->second];
+                int& myEdge = (u == a) ? arc.edgeAB : arc.edgeBA;
+                if (edgeCost[i] < arc.weight) {
+                    arc.weight = edgeCost[i];    // Cheaper parallel road: start over for both directions.
+                    arc.edgeAB = arc.edgeBA = -1;
+                    myEdge = i;
+                    for (int t = 0; t < ROAD_TYPE_COUNT; t++) arc.km[t] = 0;
+                    arc.km[edges[i].type] = edges[i].distanceKM;
+                } else if (edgeCost[i] == arc.weight && myEdge == -1) {
+                    myEdge = i;
+                }
+            }
+        }
+
+        // 2. Node ordering with lazy priority updates.
+        vector<int> deletedNeighbours(nodeCount + 1, 0);
+        vector<int> priority(nodeCount + 1, 0);
+        priority_queue<pair<int, int>, vector<pair<int, int>>, greater<pair<int, int>>> order;
+        for (int v = 1; v <= nodeCount; v++) {
+            priority[v] = computePriority(v, deletedNeighbours);
+            order.push({priority[v], v});
+        }
+
+        // 3. Contraction.
+        int nextRank = 0;
+        while (!order.empty()) {
+            int v = order.top().second;
+            int prio = order.top().first;
+            order.pop();
+            if (contracted[v] || prio != priority[v]) continue; // Outdated entry.
+            int fresh = computePriority(v, deletedNeighbours);
+            if (!order.empty() && fresh > order.top().first) { // Became less attractive: retry later.
+                priority[v] = fresh;
+                order.push({fresh, v});
+                continue;
+            }
+
+            int degree;
+            contractNode(v, false, degree);
+            contracted[v] = 1;
+            rank[v] = nextRank++;
+
+            // Removes v from its neighbours' lists and refreshes their priorities.
+            vector<int> touchedNeighbours;
+            for (int id : nbr[v]) {
+                int u = otherEnd(arcs[id], v);
+                auto& list = nbr[u];
+                list.erase(remove(list.begin(), list.end(), id), list.end());
+                // neighbourArc doubles as a "seen" flag so parallel arcs count each neighbour once.
+                if (neighbourArc[u] == -1) { neighbourArc[u] = 0; touchedNeighbours.push_back(u); deletedNeighbours[u]++; }
+                level[u] = max(level[u], level[v] + 1);
+            }
+            vector<int>().swap(nbr[v]);
+            for (int u : touchedNeighbours) {
+                neighbourArc[u] = -1;
+                priority[u] = computePriority(u, deletedNeighbours);
+                order.push({priority[u], u});
+            }
+        }
+
+        // 4. Upward graph: every arc is stored at its less important end.
+        upOffset.assign(nodeCount + 2, 0);
+        for (auto& arc : arcs) upOffset[(rank[arc.a] < rank[arc.b] ? arc.a : arc.b) + 1]++;
+        for (int v = 0; v <= nodeCount; v++) upOffset[v + 1] += upOffset[v];
+        upArcs.assign(arcs.size(), UpArc());
+        vector<int> cursor(upOffset.begin(), upOffset.end() - 1);
+        for (int id = 0; id < (int)arcs.size(); id++) {
+            const Arc& arc = arcs[id];
+            int low = rank[arc.a] < rank[arc.b] ? arc.a : arc.b;
+            upArcs[cursor[low]++] = {otherEnd(arc, low), arc.weight, id};
+        }
+
+        // Frees contraction scratch space and prepares the query arrays.
+        vector<vector<int>>().swap(nbr);
+        vector<double>().swap(witnessDist);
+        vector<char>().swap(contracted);
+        ready = true;
+    }
+
+    // Prepares a workspace for upwardSearch on this hierarchy.
+    void initWorkspace(UpwardWorkspace& space) const {
+        space.dist.assign(nodeCount + 1, INF);
+        space.viaArc.assign(nodeCount + 1, -1);
+        space.entryOf.assign(nodeCount + 1, -1);
+        space.touched.clear();
+        space.heap.clear();
+    }
+
+    // Complete upward search (with stall-on-demand) from 'source'. Lists every city it
+    // settles without stalling, with the cost and per-road-type kilometres of the route there.
+    // Only reads the hierarchy, so several threads may call it with their own workspaces.
+    void upwardSearch(int source, UpwardWorkspace& space, vector<UpwardEntry>& reached) const {
+        for (int x : space.touched) { space.dist[x] = INF; space.viaArc[x] = -1; }
+        space.touched.clear();
+        space.heap.clear();
+        reached.clear();
+        space.dist[source] = 0;
+        space.touched.push_back(source);
+        space.heap.push_back({source, 0});
+        while (!space.heap.empty()) {
+            pop_heap(space.heap.begin(), space.heap.end(), greater<PqNode>());
+            PqNode top = space.heap.back();
+            space.heap.pop_back();
+            int u = top.id;
+            if (top.timeCost > space.dist[u]) continue;
+            bool stalled = false;
+            for (int i = upOffset[u]; i < upOffset[u + 1] && !stalled; i++) {
+                stalled = space.dist[upArcs[i].target] + upArcs[i].weight < top.timeCost;
+            }
+            if (stalled) continue;
+
+            // Kilometres per road type: the parent's entry plus the arc used to get here.
+            UpwardEntry entry = {u, top.timeCost, {0, 0, 0}};
+            // The parent relaxed this arc, so it was settled without stalling and is already listed.
+            if (space.viaArc[u] != -1) {
+                const Arc& arc = arcs[space.viaArc[u]];
+                const UpwardEntry& from = reached[space.entryOf[otherEnd(arc, u)]];
+                for (int t = 0; t < ROAD_TYPE_COUNT; t++) entry.km[t] = from.km[t] + arc.km[t];
+            }
+            space.entryOf[u] = (int)reached.size();
+            reached.push_back(entry);
+
+            for (int i = upOffset[u]; i < upOffset[u + 1]; i++) {
+                const UpArc& up = upArcs[i];
+                double d = top.timeCost + up.weight;
+                if (d < space.dist[up.target]) {
+                    if (space.dist[up.target] == INF) space.touched.push_back(up.target);
+                    space.dist[up.target] = d;
+                    space.viaArc[up.target] = up.arc;
+                    space.heap.push_back({up.target, d});
+                    push_heap(space.heap.begin(), space.heap.end(), greater<PqNode>());
+                }
+            }
+        }
+    }
+
+    // Returns the query scratch space of the calling thread, sized for this hierarchy.
+    QuerySpace& threadQuery() const {
+        static thread_local QuerySpace space;
+        for (int side = 0; side < 2; side++) {
+            if ((int)space.dist[side].size() < nodeCount + 1) {
+                space.dist[side].assign(nodeCount + 1, INF);
+                space.viaArc[side].assign(nodeCount + 1, -1);
+                space.touched[side].clear();
+            }
+        }
+        return space;
+    }
+
+    // Upward/downward bidirectional query. On success fills route (cities in travel order)
+    // and roads (original road index of every leg) with all shortcuts unpacked. Only reads
+    // the hierarchy (the search state is per thread), so several threads may query at once.
+    bool query(int startNode, int endNode, vector<int>& route, vector<int>& roads, SearchStats& stats) const {
+        route.clear();
+        roads.clear();
+        QuerySpace& space = threadQuery();
+        vector<double>* dist = space.dist;
+        vector<int>* viaArc = space.viaArc;
+        vector<int>* touched = space.touched;
+        for (int side = 0; side < 2; side++) {
+            for (int x : touched[side]) { dist[side][x] = INF; viaArc[side][x] = -1; }
+            touched[side].clear();
+        }
+
+        priority_queue<PqNode, vector<PqNode>, greater<PqNode>> pq[2];
+        dist[0][startNode] = 0; touched[0].push_back(startNode); pq[0].push({startNode, 0});
+        dist[1][endNode] = 0;   touched[1].push_back(endNode);   pq[1].push({endNode, 0});
+        METRIC(stats.heapPushes += 2);
+        double best = INF;
+        int meet = -1;
+
+        while (!pq[0].empty() || !pq[1].empty()) {
+            // Expands the side whose next city is closer.
+            int side;
+            if (pq[0].empty()) side = 1;
+            else if (pq[1].empty()) side = 0;
+            else side = (pq[0].top().timeCost <= pq[1].top().timeCost) ? 0 : 1;
+
+            int u = pq[side].top().id;
+            double key = pq[side].top().timeCost;
+            pq[side].pop();
+            if (key > dist[side][u]) { METRIC(stats.stalePops++); continue; } // Stale entry.
+            if (key >= best) { pq[side] = {}; continue; }       // This side cannot improve the best route.
+            stats.settledNodes++;
+
+            if (dist[1 - side][u] < INF && key + dist[1 - side][u] < best) {
+                best = key + dist[1 - side][u];
+                meet = u;
+            }
+            // Stall-on-demand: roads are two-way, so an upward arc of u also leads down into u.
+            // If a more important city already reaches u more cheaply, u is not on a shortest
+            // upward route and its arcs need not be expanded.
+            bool stalled = false;
+            for (int i = upOffset[u]; i < upOffset[u + 1] && !stalled; i++) {
+                stalled = dist[side][upArcs[i].target] + upArcs[i].weight < key;
+            }
+            if (stalled) continue;
+            for (int i = upOffset[u]; i < upOffset[u + 1]; i++) {
+                const UpArc& up = upArcs[i];
+                stats.relaxedEdges++;
+                double d = key + up.weight;
+                if (d < dist[side][up.target]) {
+                    if (dist[side][up.target] == INF) touched[side].push_back(up.target);
+                    dist[side][up.target] = d;
+                    viaArc[side][up.target] = up.arc;
+                    pq[side].push({up.target, d});
+                    METRIC(stats.heapPushes++);
+                }
+            }
+        }
+        if (meet == -1) return false;
+
+        // Arcs from the start up to the meeting city, then from there down to the destination.
+        vector<int> upward;
+        for (int v = meet; v != startNode; v = otherEnd(arcs[viaArc[0][v]], v)) upward.push_back(viaArc[0][v]);
+        route.push_back(startNode);
+        int at = startNode;
+        for (int k = (int)upward.size() - 1; k >= 0; k--) {
+            unpackArc(upward[k], at, route, roads);
+            at = route.back();
+        }
+        for (int v = meet; v != endNode; ) {
+            int id = viaArc[1][v];
+            unpackArc(id, v, route, roads);
+            v = otherEnd(arcs[id], v);
+        }
+        return true;
+    }
+};
+
+// ==========================================
+//      CUSTOMIZABLE ROUTE PLANNING
+// ==========================================
+// Multi-level partition overlay (CRP). Preprocessing has two phases:
+//  1. Partitioning (metric-independent, depends only on the road layout): the cities are
+//     split into nested cells by recursive bisection, level 0 being the smallest cells.
+//     A boundary city of a level has a road to a city in another cell of that level.
+//  2. Customization (depends on the road costs): for every cell, the cost between each
+//     pair of its boundary cities without leaving the cell is stored in a small matrix
+//     (a clique). Level 0 cells are searched on the roads; higher cells on the cliques of
+//     their subcells. Cells of one level are independent, so they are customized in
+//     parallel, and a traffic change only re-customizes the cells that contain the road.
+// A query runs Dijkstra on the roads near the start and destination and on ever coarser
+// cliques further away. Costs are clear-road-equivalent kilometres, so one customization
+// serves every driving speed; only traffic changes need a new one.
+class PartitionOverlay {
+private:
+    // One cell of one level.
+    struct Cell {
+        vector<int> boundary;       // Boundary cities of the cell.
+        size_t clique;              // Start of the boundary x boundary cost matrix in the level's clique array.
+    };
+
+    // Scratch space of one cell search.
+    struct CellSearch {
+        vector<double> dist;        // Cost from the search origin (INF if untouched).
+        vector<int> parent;         // Previous city (-1 = none).
+        vector<int> parentRoad;     // Road used from parent (-1 = a clique arc of the level below).
+        vector<int> touched;        // Cities to reset before the next search.
+        vector<PqNode> heap;        // Binary heap buffer.
+    };
+
+    int nodeCount;                  // Number of cities (IDs 1..nodeCount).
+    bool partitioned;               // True once the cells are built.
+    atomic<bool> ready;             // True once partitioned and customized (read by queries without a lock).
+    vector<int> cellSize;           // Largest cell of every level.
+    vector<vector<int>> cellOf;     // cellOf[l][v]: cell of city v at level l.
+    vector<vector<int>> slotOf;     // slotOf[l][v]: position of v in its cell's boundary list (-1 = inside).
+    vector<vector<Cell>> cells;     // Cells of every level.
+    vector<vector<double>> cliques; // Boundary-to-boundary costs of every level, cell after cell.
+
+    // Splits order[first, last) into pieces of at most 'limit' cities by recursive bisection
+    // at the median of the wider coordinate.
+    void bisect(vector<int>& order, int first, int last, int limit, const vector<double>& x,
+                const vector<double>& y, vector<pair<int, int>>& pieces) {
+        if (last - first <= limit) {
+            pieces.push_back({first, last});
+            return;
+        }
+        double minX = INF, maxX = -INF, minY = INF, maxY = -INF;
+        for (int i = first; i < last; i++) {
+            minX = min(minX, x[order[i]]); maxX = max(maxX, x[order[i]]);
+            minY = min(minY, y[order[i]]); maxY = max(maxY, y[order[i]]);
+        }
+        const vector<double>& key = (maxX - minX >= maxY - minY) ? x : y;
+        int middle = first + (last - first) / 2;
+        nth_element(order.begin() + first, order.begin() + middle, order.begin() + last,
+                    [&](int a, int b) { return key[a] < key[b] || (key[a] == key[b] && a < b); });
+        bisect(order, first, middle, limit, x, y, pieces);
+        bisect(order, middle, last, limit, x, y, pieces);
+    }
+
+    // Splits one cell of level 'level' + 1 (or the whole map) into cells of every level below.
+    void splitCell(vector<int>& order, int first, int last, int level, const vector<double>& x, const vector<double>& y) {
+        vector<pair<int, int>> pieces;
+        bisect(order, first, last, cellSize[level], x, y, pieces);
+        for (auto& piece : pieces) {
+            int id = (int)cells[level].size();
+            cells[level].push_back(Cell());
+            for (int i = piece.first; i < piece.second; i++) cellOf[level][order[i]] = id;
+            if (level > 0) splitCell(order, piece.first, piece.second, level - 1, x, y);
+        }
+    }
+
+    // Hop distance from 'source' to every city (a large value if unreachable), following roads
+    // in both directions. Returns the farthest reached city.
+    int hopDistances(int source, const GraphArray<int>& offset, const GraphArray<Edge>& edges,
+                     const vector<vector<int>>& incoming, vector<double>& hops) {
+        hops.assign(nodeCount + 1, 1e9);
+        vector<int> queue(1, source);
+        hops[source] = 0;
+        for (size_t head = 0; head < queue.size(); head++) {
+            int u = queue[head];
+            auto visit = [&](int v) {
+                if (hops[v] > hops[u] + 1) { hops[v] = hops[u] + 1; queue.push_back(v); }
+            };
+            for (int i = offset[u]; i < offset[u + 1]; i++) visit(edges[i].destination);
+            for (int v : incoming[u]) visit(v);
+        }
+        return queue.back();
+    }
+
+    // Dijkstra from 'source' inside cell 'cell' of 'level': on the roads for level 0, on the
+    // subcell cliques and the roads between subcells above. Stops early once 'stop' is settled.
+    void searchCell(int level, int cell, int source, int stop, const GraphArray<int>& offset,
+                    const GraphArray<Edge>& edges, CellSearch& space, SearchStats* stats) const {
+        for (int v : space.touched) { space.dist[v] = INF; space.parent[v] = -1; space.parentRoad[v] = -1; }
+        space.touched.clear();
+        space.heap.clear();
+        auto relax = [&](int v, double cost, int from, int road) {
+            if (cost < space.dist[v]) {
+                if (space.dist[v] == INF) space.touched.push_back(v);
+                space.dist[v] = cost;
+                space.parent[v] = from;
+                space.parentRoad[v] = road;
+                space.heap.push_back({v, cost});
+                push_heap(space.heap.begin(), space.heap.end(), greater<PqNode>());
+            }
+        };
+        relax(source, 0, -1, -1);
+        const vector<int>& cellHere = cellOf[level];
+        while (!space.heap.empty()) {
+            pop_heap(space.heap.begin(), space.heap.end(), greater<PqNode>());
+            PqNode top = space.heap.back();
+            space.heap.pop_back();
+            int u = top.id;
+            if (top.timeCost > space.dist[u]) continue;
+            if (stats) stats->settledNodes++;
+            if (u == stop) return;
+            if (level == 0) {
+                for (int i = offset[u]; i < offset[u + 1]; i++) {
+                    int v = edges[i].destination;
+                    if (stats) stats->relaxedEdges++;
+                    if (cellHere[v] == cell) relax(v, top.timeCost + edges[i].cost, u, i);
+                }
+                continue;
+            }
+            int sub = cellOf[level - 1][u];
+            const Cell& subCell = cells[level - 1][sub];
+            size_t k = subCell.boundary.size();
+            const double* row = &cliques[level - 1][subCell.clique + (size_t)slotOf[level - 1][u] * k];
+            for (size_t j = 0; j < k; j++) {
+                if (stats) stats->relaxedEdges++;
+                if (row[j] < INF) relax(subCell.boundary[j], top.timeCost + row[j], u, -1);
+            }
+            for (int i = offset[u]; i < offset[u + 1]; i++) {
+                int v = edges[i].destination;
+                if (stats) stats->relaxedEdges++;
+                if (cellHere[v] == cell && cellOf[level - 1][v] != sub) relax(v, top.timeCost + edges[i].cost, u, i);
+            }
+        }
+    }
+
+    // Fills the clique of one cell, one row per boundary city, the rows spread over
+    // 'threads' threads. Returns true if any value changed.
+    bool customizeCell(int level, int cell, const GraphArray<int>& offset, const GraphArray<Edge>& edges, int threads) {
+        Cell& c = cells[level][cell];
+        size_t k = c.boundary.size();
+        vector<char> rowChanged(k, 0);
+        parallelFor((int)k, threads, [&](int i, int) {
+            CellSearch& space = threadSearch();
+            searchCell(level, cell, c.boundary[i], -1, offset, edges, space, nullptr);
+            double* row = &cliques[level][c.clique + (size_t)i * k];
+            for (size_t j = 0; j < k; j++) {
+                double cost = space.dist[c.boundary[j]];
+                if (row[j] != cost) { row[j] = cost; rowChanged[i] = 1; }
+            }
+        });
+        for (char changed : rowChanged) if (changed) return true;
+        return false;
+    }
+
+    // Returns a scratch space sized for this map (one per thread).
+    CellSearch& threadSearch() const {
+        static thread_local CellSearch space;
+        if ((int)space.dist.size() < nodeCount + 1) {
+            space.dist.assign(nodeCount + 1, INF);
+            space.parent.assign(nodeCount + 1, -1);
+            space.parentRoad.assign(nodeCount + 1, -1);
+            space.touched.clear();
+        }
+        return space;
+    }
+
+    // Appends the roads of the cheapest route from a to b inside cell 'cell' of 'level'.
+    void unpack(int level, int cell, int a, int b, const GraphArray<int>& offset, const GraphArray<Edge>& edges,
+                vector<int>& roads) const {
+        CellSearch& space = threadSearch();
+        searchCell(level, cell, a, b, offset, edges, space, nullptr);
+        vector<pair<int, int>> steps; // (city, road or -1 for a clique arc) walking back from b.
+        for (int v = b; v != a; v = space.parent[v]) steps.push_back({v, space.parentRoad[v]});
+        vector<int> from;
+        for (int v = b; v != a; v = space.parent[v]) from.push_back(space.parent[v]);
+        for (int s = (int)steps.size() - 1; s >= 0; s--) {
+            if (steps[s].second >= 0) roads.push_back(steps[s].second);
+            else unpack(level - 1, cellOf[level - 1][from[s]], from[s], steps[s].first, offset, edges, roads);
+        }
+    }
+
+    // Level of the cliques to use from city v: the highest level at which v is in neither the
+    // start's nor the destination's cell, plus one (0 = use the roads).
+    int queryLevel(int v, int s, int t) const {
+        for (int l = (int)cellSize.size() - 1; l >= 0; l--) {
+            if (cellOf[l][v] != cellOf[l][s] && cellOf[l][v] != cellOf[l][t]) return l + 1;
+        }
+        return 0;
+    }
+
+public:
+    PartitionOverlay() {
+        nodeCount = 0;
+        partitioned = false;
+        ready = false;
+    }
+
+    // Returns true if the cells match the current graph.
+    bool isPartitioned() const { return partitioned; }
+
+    // Returns true if the overlay matches the current graph and costs.
+    bool isReady() const { return ready; }
+
+    // Drops the overlay (called whenever the road network changes).
+    void clear() {
+        partitioned = false;
+        ready = false;
+        cellSize.clear();
+        cellOf.clear();
+        slotOf.clear();
+        cells.clear();
+        cliques.clear();
+    }
+
+    int getLevelCount() const { return (int)cellSize.size(); }
+    int getCellCount(int level) const { return (int)cells[level].size(); }
+    long long getBoundaryCount(int level) const {
+        long long count = 0;
+        for (auto& c : cells[level]) count += c.boundary.size();
+        return count;
+    }
+
+    // Phase 1: builds the nested cells. 'sizes' gives the largest cell of every level from
+    // the bottom up; empty means cells of up to 128 cities, eight times larger per level, as
+    // long as a level still has several cells. Cities are split by their coordinates, or by
+    // hop distances from two far-apart cities when any coordinate is missing.
+    void partition(int cityCount, const GraphArray<int>& offset, const GraphArray<Edge>& edges,
+                   const GraphArray<double>& lat, const GraphArray<double>& lon, vector<int> sizes = vector<int>()) {
+        clear();
+        nodeCount = cityCount;
+        if (sizes.empty()) {
+            for (int size = max(2, min(128, nodeCount / 8)); size < nodeCount; size *= 8) sizes.push_back(size);
+        }
+        cellSize = sizes;
+        int levels = (int)cellSize.size();
+        vector<double> x(nodeCount + 1, 0), y(nodeCount + 1, 0);
+        bool located = true;
+        for (int v = 1; v <= nodeCount; v++) {
+            if (std::isnan(lat[v]) || std::isnan(lon[v])) { located = false; break; }
+            x[v] = lon[v] * cos(lat[v] * M_PI / 180.0); // Equal-area-ish so both axes compare.
+            y[v] = lat[v];
+        }
+        if (!located && nodeCount > 0) {
+            vector<vector<int>> incoming(nodeCount + 1);
+            for (int u = 1; u <= nodeCount; u++) {
+                for (int i = offset[u]; i < offset[u + 1]; i++) incoming[edges[i].destination].push_back(u);
+            }
+            int far = hopDistances(1, offset, edges, incoming, x);
+            int other = hopDistances(far, offset, edges, incoming, x);
+            hopDistances(other, offset, edges, incoming, y);
+        }
+
+        cellOf.assign(levels, vector<int>(nodeCount + 1, -1));
+        slotOf.assign(levels, vector<int>(nodeCount + 1, -1));
+        cells.assign(levels, vector<Cell>());
+        cliques.assign(levels, vector<double>());
+        partitioned = true;
+        if (levels == 0) return;
+        vector<int> order;
+        for (int v = 1; v <= nodeCount; v++) order.push_back(v);
+        splitCell(order, 0, nodeCount, levels - 1, x, y);
+
+        // Boundary cities: either end of a road between two cells of a level.
+        for (int u = 1; u <= nodeCount; u++) {
+            for (int i = offset[u]; i < offset[u + 1]; i++) {
+                int v = edges[i].destination;
+                for (int l = 0; l < levels && cellOf[l][u] != cellOf[l][v]; l++) {
+                    for (int w : {u, v}) {
+                        if (slotOf[l][w] != -1) continue;
+                        Cell& c = cells[l][cellOf[l][w]];
+                        slotOf[l][w] = (int)c.boundary.size();
+                        c.boundary.push_back(w);
+                    }
+                }
+            }
+        }
+        for (int l = 0; l < levels; l++) {
+            size_t total = 0;
+            for (Cell& c : cells[l]) {
+                c.clique = total;
+                total += c.boundary.size() * c.boundary.size();
+            }
+            cliques[l].assign(total, INF);
+        }
+    }
+
+    // Phase 2: computes every clique from the current road costs, level by level, with the
+    // cells of a level spread over 'threads' threads (0 = all cores).
+    void customize(const GraphArray<int>& offset, const GraphArray<Edge>& edges, int threads = 0) {
+        for (int l = 0; l < getLevelCount(); l++) {
+            parallelFor((int)cells[l].size(), threads, [&](int cell, int) {
+                customizeCell(l, cell, offset, edges, 1);
+            });
+        }
+        ready = true;
+    }
+
+    // Re-customizes only the cells whose cliques can use the road from u to v: at every
+    // level, the cell containing both ends (if any). Roads between cells are read directly
+    // by the queries and need nothing. Once a cell's clique comes out unchanged, the cells
+    // above it can't change either and are skipped.
+    void customizeRoad(int u, int v, const GraphArray<int>& offset, const GraphArray<Edge>& edges, int threads = 0) {
+        if (!ready) return;
+        bool dirty = true; // Whether the level below (or the road itself) changed.
+        for (int l = 0; l < getLevelCount() && dirty; l++) {
+            if (cellOf[l][u] != cellOf[l][v]) continue; // Still a road between cells.
+            dirty = customizeCell(l, cellOf[l][u], offset, edges, threads);
+        }
+    }
+
+    // Point-to-point query. Fills the cities and roads of the route; returns false if t
+    // can't be reached.
+    bool query(int s, int t, const GraphArray<int>& offset, const GraphArray<Edge>& edges,
+               vector<int>& route, vector<int>& roads, SearchStats& stats) const {
+        route.clear();
+        roads.clear();
+        CellSearch& space = threadSearch();
+        for (int v : space.touched) { space.dist[v] = INF; space.parent[v] = -1; space.parentRoad[v] = -1; }
+        space.touched.clear();
+        space.heap.clear();
+        // parentRoad >= 0: reached by that road; otherwise by the clique of level -parentRoad - 2
+        // in the parent's cell.
+        auto relax = [&](int v, double cost, int from, int via) {
+            if (cost < space.dist[v]) {
+                if (space.dist[v] == INF) space.touched.push_back(v);
+                space.dist[v] = cost;
+                space.parent[v] = from;
+                space.parentRoad[v] = via;
+                space.heap.push_back({v, cost});
+                push_heap(space.heap.begin(), space.heap.end(), greater<PqNode>());
+                METRIC(stats.heapPushes++);
+            }
+        };
+        relax(s, 0, -1, -1);
+        bool found = false;
+        while (!space.heap.empty()) {
+            pop_heap(space.heap.begin(), space.heap.end(), greater<PqNode>());
+            PqNode top = space.heap.back();
+            space.heap.pop_back();
+            int u = top.id;
+            if (top.timeCost > space.dist[u]) { METRIC(stats.stalePops++); continue; }
+            stats.settledNodes++;
+            if (u == t) { found = true; break; }
+            int level = queryLevel(u, s, t);
+            if (level == 0) {
+                for (int i = offset[u]; i < offset[u + 1]; i++) {
+                    stats.relaxedEdges++;
+                    relax(edges[i].destination, top.timeCost + edges[i].cost, u, i);
+                }
+                continue;
+            }
+            int l = level - 1, cell = cellOf[l][u];
+            const Cell& c = cells[l][cell];
+            size_t k = c.boundary.size();
+            const double* row = &cliques[l][c.clique + (size_t)slotOf[l][u] * k];
+            for (size_t j = 0; j < k; j++) {
+                stats.relaxedEdges++;
+                if (row[j] < INF && c.boundary[j] != u) relax(c.boundary[j], top.timeCost + row[j], u, -l - 2);
+            }
+            for (int i = offset[u]; i < offset[u + 1]; i++) { // Roads leaving the cell.
+                int v = edges[i].destination;
+                stats.relaxedEdges++;
+                if (cellOf[l][v] != cell) relax(v, top.timeCost + edges[i].cost, u, i);
+            }
+        }
+        if (!found) return false;
+
+        vector<pair<int, int>> steps; // (city, parentRoad) walking back from t.
+        for (int v = t; v != s; v = space.parent[v]) steps.push_back({v, space.parentRoad[v]});
+        vector<int> from;
+        for (int v = t; v != s; v = space.parent[v]) from.push_back(space.parent[v]);
+        for (int k = (int)steps.size() - 1; k >= 0; k--) {
+            if (steps[k].second >= 0) {
+                roads.push_back(steps[k].second);
+            } else {
+                int l = -steps[k].second - 2;
+                unpack(l, cellOf[l][from[k]], from[k], steps[k].first, offset, edges, roads);
+            }
+        }
+        route.push_back(s);
+        for (int road : roads) route.push_back(edges[road].destination);
+        return true;
+    }
+};
+
+// ==========================================
+//      MULTI-STOP TOUR SOLVER
+// ==========================================
+// Orders the stops of a delivery run on a dense n x n cost matrix (row-major, INF where a
+// stop can't be reached). Every road runs both ways, so travel costs are symmetric up to
+// rounding, but the moves don't rely on it: an open run's matrix is not. Stop 0 is the
+// depot and always comes first. A round trip ends back at the depot; an open run ends at
+// whichever stop suits it best, which is a round trip whose legs back to the depot are free.
+//   n <= EXACT_LIMIT  Held-Karp dynamic programming over subsets of stops: the optimal order.
+//   larger n          nearest-neighbour order improved by 2-opt and Or-opt moves until
+//                     neither helps, then iterated local search: a double-bridge kick (a
+//                     move the local search can't undo in one step, the perturbation used
+//                     by Lin-Kernighan style solvers) followed by local search, kept only
+//                     if the tour got cheaper.
+class TourSolver {
+public:
+    static constexpr int EXACT_LIMIT = 15;   // Largest stop count solved exactly (2^14 subsets x 14 last stops).
+    static constexpr int NEIGHBOURS = 8;     // Candidate stops a move may join a stop to.
+    static constexpr int KICK_SPAN = 30;     // Longest segment a double-bridge kick moves.
+
+private:
+    const vector<double>& matrix;        // Stop-to-stop costs at [from * n + to].
+    int n;                               // Number of stops (the depot included).
+    bool roundTrip;                      // False if the run may end at any stop.
+    vector<vector<int>> nearest;         // Closest stops to every stop (in either direction).
+    vector<double> forwardSum, backwardSum; // Prefix costs of the tour driven forwards / backwards.
+    vector<int> position;                // Index of every stop in the current tour.
+    vector<int> touched;                 // Stops whose roads the last move changed.
+    bool exact = false;                  // True if the last solve() used Held-Karp.
+
+    // Cost of driving from stop i to stop j (free back to the depot on an open run).
+    double cost(int i, int j) const {
+        return (!roundTrip && j == 0) ? 0.0 : matrix[(size_t)i * n + j];
+    }
+
+    // Optimal order by dynamic programming: best[mask][k] is the cheapest way to leave the
+    // depot, visit the stops in 'mask' and end at stop k + 1.
+    vector<int> solveExact() const {
+        int m = n - 1;
+        size_t subsets = (size_t)1 << m;
+        vector<double> best(subsets * m, INF * (n + 1)); // Above any tour, even one with unreachable legs.
+        vector<signed char> previous(subsets * m, -1);
+        for (int k = 0; k < m; k++) best[((size_t)1 << k) * m + k] = cost(0, k + 1);
+        for (size_t mask = 1; mask < subsets; mask++) {
+            for (int k = 0; k < m; k++) {
+                if (!(mask & ((size_t)1 << k))) continue;
+                double here = best[mask * m + k];
+                if (here >= INF * (n + 1)) continue;
+                for (int next = 0; next < m; next++) {
+                    if (mask & ((size_t)1 << next)) continue;
+                    size_t grown = mask | ((size_t)1 << next);
+                    double total = here + cost(k + 1, next + 1);
+                    if (total < best[grown * m + next]) {
+                        best[grown * m + next] = total;
+                        previous[grown * m + next] = (signed char)k;
+                    }
+                }
+            }
+        }
+        size_t mask = subsets - 1;
+        int last = 0;
+        for (int k = 1; k < m; k++) {
+            if (best[mask * m + k] + cost(k + 1, 0) < best[mask * m + last] + cost(last + 1, 0)) last = k;
+        }
+        vector<int> order;
+        while (last >= 0) {
+            order.push_back(last + 1);
+            int before = previous[mask * m + last];
+            mask &= ~((size_t)1 << last);
+            last = before;
+        }
+        order.push_back(0);
+        reverse(order.begin(), order.end());
+        return order;
+    }
+
+    // Recomputes the prefix sums and positions after the tour changed.
+    void index(const vector<int>& tour) {
+        for (int k = 0; k < n; k++) {
+            position[tour[k]] = k;
+            if (k + 1 < n) {
+                forwardSum[k + 1] = forwardSum[k] + cost(tour[k], tour[k + 1]);
+                backwardSum[k + 1] = backwardSum[k] + cost(tour[k + 1], tour[k]);
+            }
+        }
+    }
+
+    // 2-opt at position i: reverses tour[i..j] if that makes the tour cheaper, trying only
+    // reversals that join a stop to one of its nearest stops. The prefix sums give the cost of
+    // the reversed segment in O(1) even when the matrix is asymmetric.
+    bool tryTwoOpt(vector<int>& tour, int i) {
+        if (i < 1 || i >= n - 1) return false;
+        for (int side = 0; side < 2; side++) {
+            // New road a -> c (c near a) or b -> d (d near b); both come from reversing tour[i..j].
+            for (int near : nearest[side == 0 ? tour[i - 1] : tour[i]]) {
+                int j = side == 0 ? position[near] : (position[near] + n - 1) % n;
+                if (j <= i) continue;
+                int a = tour[i - 1], b = tour[i], c = tour[j], d = tour[(j + 1) % n];
+                double before = cost(a, b) + (forwardSum[j] - forwardSum[i]) + cost(c, d);
+                double after = cost(a, c) + (backwardSum[j] - backwardSum[i]) + cost(b, d);
+                if (after < before - 1e-9) {
+                    std::reverse(tour.begin() + i, tour.begin() + j + 1);
+                    index(tour);
+                    touched = {a, b, c, d};
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+
+    // Or-opt of the run tour[i..i+length-1]: moves it (either way round) next to one of the
+    // nearest stops of its ends if that makes the tour cheaper.
+    bool tryOrOpt(vector<int>& tour, int i, int length) {
+        if (i < 1 || i + length > n) return false;
+        int first = tour[i], last = tour[i + length - 1];
+        int before = tour[i - 1], after = tour[(i + length) % n];
+        double inside = forwardSum[i + length - 1] - forwardSum[i];
+        double insideReversed = backwardSum[i + length - 1] - backwardSum[i];
+        double removed = cost(before, first) + inside + cost(last, after) - cost(before, after);
+
+        double bestDelta = -1e-9;
+        int bestAt = -1;
+        bool bestReversed = false;
+        for (int end = 0; end < 2; end++) {
+            for (int near : nearest[end == 0 ? first : last]) {
+                int at = position[near];
+                for (int side = 0; side < 2; side++) { // Insert after 'near', or before it.
+                    int p = side == 0 ? at : (at + n - 1) % n;
+                    if (p >= i - 1 && p < i + length) continue; // Road touches the run itself.
+                    int a = tour[p], b = tour[(p + 1) % n];
+                    double forward = cost(a, first) + inside + cost(last, b) - cost(a, b) - removed;
+                    double backward = cost(a, last) + insideReversed + cost(first, b) - cost(a, b) - removed;
+                    if (forward < bestDelta) { bestDelta = forward; bestAt = p; bestReversed = false; }
+                    if (backward < bestDelta) { bestDelta = backward; bestAt = p; bestReversed = true; }
+                }
+            }
+        }
+        if (bestAt < 0) return false;
+
+        int anchor = tour[bestAt];
+        touched = {before, after, first, last, anchor, tour[(bestAt + 1) % n]};
+        vector<int> run(tour.begin() + i, tour.begin() + i + length);
+        if (bestReversed) std::reverse(run.begin(), run.end());
+        tour.erase(tour.begin() + i, tour.begin() + i + length);
+        int at = (int)(find(tour.begin(), tour.end(), anchor) - tour.begin());
+        tour.insert(tour.begin() + at + 1, run.begin(), run.end());
+        index(tour);
+        return true;
+    }
+
+    // Applies 2-opt and Or-opt moves until none improves the tour. Only stops in the work queue
+    // are examined (every stop to begin with, or just the ends of a kick); a stop whose roads
+    // change goes back into the queue, so settled parts of the tour are not scanned again.
+    void localSearch(vector<int>& tour, const vector<int>& start) {
+        index(tour);
+        vector<char> queued(n, 0);
+        deque<int> work;
+        for (int city : start) {
+            if (!queued[city]) { queued[city] = 1; work.push_back(city); }
+        }
+        while (!work.empty()) {
+            int city = work.front();
+            work.pop_front();
+            queued[city] = 0;
+            int at = position[city];
+            bool improved = tryTwoOpt(tour, at) || tryTwoOpt(tour, at + 1);
+            for (int length = 1; length <= 3 && !improved; length++) {
+                improved = tryOrOpt(tour, at, length) || tryOrOpt(tour, at - length + 1, length);
+            }
+            if (!improved) continue;
+            touched.push_back(city);
+            for (int changed : touched) {
+                if (!queued[changed]) { queued[changed] = 1; work.push_back(changed); }
+            }
+        }
+    }
+
+public:
+    TourSolver(const vector<double>& costs, int stopCount, bool returnToDepot)
+        : matrix(costs), n(stopCount), roundTrip(returnToDepot),
+          forwardSum(stopCount, 0), backwardSum(stopCount, 0), position(stopCount, 0) {
+        // Candidate lists: the closest stops by the cheaper of the two directions.
+        nearest.resize(n);
+        for (int i = 0; i < n; i++) {
+            vector<pair<double, int>> byCost;
+            for (int j = 0; j < n; j++) {
+                if (j != i) byCost.push_back({min(cost(i, j), cost(j, i)), j});
+            }
+            int keep = min((int)byCost.size(), NEIGHBOURS);
+            partial_sort(byCost.begin(), byCost.begin() + keep, byCost.end());
+            for (int k = 0; k < keep; k++) nearest[i].push_back(byCost[k].second);
+        }
+    }
+
+    // Total cost of visiting the stops in 'tour' order (INF or more if a leg is unreachable).
+    double tourCost(const vector<int>& tour) const {
+        double total = 0;
+        for (int k = 0; k < n; k++) total += cost(tour[k], tour[(k + 1) % n]);
+        return total;
+    }
+
+    // Visits the cheapest unvisited stop next, starting from the depot.
+    vector<int> nearestNeighbourTour() const {
+        vector<int> tour(1, 0);
+        vector<char> visited(n, 0);
+        visited[0] = 1;
+        for (int step = 1; step < n; step++) {
+            int from = tour.back(), next = -1;
+            for (int j = 0; j < n; j++) {
+                if (!visited[j] && (next < 0 || cost(from, j) < cost(from, next))) next = j;
+            }
+            visited[next] = 1;
+            tour.push_back(next);
+        }
+        return tour;
+    }
+
+    // Returns the stop indices in visiting order, starting with the depot (0). Instances of up
+    // to 'exactLimit' stops are solved exactly; larger ones get 'kicks' rounds of iterated
+    // local search (-1 = 25 per stop). The same seed always gives the same order.
+    vector<int> solve(int kicks = -1, unsigned seed = 1, int exactLimit = EXACT_LIMIT) {
+        exact = n <= 2 || n <= min(exactLimit, EXACT_LIMIT);
+        if (n <= 1) return vector<int>(n, 0);
+        if (exact) return solveExact();
+
+        vector<int> best = nearestNeighbourTour();
+        localSearch(best, best);
+        double bestCost = tourCost(best);
+        if (kicks < 0) kicks = 25 * n;
+        mt19937 rng(seed);
+        for (int round = 0; round < kicks && n >= 8; round++) {
+            // Double bridge: cut the tour into A B C D (A starting at the depot), join as A C B D.
+            // B and C are kept short so the kick stays local and the tour around it stays good.
+            uniform_int_distribution<int> start(1, n - 3), span(1, max(1, min(KICK_SPAN, n / 4)));
+            int cuts[3];
+            cuts[0] = start(rng);
+            cuts[1] = cuts[0] + span(rng);
+            cuts[2] = cuts[1] + span(rng);
+            if (cuts[2] > n - 1) continue;
+            vector<int> tour(best.begin(), best.begin() + cuts[0]);
+            tour.insert(tour.end(), best.begin() + cuts[1], best.begin() + cuts[2]);
+            tour.insert(tour.end(), best.begin() + cuts[0], best.begin() + cuts[1]);
+            tour.insert(tour.end(), best.begin() + cuts[2], best.end());
+            vector<int> ends = {best[cuts[0] - 1], best[cuts[0]], best[cuts[1] - 1], best[cuts[1]],
+                                best[cuts[2] - 1], best[cuts[2] % n]};
+            localSearch(tour, ends);
+            double total = tourCost(tour);
+            if (total < bestCost - 1e-9) {
+                best.swap(tour);
+                bestCost = total;
+            }
+        }
+        return best;
+    }
+
+    bool wasExact() const { return exact; } // True if the last solve() returned the optimal order.
+};
+
+// ==========================================
+//      CAPACITATED VEHICLE ROUTING SOLVER
+// ==========================================
+// Splits orders over a fleet of identical vehicles that each carry at most 'capacity' and
+// start and end every route at the depot. Works on a dense cost matrix over node 0 (the
+// depot) and nodes 1..n-1 (the orders), which need not be symmetric.
+//   savings()   Clarke-Wright construction: every order starts on its own route, then the
+//               end of one route is joined to the start of another in order of how much the
+//               join saves, as long as the load fits. Only joins between near orders are
+//               tried. A non-zero 'noise' perturbs the savings to give other start points.
+//   solve()     ruin and recreate (Schrimpf et al.) from the savings solution: remove a
+//               cluster of near orders or a random handful, reinsert each where it costs
+//               least (in a random, largest-first or farthest-first order, skipping a few
+//               positions at random), and accept the result by simulated annealing.
+// With a vehicle limit, orders that don't fit are left unassigned at a penalty larger than
+// any route could cost, so the search works them back in as soon as it can.
+class VrpSolver {
+public:
+    static constexpr int NEIGHBOURS = 30;    // Near orders tried by savings joins and cluster removals.
+    static constexpr int MAX_RUIN = 12;      // Most orders one ruin step removes.
+    static constexpr double TEMPERATURE_SHARE = 0.1; // Starting temperature as a share of an average leg's cost.
+
+    // A solution: one list of orders per vehicle used, in visiting order (depot implied at both ends).
+    struct Solution {
+        vector<vector<int>> routes;      // Orders of every route.
+        vector<double> load;             // Load carried on every route.
+        vector<int> unassigned;          // Orders no route could take (only with a vehicle limit).
+        double cost = 0;                 // Cost of all routes plus the penalty of unassigned orders.
+    };
+
+private:
+    const vector<double>& matrix;        // Node-to-node costs at [from * n + to].
+    const vector<double>& demand;        // Load of every order (demand[0] = 0 for the depot).
+    int n;                               // Number of nodes (the depot included).
+    double capacity;                     // Load one vehicle carries.
+    int maxRoutes;                       // Vehicles available (0 = as many as needed).
+    double penalty;                      // Cost of leaving one order unassigned.
+    vector<vector<int>> nearest;         // Closest orders to every order (in either direction).
+
+    double cost(int i, int j) const { return matrix[(size_t)i * n + j]; }
+
+    // Cost of driving one route from the depot through its orders and back.
+    double routeCost(const vector<int>& route) const {
+        double total = 0;
+        int previous = 0;
+        for (int order : route) {
+            total += cost(previous, order);
+            previous = order;
+        }
+        return total + cost(previous, 0);
+    }
+
+    // Recomputes the cost of a solution and drops its empty routes.
+    void evaluate(Solution& s) const {
+        s.cost = penalty * s.unassigned.size();
+        for (size_t r = 0; r < s.routes.size();) {
+            if (s.routes[r].empty()) {
+                s.routes.erase(s.routes.begin() + r);
+                s.load.erase(s.load.begin() + r);
+                continue;
+            }
+            s.cost += routeCost(s.routes[r]);
+            r++;
+        }
+    }
+
+    // Inserts every order of 'pending' at its cheapest feasible position, in the given order.
+    void recreate(Solution& s, vector<int>& pending, mt19937& rng) const {
+        uniform_real_distribution<double> unit(0, 1);
+        for (int order : pending) {
+            double bestDelta = INF * n;
+            int bestRoute = -1, bestAt = 0;
+            for (size_t r = 0; r < s.routes.size(); r++) {
+                if (s.load[r] + demand[order] > capacity) continue;
+                const vector<int>& route = s.routes[r];
+                for (size_t at = 0; at <= route.size(); at++) {
+                    if (unit(rng) < 0.01) continue; // Blink: skip a position now and then.
+                    int before = at == 0 ? 0 : route[at - 1];
+                    int after = at == route.size() ? 0 : route[at];
+                    double delta = cost(before, order) + cost(order, after) - cost(before, after);
+                    if (delta < bestDelta) { bestDelta = delta; bestRoute = (int)r; bestAt = (int)at; }
+                }
+            }
+            bool newRoute = maxRoutes == 0 || (int)s.routes.size() < maxRoutes;
+            if (newRoute && cost(0, order) + cost(order, 0) < bestDelta) {
+                s.routes.push_back({order});
+                s.load.push_back(demand[order]);
+            } else if (bestRoute >= 0) {
+                s.routes[bestRoute].insert(s.routes[bestRoute].begin() + bestAt, order);
+                s.load[bestRoute] += demand[order];
+            } else {
+                s.unassigned.push_back(order);
+            }
+        }
+    }
+
+    // One ruin-and-recreate step on a copy of 'current'.
+    Solution ruinAndRecreate(const Solution& current, mt19937& rng) const {
+        int orders = n - 1;
+        int count = uniform_int_distribution<int>(1, min(orders, MAX_RUIN))(rng);
+
+        // Ruin: a cluster around a random order, or random orders.
+        vector<char> removed(n, 0);
+        vector<int> pending = current.unassigned;
+        uniform_int_distribution<int> pick(1, orders);
+        if (rng() % 2 == 0) {
+            int centre = pick(rng);
+            removed[centre] = 1;
+            pending.push_back(centre);
+            for (int k = 0; k + 1 < count && k < (int)nearest[centre].size(); k++) {
+                removed[nearest[centre][k]] = 1;
+                pending.push_back(nearest[centre][k]);
+            }
+        } else {
+            for (int k = 0; k < count; k++) {
+                int order = pick(rng);
+                if (!removed[order]) { removed[order] = 1; pending.push_back(order); }
+            }
+        }
+        Solution next;
+        next.routes.reserve(current.routes.size() + 1);
+        for (size_t r = 0; r < current.routes.size(); r++) {
+            vector<int> kept;
+            double load = 0;
+            for (int order : current.routes[r]) {
+                if (removed[order]) continue;
+                kept.push_back(order);
+                load += demand[order];
+            }
+            if (kept.empty()) continue;
+            next.routes.push_back(move(kept));
+            next.load.push_back(load);
+        }
+
+        // Recreate, in one of three insertion orders.
+        shuffle(pending.begin(), pending.end(), rng);
+        unsigned sortBy = rng() % 10;
+        if (sortBy < 3) {
+            stable_sort(pending.begin(), pending.end(), [&](int a, int b) { return demand[a] > demand[b]; });
+        } else if (sortBy < 5) {
+            stable_sort(pending.begin(), pending.end(), [&](int a, int b) { return cost(0, a) > cost(0, b); });
+        }
+        recreate(next, pending, rng);
+        evaluate(next);
+        return next;
+    }
+
+public:
+    VrpSolver(const vector<double>& costs, const vector<double>& demands, int nodeCount, double vehicleCapacity,
+              int vehicleLimit = 0)
+        : matrix(costs), demand(demands), n(nodeCount), capacity(vehicleCapacity), maxRoutes(vehicleLimit) {
+        double farthest = 0;
+        for (int i = 1; i < n; i++) farthest = max(farthest, cost(0, i) + cost(i, 0));
+        penalty = 10 * farthest + 1;
+        nearest.resize(n);
+        for (int i = 1; i < n; i++) {
+            vector<pair<double, int>> byCost;
+            for (int j = 1; j < n; j++) {
+                if (j != i) byCost.push_back({min(cost(i, j), cost(j, i)), j});
+            }
+            int keep = min((int)byCost.size(), NEIGHBOURS);
+            partial_sort(byCost.begin(), byCost.begin() + keep, byCost.end());
+            for (int k = 0; k < keep; k++) nearest[i].push_back(byCost[k].second);
+        }
+    }
+
+    // Clarke-Wright savings solution; 'noise' > 0 scales every saving by a random factor in
+    // [1 - noise, 1 + noise]. Routes beyond the vehicle limit (the lightest ones) are
+    // dissolved into the unassigned list.
+    Solution savings(double noise = 0, unsigned seed = 1) const {
+        mt19937 rng(seed);
+        uniform_real_distribution<double> jitter(1 - noise, 1 + noise);
+        struct Join { double saving; int from, to; };
+        vector<Join> joins;
+        for (int i = 1; i < n; i++) {
+            for (int j : nearest[i]) {
+                double saving = cost(i, 0) + cost(0, j) - cost(i, j);
+                if (noise > 0) saving *= jitter(rng);
+                if (saving > 0) joins.push_back({saving, i, j});
+            }
+        }
+        sort(joins.begin(), joins.end(), [](const Join& a, const Join& b) {
+            return a.saving != b.saving ? a.saving > b.saving : make_pair(a.from, a.to) < make_pair(b.from, b.to);
+        });
+
+        // Routes as linked lists: next[i] follows order i, routeOf[] names the route by its first order.
+        vector<int> next(n, 0), routeOf(n), last(n);
+        vector<double> load(n);
+        for (int i = 1; i < n; i++) { routeOf[i] = i; last[i] = i; load[i] = demand[i]; }
+        for (const Join& join : joins) {
+            int a = routeOf[join.from], b = routeOf[join.to];
+            if (a == b || last[a] != join.from || b != join.to || load[a] + load[b] > capacity) continue;
+            next[join.from] = join.to;
+            last[a] = last[b];
+            load[a] += load[b];
+            for (int v = b; v != 0; v = next[v]) routeOf[v] = a;
+        }
+
+        Solution s;
+        for (int i = 1; i < n; i++) {
+            if (routeOf[i] != i) continue;
+            vector<int> route;
+            for (int v = i; v != 0; v = next[v]) route.push_back(v);
+            s.routes.push_back(route);
+            s.load.push_back(load[i]);
+        }
+        if (maxRoutes > 0 && (int)s.routes.size() > maxRoutes) {
+            vector<int> byLoad(s.routes.size());
+            for (size_t r = 0; r < byLoad.size(); r++) byLoad[r] = (int)r;
+            sort(byLoad.begin(), byLoad.end(), [&](int a, int b) { return s.load[a] > s.load[b]; });
+            Solution kept;
+            for (size_t k = 0; k < byLoad.size(); k++) {
+                int r = byLoad[k];
+                if ((int)k < maxRoutes) {
+                    kept.routes.push_back(s.routes[r]);
+                    kept.load.push_back(s.load[r]);
+                } else {
+                    kept.unassigned.insert(kept.unassigned.end(), s.routes[r].begin(), s.routes[r].end());
+                }
+            }
+            s = kept;
+        }
+        evaluate(s);
+        return s;
+    }
+
+    // Runs 'iterations' ruin-and-recreate steps from a savings solution (exact savings for
+    // seed 0, perturbed ones otherwise) and returns the best solution found.
+    Solution solve(int iterations, unsigned seed) const {
+        mt19937 rng(seed * 7919 + 1);
+        Solution current = savings(seed == 0 ? 0.0 : 0.1, seed);
+        Solution best = current;
+        uniform_real_distribution<double> unit(0, 1);
+        double startTemperature = TEMPERATURE_SHARE * current.cost / n, endTemperature = startTemperature / 100;
+        for (int step = 0; step < iterations; step++) {
+            Solution candidate = ruinAndRecreate(current, rng);
+            // Simulated annealing: accept a worse solution with a chance that fades as the
+            // temperature cools from a share of an average leg's cost to a hundredth of that.
+            double temperature = startTemperature * pow(endTemperature / startTemperature, (double)step / iterations);
+            if (candidate.cost < current.cost - temperature * log(1 - unit(rng))) current = move(candidate);
+            if (current.cost < best.cost - 1e-9) best = current;
+        }
+        return best;
+    }
+
+    double unassignedPenalty() const { return penalty; } // Cost added per unassigned order.
+};
+
+// ==========================================
+//      PRIORITY QUEUE BACKENDS
+// ==========================================
+// Dijkstra takes its queue as a template parameter, so the chosen queue is inlined into the
+// relaxation loop. Every backend offers reset / empty / push / pop:
+//   reset(cityCount, minRoadTime, maxRoadTime)  starts a new query.
+//   push(city, time)                            offers a city with its new best time.
+//   pop()                                       hands back the next city to expand.
+// EXACT backends pop in exact time order. The quantised ones (radix heap, Dial) only pop in
+// order of quantise(time), so cities within one quantum may come out of order; Dijkstra then
+// re-expands any city whose time still improves and only stops once the queue has moved
+// past the destination's quantum. The final times are the same as with an exact queue.
+
+// Binary heap with lazy deletion (the original std::priority_queue behaviour).
+struct BinaryHeapQueue {
+    static const bool EXACT = true;
+    vector<PqNode> heap;          // Min-heap kept between queries.
+
+    void reset(int, double, double) { heap.clear(); }
+    bool empty() const { return heap.empty(); }
+    void push(int id, double key) {
+        heap.push_back({id, key});
+        push_heap(heap.begin(), heap.end(), greater<PqNode>());
+    }
+    PqNode pop() {
+        pop_heap(heap.begin(), heap.end(), greater<PqNode>()); // Moves the lowest time to the back.
+        PqNode top = heap.back();
+        heap.pop_back();
+        return top;
+    }
+    long long quantise(double) const { return 0; } // Not used by exact queues.
+};
+
+// Indexed 4-ary heap with decrease-key: every city is in the heap at most once, so there are
+// no stale entries, and the wider nodes make the heap shallower than a binary one.
+struct QuaternaryHeapQueue {
+    static const bool EXACT = true;
+    vector<PqNode> heap;          // 4-ary min-heap; children of i are 4i+1 .. 4i+4.
+    vector<int> position;         // Index of every city inside heap (-1 = not in the heap).
+
+    void reset(int cityCount, double, double) {
+        for (auto& node : heap) position[node.id] = -1; // Only cities left over need clearing.
+        heap.clear();
+        if ((int)position.size() < cityCount + 1) position.resize(cityCount + 1, -1);
+    }
+    bool empty() const { return heap.empty(); }
+    void push(int id, double key) {
+        int i = position[id];
+        if (i == -1) {            // New city: append and sift up.
+            i = (int)heap.size();
+            heap.push_back({id, key});
+        } else if (key < heap[i].timeCost) {
+            heap[i].timeCost = key; // Decrease-key in place.
+        } else {
+            return;
+        }
+        siftUp(i);
+    }
+    PqNode pop() {
+        PqNode top = heap[0];
+        position[top.id] = -1;
+        PqNode last = heap.back();
+        heap.pop_back();
+        if (!heap.empty()) {
+            heap[0] = last;
+            position[last.id] = 0;
+            siftDown(0);
+        }
+        return top;
+    }
+    long long quantise(double) const { return 0; } // Not used by exact queues.
+
+private:
+    void siftUp(int i) {
+        PqNode node = heap[i];
+        while (i > 0) {
+            int p = (i - 1) / 4;
+            if (!(heap[p].timeCost > node.timeCost)) break;
+            heap[i] = heap[p];
+            position[heap[i].id] = i;
+            i = p;
+        }
+        heap[i] = node;
+        position[node.id] = i;
+    }
+    void siftDown(int i) {
+        PqNode node = heap[i];
+        int n = (int)heap.size();
+        while (true) {
+            int first = 4 * i + 1;
+            if (first >= n) break;
+            int best = first;     // Smallest of the up to four children.
+            int end = min(first + 4, n);
+            for (int c = first + 1; c < end; c++) {
+                if (heap[c].timeCost < heap[best].timeCost) best = c;
+            }
+            if (!(node.timeCost > heap[best].timeCost)) break;
+            heap[i] = heap[best];
+            position[heap[i].id] = i;
+            i = best;
+        }
+        heap[i] = node;
+        position[node.id] = i;
+    }
+};
+
+// Monotone radix heap on integer keys: times are quantised to 1/10000 minute. Bucket b
+// holds keys whose highest bit differing from the last popped key is bit b - 1, so every
+// entry moves down at most 64 times over its life. Dijkstra never pushes a key smaller
+// than the last popped one, which is all the radix heap needs.
+struct RadixHeapQueue {
+    static const bool EXACT = false;
+    struct Item {
+        unsigned long long key;   // Quantised time.
+        PqNode node;              // City and its exact time.
+    };
+    vector<Item> buckets[65];
+    unsigned long long last = 0;  // Key of the most recently popped entry.
+    size_t count = 0;             // Number of entries in all buckets.
+
+    unsigned long long quantise(double key) const { return (unsigned long long)(key * 10000.0); }
+    void reset(int, double, double) {
+        for (auto& bucket : buckets) bucket.clear();
+        last = 0;
+        count = 0;
+    }
+    bool empty() const { return count == 0; }
+    void push(int id, double key) {
+        unsigned long long q = quantise(key);
+        buckets[bucketOf(q)].push_back({q, {id, key}});
+        count++;
+    }
+    PqNode pop() {
+        if (buckets[0].empty()) {
+            // Take the first non-empty bucket, make its smallest key the new 'last' and
+            // spread the bucket over the lower buckets.
+            int b = 1;
+            while (buckets[b].empty()) b++;
+            unsigned long long smallest = buckets[b][0].key;
+            for (auto& item : buckets[b]) smallest = min(smallest, item.key);
+            last = smallest;
+            for (auto& item : buckets[b]) buckets[bucketOf(item.key)].push_back(item);
+            buckets[b].clear();
+        }
+        PqNode top = buckets[0].back().node;
+        buckets[0].pop_back();
+        count--;
+        return top;
+    }
+
+private:
+    int bucketOf(unsigned long long key) const {
+        return key == last ? 0 : 64 - __builtin_clzll(key ^ last);
+    }
+};
+
+// Dial's bucket queue: a circular array of buckets, each 'width' minutes wide. A pushed time
+// is never more than one road ahead of the popped one, so maxRoadTime / width + 3 buckets
+// are enough (one spare for rounding). With width = shortest road time no city in a bucket can improve another one
+// in the same bucket, so cities are expanded once; the bucket count is capped at 65536.
+struct DialBucketQueue {
+    static const bool EXACT = false;
+    static const int MAX_BUCKETS = 65536;
+    vector<vector<PqNode>> buckets;
+    double width = 1;             // Minutes covered by one bucket.
+    long long cursor = 0;         // Quantised time of the bucket being emptied.
+    size_t count = 0;             // Number of entries in all buckets.
+
+    long long quantise(double key) const { return (long long)(key / width); }
+    void reset(int, double minRoadTime, double maxRoadTime) {
+        width = minRoadTime > 0 ? minRoadTime : maxRoadTime / (MAX_BUCKETS - 3);
+        if (!(width > 0)) width = 1;
+        if (maxRoadTime / width + 3 > MAX_BUCKETS) width = maxRoadTime / (MAX_BUCKETS - 3);
+        size_t needed = (size_t)(maxRoadTime / width) + 3;
+        if (buckets.size() != needed) {
+            buckets.assign(needed, vector<PqNode>());
+        } else if (count > 0) {   // A query that stopped early left entries behind.
+            for (auto& bucket : buckets) bucket.clear();
+        }
+        cursor = 0;
+        count = 0;
+    }
+    bool empty() const { return count == 0; }
+    void push(int id, double key) {
+        buckets[quantise(key) % buckets.size()].push_back({id, key});
+        count++;
+    }
+    PqNode pop() {
+        while (buckets[cursor % buckets.size()].empty()) cursor++;
+        vector<PqNode>& bucket = buckets[cursor % buckets.size()];
+        PqNode top = bucket.back();
+        bucket.pop_back();
+        count--;
+        return top;
+    }
+};
+
+// Returns the calling thread's queue of the given type (kept between queries).
+template <typename Queue>
+Queue& getThreadQueue() {
+    static thread_local Queue queue;
+    return queue;
+}
+
+#ifdef ROUTE_METRICS
+// ==========================================
+//      QUERY METRICS (ROUTE_METRICS ONLY)
+// ==========================================
+// Histogram of non-negative integer samples in the style of HdrHistogram: values below 64
+// get a bucket each and every larger power of two is split into 32 buckets, so a sample is
+// known to within about 3% at any size, from one settled city to hours in nanoseconds.
+// Threads record with relaxed atomic adds and never wait for each other or for a reader;
+// a dump taken while queries run may miss the samples being recorded at that moment.
+class MetricHistogram {
+private:
+    static const int SUB_BITS = 6;                           // Values below 2^SUB_BITS are exact.
+    static const int HALF = 1 << (SUB_BITS - 1);             // Buckets per power of two above that.
+    static const int BUCKETS = (1 << SUB_BITS) + (64 - SUB_BITS) * HALF;
+
+    atomic<unsigned long long> counts[BUCKETS];
+    atomic<unsigned long long> samples, sum, largest;
+
+    static int bucketOf(unsigned long long value) {
+        if (value < (1ull << SUB_BITS)) return (int)value;
+#if defined(__GNUC__) || defined(__clang__)
+        int top = 63 - __builtin_clzll(value);                // Highest set bit (>= SUB_BITS).
+#else
+        int top = SUB_BITS;
+        while (value >> (top + 1)) top++;
+#endif
+        int shift = top - SUB_BITS + 1;                       // Low bits dropped in this range.
+        return (1 << SUB_BITS) + (shift - 1) * HALF + (int)(value >> shift) - HALF;
+    }
+
+    static unsigned long long bucketLimit(int bucket) {      // Largest value counted in a bucket.
+        if (bucket < (1 << SUB_BITS)) return bucket;
+        int shift = (bucket - (1 << SUB_BITS)) / HALF + 1;
+        unsigned long long top = (bucket - (1 << SUB_BITS)) % HALF + HALF;
+        return ((top + 1) << shift) - 1;
+    }
+
+public:
+    MetricHistogram() { reset(); }
+
+    void record(unsigned long long value) {
+        counts[bucketOf(value)].fetch_add(1, memory_order_relaxed);
+        samples.fetch_add(1, memory_order_relaxed);
+        sum.fetch_add(value, memory_order_relaxed);
+        unsigned long long seen = largest.load(memory_order_relaxed);
+        while (value > seen && !largest.compare_exchange_weak(seen, value, memory_order_relaxed)) {}
+    }
+
+    void reset() {
+        for (auto& c : counts) c.store(0, memory_order_relaxed);
+        samples = 0;
+        sum = 0;
+        largest = 0;
+    }
+
+    unsigned long long count() const { return samples.load(memory_order_relaxed); }
+    double mean() const { return count() ? (double)sum.load(memory_order_relaxed) / count() : 0; }
+    unsigned long long maximum() const { return largest.load(memory_order_relaxed); }
+
+    // Returns the smallest bucket limit with at least 'fraction' of the samples at or below it.
+    unsigned long long percentile(double fraction) const {
+        unsigned long long rank = max(1ull, (unsigned long long)ceil(fraction * count())), seen = 0;
+        for (int b = 0; b < BUCKETS; b++) {
+            seen += counts[b].load(memory_order_relaxed);
+            if (seen >= rank) return min(bucketLimit(b), maximum());
+        }
+        return maximum();
+    }
+};
+
+// What is recorded for every query: the search counters and the time of each phase.
+enum MetricKind {
+    METRIC_SETTLED,   // Cities settled.
+    METRIC_RELAXED,   // Roads examined.
+    METRIC_PUSHES,    // Queue entries added.
+    METRIC_STALE,     // Queue entries skipped as stale.
+    METRIC_SEARCH_NS, // Search and route tracing (incl. waiting for the traffic lock).
+    METRIC_LEGS_NS,   // Building the legs of the receipt.
+    METRIC_TOTAL_NS,  // The whole planRoute call.
+    METRIC_KIND_COUNT
+};
+
+// Histograms of every MetricKind per search mode, filled by RoutePlanner::planRoute (and so by
+// findRoute, the query server and the benchmark suite) and dumped on demand.
+class QueryMetrics {
+private:
+    MetricHistogram histograms[PARTITION_OVERLAY + 1][METRIC_KIND_COUNT];
+
+public:
+    void record(SearchMode mode, const SearchStats& stats, long long searchNs, long long legsNs) {
+        MetricHistogram* h = histograms[mode];
+        h[METRIC_SETTLED].record(stats.settledNodes);
+        h[METRIC_RELAXED].record(stats.relaxedEdges);
+        h[METRIC_PUSHES].record(stats.heapPushes);
+        h[METRIC_STALE].record(stats.stalePops);
+        h[METRIC_SEARCH_NS].record(searchNs);
+        h[METRIC_LEGS_NS].record(legsNs);
+        h[METRIC_TOTAL_NS].record(searchNs + legsNs);
+    }
+
+    void reset() {
+        for (auto& row : histograms) for (auto& h : row) h.reset();
+    }
+
+    // Writes one line per search mode and metric that has samples:
+    //   METRIC mode=<m> name=<metric> count=<n> mean=<v> p50=<v> p90=<v> p99=<v> max=<v>
+    // Times are in microseconds.
+    void dump(ostream& out) const {
+        static const char* modeNames[] = {"dijkstra", "bidir", "astar", "ch", "alt", "crp"};
+        static const char* kindNames[] = {"settled", "relaxed", "heap_pushes", "stale_pops",
+                                          "search_us", "legs_us", "total_us"};
+        char line[256];
+        for (int m = 0; m <= PARTITION_OVERLAY; m++) {
+            for (int k = 0; k < METRIC_KIND_COUNT; k++) {
+                const MetricHistogram& h = histograms[m][k];
+                if (h.count() == 0) continue;
+                double scale = k >= METRIC_SEARCH_NS ? 1e-3 : 1; // Nanoseconds shown as microseconds.
+                snprintf(line, sizeof(line), "METRIC mode=%s name=%s count=%llu mean=%.2f p50=%.2f p90=%.2f p99=%.2f max=%.2f",
+                         modeNames[m], kindNames[k], h.count(), h.mean() * scale, h.percentile(0.5) * scale,
+                         h.percentile(0.9) * scale, h.percentile(0.99) * scale, h.maximum() * scale);
+                out << line << "\n";
+            }
+        }
+        out.flush();
+    }
+};
+
+// The process-wide metrics every planner records into.
+QueryMetrics& queryMetrics() {
+    static QueryMetrics metrics;
+    return metrics;
+}
+#endif
+
+// ==========================================
+//      QUERY WORKSPACE
+// ==========================================
+// Scratch arrays for one search, allocated once per thread and reused by every query.
+// Instead of refilling every array with INF / -1 / 0 before each query (O(cities)), every
+// entry remembers the generation of the query that last initialised it. Entries left by
+// older queries read as untouched, so starting a query is O(1) and each query only pays
+// for the cities it actually visits.
+struct QueryWorkspace {
+    vector<double> minTime;       // Best known time of every city.
+    vector<double> fuelConsumed;  // Fuel used to reach every city.
+    vector<double> pathDist;      // Distance driven to reach every city.
+    vector<double> estimate;      // Cached A* / ALT potential (-1 = not computed yet).
+    vector<int> parent;           // Previous city on the best route (-1 = none).
+    vector<int> viaEdge;          // Road index used to reach every city (-1 = none).
+    vector<unsigned> stamp;       // Generation that last initialised each city's entries.
+    unsigned generation = 0;      // Generation of the running query.
+    vector<PqNode> heap;          // Buffer of the priority queue (kept between queries).
+    SearchStats stats;            // Counters of the running query.
+
+    // Starts a new query over cities 0..cityCount.
+    void begin(int cityCount) {
+        if ((int)stamp.size() < cityCount + 1) { // Grows once when a bigger map shows up.
+            minTime.resize(cityCount + 1);
+            fuelConsumed.resize(cityCount + 1);
+            pathDist.resize(cityCount + 1);
+            estimate.resize(cityCount + 1);
+            parent.resize(cityCount + 1);
+            viaEdge.resize(cityCount + 1);
+            stamp.resize(cityCount + 1, 0);
+        }
+        if (++generation == 0) {              // Wrapped around after 4 billion queries:
+            fill(stamp.begin(), stamp.end(), 0); // clear the stamps once and start over.
+            generation = 1;
+        }
+        heap.clear();
+        stats = SearchStats();
+    }
+
+    // Initialises city v for the running query if an older query left it behind.
+    void touch(int v) {
+        if (stamp[v] == generation) return;
+        stamp[v] = generation;
+        minTime[v] = INF;
+        fuelConsumed[v] = 0;
+        pathDist[v] = 0;
+        estimate[v] = -1;
+        parent[v] = -1;
+        viaEdge[v] = -1;
+    }
+
+    // Returns the best known time of v in the running query (INF if not reached).
+    double timeOf(int v) const { return stamp[v] == generation ? minTime[v] : INF; }
+};
+
+// Returns the calling thread's workspace. Slot 1 is a second one for the backward half
+// of a bidirectional search; slot 2 is for short checks run while both are still in use.
+QueryWorkspace& getThreadWorkspace(int slot = 0) {
+    static thread_local QueryWorkspace spaces[3];
+    return spaces[slot];
+}
+
+// ==========================================
+//        CORE ROUTING CLASS
+// ==========================================
+class RoutePlanner {
+private:
+    // Compressed Sparse Row (CSR) graph: the roads leaving city u are stored contiguously
+    // in edges[edgeOffset[u]] .. edges[edgeOffset[u + 1] - 1], so the search walks one flat array.
+    // The arrays below either own their data or view a mapped graph file (see loadBinaryGraph).
+    MappedFile graphFile;         // Mapped binary graph file (empty if the map was built in memory).
+    GraphArray<int> edgeOffset;   // Start index of every city's roads inside the edges array (size cityCount + 2).
+    GraphArray<Edge> edges;       // All directed roads of all cities, grouped by source city.
+    vector<PendingRoad> pending;  // Roads added by addRoad that are not yet compressed into the CSR arrays.
+    GraphArray<int> edgeNameId;   // Name of every road as an index into roadNames (cold data, parallel to edges).
+    NameTable roadNames;          // Every distinct road name, stored once.
+    unordered_map<string, int> roadNameIndex; // Finds the index of a road name that is already stored (built on demand).
+    NameTable cityNames;          // Stores the names of the cities based on their ID.
+    GraphArray<double> cityLat;   // Latitude of every city in degrees (NAN if unknown).
+    GraphArray<double> cityLon;   // Longitude of every city in degrees (NAN if unknown).
+    atomic<double> heuristicScale; // Shortest road length per straight-line km (0 = A* runs without a heuristic, -1 = not computed).
+    int cityCount;                // Variable to keep track of how many cities have been added.
+    ContractionHierarchy hierarchy; // Preprocessed hierarchy for CONTRACTION_HIERARCHY queries.
+    PartitionOverlay overlay;     // Partition and cliques for PARTITION_OVERLAY queries.
+    vector<int> landmarks;        // Cities chosen as landmarks for the LANDMARKS mode.
+    vector<double> landmarkDist;  // Cost from landmark i to city v at [v * landmarks.size() + i].
+    atomic<bool> landmarksReady;  // True while landmarkDist matches the graph (read by queries without a lock).
+    LandmarkStrategy landmarkStrategy; // Strategy used to pick the current landmarks.
+    double minEdgeCost;           // Smallest positive speed-independent road cost (sizes Dial's buckets).
+    double maxEdgeCost;           // Largest speed-independent road cost.
+    unordered_map<int, CostTree> treeCache; // Speed-independent shortest-path trees by start city.
+    size_t treeCacheCapacity;     // Most trees kept at once (the least recently used one is dropped).
+    unsigned long long treeCacheClock; // Counts cache lookups; stamps every tree use.
+    mutex treeCacheMutex;         // Guards the tree cache when queries run on several threads.
+    GraphArray<int> twinRoad;     // Index of the opposite direction of every road (-1 = one-way).
+    WriterFirstMutex trafficMutex; // Held shared by queries and exclusively by updateTraffic.
+    mutex lazyBuildMutex;         // Lets one query build a missing structure while the others wait for it.
+    vector<unsigned> repairMark;  // Marks the cities cut off during one tree repair.
+    unsigned repairGeneration;    // Value of repairMark for the running repair.
+    GraphArray<unsigned char> profileValues; // Quantised multipliers of every profile, PROFILE_SLOTS per profile.
+    unordered_map<string, int> profileIndex; // Finds an existing profile with the same values (built on demand).
+
+    // Compresses all pending roads into the CSR arrays (counting sort by source city).
+    void buildGraph() {
+        int n = cityCount + 2;                   // One slot per city ID plus the closing offset.
+        vector<int> degree(n, 0);                // Counts how many roads leave each city.
+        for (int u = 0; u + 1 < (int)edgeOffset.size(); u++) {
+            degree[u] += edgeOffset[u + 1] - edgeOffset[u]; // Roads that are already compressed.
+        }
+        for (auto& road : pending) degree[road.from]++; // Roads that are still waiting.
+
+        vector<int> newOffset(n, 0);             // Offsets of the rebuilt graph.
+        for (int u = 0; u + 1 < n; u++) {
+            newOffset[u + 1] = newOffset[u] + degree[u]; // Prefix sum gives each city its start index.
+        }
+
+        vector<Edge> newEdges(newOffset[n - 1]); // Allocates every road in one contiguous block.
+        vector<int> newNameId(newOffset[n - 1]); // Road names, in the same order.
+        vector<int> cursor(newOffset.begin(), newOffset.end() - 1); // Next free slot of every city.
+        // Old roads are copied first so each city keeps its roads in insertion order.
+        for (int u = 0; u + 1 < (int)edgeOffset.size(); u++) {
+            for (int i = edgeOffset[u]; i < edgeOffset[u + 1]; i++) {
+                newNameId[cursor[u]] = edgeNameId[i];
+                newEdges[cursor[u]++] = edges[i];
+            }
+        }
+        for (auto& road : pending) {
+            newNameId[cursor[road.from]] = road.nameId;
+            newEdges[cursor[road.from]++] = road.edge;
+        }
+
+        heuristicScale = -1;           // Roads changed, so the A* scale must be recomputed.
+        hierarchy.clear();             // Roads changed, so the hierarchy is out of date.
+        overlay.clear();               // Roads changed, so the partition is out of date.
+        landmarkDist.clear();          // Roads changed, so the landmark tables are out of date.
+        landmarksReady = false;
+        treeCache.clear();             // Roads changed, so the cached trees are out of date.
+        edgeOffset.swap(newOffset);    // Installs the new offsets.
+        edges.swap(newEdges);          // Installs the new road array.
+        edgeNameId.swap(newNameId);    // Installs the matching names.
+        vector<PendingRoad>().swap(pending); // Frees the staging list completely.
+
+        minEdgeCost = maxEdgeCost = 0; // Cost range of all roads, used by the bucket queues.
+        for (const Edge& edge : edges) {
+            double cost = getEdgeCost(edge);
+            if (cost > 0 && (minEdgeCost == 0 || cost < minEdgeCost)) minEdgeCost = cost;
+            maxEdgeCost = max(maxEdgeCost, cost);
+        }
+
+        // Pairs up the two directions of every two-way road (same details, opposite ends).
+        twinRoad.assign(edges.size(), -1);
+        for (int u = 1; u <= cityCount; u++) {
+            for (int i = edgeOffset[u]; i < edgeOffset[u + 1]; i++) {
+                if (twinRoad[i] != -1) continue;
+                int v = edges[i].destination;
+                for (int j = edgeOffset[v]; j < edgeOffset[v + 1]; j++) {
+                    const Edge& back = edges[j];
+                    if (twinRoad[j] == -1 && j != i && back.destination == u && back.distanceKM == edges[i].distanceKM &&
+                        back.type == edges[i].type && edgeNameId[j] == edgeNameId[i]) {
+                        twinRoad[i] = j;
+                        twinRoad[j] = i;
+                        break;
+                    }
+                }
+            }
+        }
+    }
+
+    // Makes sure the CSR arrays include every road added so far.
+    void ensureGraphBuilt() {
+        if (!pending.empty() || (int)edgeOffset.size() != cityCount + 2) buildGraph();
+    }
+
+    // Works out how much the A* straight-line estimate may be trusted.
+    // A road can never be shorter than the straight line between its cities, but typed-in
+    // distances are rounded, so the estimate is scaled by the smallest road/straight-line
+    // ratio seen on the map. If any city has no coordinates the heuristic is switched off.
+    void computeHeuristicScale() {
+        for (int u = 1; u <= cityCount; u++) {
+            if (std::isnan(cityLat[u]) || std::isnan(cityLon[u])) { heuristicScale = 0; return; }
+        }
+        double scale = 1.0;
+        for (int u = 1; u <= cityCount; u++) {
+            for (int i = edgeOffset[u]; i < edgeOffset[u + 1]; i++) {
+                int v = edges[i].destination;
+                double straight = greatCircleKM(cityLat[u], cityLon[u], cityLat[v], cityLon[v]);
+                if (straight > 0) scale = min(scale, edges[i].distanceKM / straight);
+            }
+        }
+        heuristicScale = scale; // Published last, so a query never sees a half-computed scale.
+    }
+
+    // Builds a structure a query needs if it's missing. Queries hold the traffic lock only
+    // shared, so several can find the same structure missing (after a traffic update dropped
+    // it, say): the first one builds it under lazyBuildMutex while the others wait, and each
+    // checks again before building. ready() must read an atomic flag that build() sets last.
+    template <typename Ready, typename Build>
+    void buildOnce(Ready ready, Build build) {
+        if (ready()) return;
+        lock_guard<mutex> buildLock(lazyBuildMutex);
+        if (!ready()) build();
+    }
+
+    // Speed-independent cost of a road: distance x traffic multiplier ("clear-road km").
+    // The travel time at any speed is this cost x 60 / speed. Stored in the road when it is
+    // added or its traffic changes.
+    double getEdgeCost(const Edge& edge) {
+        return edge.cost;
+    }
+
+    // Returns the index of a road name in roadNames, storing the name the first time.
+    int internRoadName(const string& name) {
+        if ((int)roadNameIndex.size() != roadNames.size()) { // Names came from a graph file.
+            roadNameIndex.clear();
+            for (int k = 0; k < roadNames.size(); k++) roadNameIndex[roadNames[k]] = k;
+        }
+        auto found = roadNameIndex.find(name);
+        if (found != roadNameIndex.end()) return found->second;
+        roadNames.push_back(name);
+        roadNameIndex[name] = roadNames.size() - 1;
+        return roadNames.size() - 1;
+    }
+
+    // Plain Dijkstra on the speed-independent cost. Fills dist[] and parent[] and, if
+    // given, the cities in the order they were settled and the road used to reach each city.
+    void computeCostDistances(int source, vector<double>& dist, vector<int>& parent, vector<int>* order,
+                              vector<int>* parentRoad = nullptr, SearchStats* stats = nullptr) {
+        priority_queue<PqNode, vector<PqNode>, greater<PqNode>> pq;
+        dist.assign(cityCount + 1, INF);
+        parent.assign(cityCount + 1, -1);
+        if (order) order->clear();
+        if (parentRoad) parentRoad->assign(cityCount + 1, -1);
+        dist[source] = 0;
+        pq.push({source, 0});
+        METRIC(if (stats) stats->heapPushes++);
+        while (!pq.empty()) {
+            int u = pq.top().id;
+            double d = pq.top().timeCost;
+            pq.pop();
+            if (d > dist[u]) { METRIC(if (stats) stats->stalePops++); continue; }
+            if (order) order->push_back(u);
+            if (stats) {
+                stats->settledNodes++;
+                stats->relaxedEdges += edgeOffset[u + 1] - edgeOffset[u];
+            }
+            for (int i = edgeOffset[u]; i < edgeOffset[u + 1]; i++) {
+                int v = edges[i].destination;
+                double nd = d + getEdgeCost(edges[i]);
+                if (nd < dist[v]) {
+                    dist[v] = nd;
+                    parent[v] = u;
+                    if (parentRoad) (*parentRoad)[v] = i;
+                    pq.push({v, nd});
+                    METRIC(if (stats) stats->heapPushes++);
+                }
+            }
+        }
+    }
+
+    // Triangle-inequality lower bound on the cost between cities u and t:
+    // |d(L, t) - d(L, u)| for every landmark L, taking the largest.
+    // Roads are two-way with equal details, so "to" and "from" tables are the same table.
+    double landmarkLowerBound(int u, int t) {
+        size_t k = landmarks.size();
+        const double* du = &landmarkDist[u * k];
+        const double* dt = &landmarkDist[t * k];
+        double bound = 0;
+        for (size_t i = 0; i < k; i++) {
+            if (du[i] == INF || dt[i] == INF) continue; // Landmark in another component: no information.
+            bound = max(bound, fabs(dt[i] - du[i]));
+        }
+        return bound;
+    }
+
+    // Adds up time, distance and fuel along a finished route, given the road index used for
+    // every leg in travel order. The sums are built in travel order, exactly like the
+    // forward Dijkstra relaxation, so every mode reports the same totals.
+    void accumulateRoute(const vector<int>& roads, int speed,
+                         double& totalTime, double& totalDist, double& totalFuel, VehicleKind vehicle = PETROL_CAR) {
+        const double* fuelPerKm = getVehicleProfile(vehicle).litresPerKm(speed);
+        totalTime = totalDist = totalFuel = 0;
+        for (size_t k = 0; k < roads.size(); k++) {
+            const Edge& edge = edges[roads[k]];
+            totalTime = totalTime + getTravelTime(edge, speed);
+            totalDist = totalDist + edge.distanceKM;
+            totalFuel = totalFuel + edge.distanceKM * fuelPerKm[edge.type];
+        }
+    }
+
+    // Reads the route from startNode to endNode out of a cached tree: the cities in travel
+    // order and the road used for every leg. Returns false if endNode is unreachable.
+    bool walkTree(const CostTree& tree, int startNode, int endNode, vector<int>& route, vector<int>& roads) {
+        if (endNode != startNode && tree.parent[endNode] == -1) return false;
+        for (int v = endNode; v != startNode; v = tree.parent[v]) {
+            route.push_back(v);
+            roads.push_back(tree.parentRoad[v]);
+        }
+        route.push_back(startNode);
+        reverse(route.begin(), route.end());
+        reverse(roads.begin(), roads.end());
+        return true;
+    }
+
+    // Plain Dijkstra from 'source' with the given per-road weight; fills bound[] (INF if unreachable).
+    template <typename Weight>
+    void computeBoundsFrom(int source, vector<double>& bound, Weight weight) {
+        priority_queue<PqNode, vector<PqNode>, greater<PqNode>> pq;
+        bound.assign(cityCount + 1, INF);
+        bound[source] = 0;
+        pq.push({source, 0});
+        while (!pq.empty()) {
+            int u = pq.top().id;
+            double d = pq.top().timeCost;
+            pq.pop();
+            if (d > bound[u]) continue;
+            for (int i = edgeOffset[u]; i < edgeOffset[u + 1]; i++) {
+                int v = edges[i].destination;
+                double nd = d + weight(edges[i]);
+                if (nd < bound[v]) {
+                    bound[v] = nd;
+                    pq.push({v, nd});
+                }
+            }
+        }
+    }
+
+    // Dijkstra on travel time from 'source' in 'ws' that stops once the queue passes 'limit'.
+    // When 'target' is settled the limit drops to (1 + stretch) x its time, so the search goes
+    // on only as far as routes within that stretch can reach. Settled cities are appended to
+    // 'settled' if given; the work done is added to 'stats'. Returns the time of 'target'.
+    double growBoundedTree(int source, int target, int speed, double stretch, double limit,
+                           QueryWorkspace& ws, vector<int>* settled, SearchStats& stats) {
+        ws.begin(cityCount);
+        ws.touch(source);
+        ws.minTime[source] = 0;
+        ws.heap.push_back({source, 0});
+        METRIC(stats.heapPushes++);
+        while (!ws.heap.empty()) {
+            pop_heap(ws.heap.begin(), ws.heap.end(), greater<PqNode>());
+            PqNode top = ws.heap.back();
+            ws.heap.pop_back();
+            int u = top.id;
+            if (top.timeCost > limit) break;
+            if (top.timeCost > ws.minTime[u]) { METRIC(stats.stalePops++); continue; }
+            stats.settledNodes++;
+            if (settled) settled->push_back(u);
+            if (u == target) limit = min(limit, top.timeCost * (1 + stretch));
+            for (int i = edgeOffset[u]; i < edgeOffset[u + 1]; i++) {
+                int v = edges[i].destination;
+                stats.relaxedEdges++;
+                ws.touch(v);
+                double newTime = top.timeCost + getTravelTime(edges[i], speed);
+                if (newTime < ws.minTime[v]) {
+                    ws.minTime[v] = newTime;
+                    ws.parent[v] = u;
+                    ws.viaEdge[v] = i;
+                    ws.heap.push_back({v, newTime});
+                    push_heap(ws.heap.begin(), ws.heap.end(), greater<PqNode>());
+                    METRIC(stats.heapPushes++);
+                }
+            }
+        }
+        return target == -1 ? INF : ws.timeOf(target);
+    }
+
+    // Bounded one-to-all search for an isochrone. 'weight(edge)' is the budget a road uses;
+    // ws.minTime holds the budget spent instead of a time. Cities are settled until the next
+    // one would go over the budget, so only the reachable area and its border are touched.
+    // Every road out of a reachable city that can't be driven to its end becomes a CutRoad.
+    template <typename Weight>
+    void runBudgetSearch(int origin, double budget, Weight weight, IsochroneResult& result) {
+        QueryWorkspace& ws = getThreadWorkspace();
+        ws.begin(cityCount);
+        ws.touch(origin);
+        ws.minTime[origin] = 0;
+        ws.heap.push_back({origin, 0});
+        METRIC(ws.stats.heapPushes++);
+        while (!ws.heap.empty()) {
+            pop_heap(ws.heap.begin(), ws.heap.end(), greater<PqNode>());
+            PqNode top = ws.heap.back();
+            ws.heap.pop_back();
+            int u = top.id;
+            if (top.timeCost > budget) break;
+            if (top.timeCost > ws.minTime[u]) { METRIC(ws.stats.stalePops++); continue; }
+            ws.stats.settledNodes++;
+            result.cities.push_back(u);
+            result.spent.push_back(top.timeCost);
+            for (int i = edgeOffset[u]; i < edgeOffset[u + 1]; i++) {
+                const Edge& edge = edges[i];
+                int v = edge.destination;
+                ws.stats.relaxedEdges++;
+                double used = weight(edge);
+                double total = top.timeCost + used;
+                if (total > budget) { // Spends the rest of the budget part way along the road.
+                    result.cutRoads.push_back({i, u, v, edge.distanceKM * (budget - top.timeCost) / used});
+                    continue;
+                }
+                ws.touch(v);
+                if (total < ws.minTime[v]) {
+                    ws.minTime[v] = total;
+                    ws.parent[v] = u;
+                    ws.viaEdge[v] = i;
+                    ws.heap.push_back({v, total});
+                    push_heap(ws.heap.begin(), ws.heap.end(), greater<PqNode>());
+                    METRIC(ws.stats.heapPushes++);
+                }
+            }
+        }
+        // A road whose far end is reachable too is driven from both ends; it only stays cut if
+        // the two reaches leave a gap in the middle (roads are two-way with equal details).
+        auto covered = [&](const CutRoad& cut) {
+            double fromEnd = ws.timeOf(cut.to);
+            return fromEnd <= budget && (budget - ws.minTime[cut.from]) + (budget - fromEnd) >= weight(edges[cut.road]);
+        };
+        result.cutRoads.erase(remove_if(result.cutRoads.begin(), result.cutRoads.end(), covered), result.cutRoads.end());
+        result.stats = ws.stats;
+    }
+
+    // Everything reachable from 'origin' within 'budget' minutes (TIME_BUDGET) or litres
+    // (FUEL_BUDGET, burnt by 'vehicle') when driving at 'speed'. The caller holds the traffic lock.
+    IsochroneResult isochroneFrom(int origin, int speed, double budget, BudgetKind kind, VehicleKind vehicle) {
+        IsochroneResult result;
+        result.origin = origin;
+        result.budget = budget;
+        result.kind = kind;
+        if (origin < 1 || origin > cityCount || budget < 0) return result;
+        if (kind == FUEL_BUDGET) {
+            const double* fuelPerKm = getVehicleProfile(vehicle).litresPerKm(speed);
+            runBudgetSearch(origin, budget, [&](const Edge& e) { return e.distanceKM * fuelPerKm[e.type]; }, result);
+        } else {
+            runBudgetSearch(origin, budget, [&](const Edge& e) { return getTravelTime(e, speed); }, result);
+        }
+        return result;
+    }
+
+    // Returns the city a road leaves from (binary search over the CSR offsets).
+    int roadSource(int road) {
+        return (int)(upper_bound(edgeOffset.begin(), edgeOffset.end(), road) - edgeOffset.begin()) - 1;
+    }
+
+    // Repairs a cached shortest-path tree after the roads in 'changed' went from oldCost to
+    // their current cost, touching only the part of the tree that can change (dynamic SSSP
+    // in the style of Ramalingam and Reps):
+    //  1. a dearer road used by the tree cuts off the subtree below it; those cities forget
+    //     their route and take the best offer from neighbours outside the subtree;
+    //  2. a cheaper road may give its far end a shorter route;
+    //  3. a Dijkstra pass spreads every improvement from those seeds.
+    // Children of x are found from x's own roads: y hangs below x exactly when y's parent
+    // road is one of x's roads. Incoming roads are the twins of outgoing ones (roads are two-way).
+    void repairTree(CostTree& tree, const vector<int>& changed, const vector<double>& oldCost) {
+        if ((int)repairMark.size() < cityCount + 1) repairMark.resize(cityCount + 1, 0);
+        if (++repairGeneration == 0) {
+            fill(repairMark.begin(), repairMark.end(), 0);
+            repairGeneration = 1;
+        }
+        unsigned mark = repairGeneration;
+
+        vector<int> cut;              // Cities whose tree route used a dearer road.
+        for (size_t k = 0; k < changed.size(); k++) {
+            int r = changed[k];
+            int v = edges[r].destination;
+            if (getEdgeCost(edges[r]) <= oldCost[k] || tree.parentRoad[v] != r || repairMark[v] == mark) continue;
+            size_t first = cut.size();
+            cut.push_back(v);
+            repairMark[v] = mark;
+            for (size_t idx = first; idx < cut.size(); idx++) { // Collects the whole subtree.
+                int x = cut[idx];
+                for (int i = edgeOffset[x]; i < edgeOffset[x + 1]; i++) {
+                    int y = edges[i].destination;
+                    if (tree.parentRoad[y] == i && repairMark[y] != mark) {
+                        repairMark[y] = mark;
+                        cut.push_back(y);
+                    }
+                }
+            }
+        }
+        for (int x : cut) {
+            tree.cost[x] = INF;
+            tree.parent[x] = -1;
+            tree.parentRoad[x] = -1;
+        }
+
+        priority_queue<PqNode, vector<PqNode>, greater<PqNode>> pq;
+        for (int x : cut) {           // Best offer from a neighbour that kept its route.
+            for (int i = edgeOffset[x]; i < edgeOffset[x + 1]; i++) {
+                int z = edges[i].destination;
+                int in = twinRoad[i];
+                if (in == -1 || tree.cost[z] == INF) continue;
+                double c = tree.cost[z] + getEdgeCost(edges[in]);
+                if (c < tree.cost[x]) {
+                    tree.cost[x] = c;
+                    tree.parent[x] = z;
+                    tree.parentRoad[x] = in;
+                }
+            }
+            if (tree.cost[x] != INF) pq.push({x, tree.cost[x]});
+        }
+        for (int r : changed) {       // Cheaper roads: the far end may improve.
+            int u = roadSource(r), v = edges[r].destination;
+            if (tree.cost[u] == INF) continue;
+            double c = tree.cost[u] + getEdgeCost(edges[r]);
+            if (c < tree.cost[v]) {
+                tree.cost[v] = c;
+                tree.parent[v] = u;
+                tree.parentRoad[v] = r;
+                pq.push({v, c});
+            }
+        }
+        while (!pq.empty()) {         // Spreads the improvements.
+            int x = pq.top().id;
+            double d = pq.top().timeCost;
+            pq.pop();
+            if (d > tree.cost[x]) continue;
+            for (int i = edgeOffset[x]; i < edgeOffset[x + 1]; i++) {
+                int y = edges[i].destination;
+                double c = d + getEdgeCost(edges[i]);
+                if (c < tree.cost[y]) {
+                    tree.cost[y] = c;
+                    tree.parent[y] = x;
+                    tree.parentRoad[y] = i;
+                    pq.push({y, c});
+                }
+            }
+        }
+    }
+
+    // Keeps the landmark tables usable after roads got cheaper. ALT only needs every table
+    // to satisfy d(L, y) <= d(L, x) + cost(x, y) on every road; a dearer road keeps that true
+    // (the bounds just get a little weaker), a cheaper one can break it at its far end, so
+    // the tables are lowered from there with a Dijkstra pass per landmark.
+    void lowerLandmarkTables(const vector<int>& changed) {
+        size_t k = landmarks.size();
+        if (k == 0 || landmarkDist.empty()) return;
+        priority_queue<PqNode, vector<PqNode>, greater<PqNode>> pq;
+        for (size_t i = 0; i < k; i++) {
+            auto table = [&](int v) -> double& { return landmarkDist[(size_t)v * k + i]; };
+            for (int r : changed) {
+                int u = roadSource(r), v = edges[r].destination;
+                if (table(u) == INF) continue;
+                double c = table(u) + getEdgeCost(edges[r]);
+                if (c < table(v)) {
+                    table(v) = c;
+                    pq.push({v, c});
+                }
+            }
+            while (!pq.empty()) {
+                int x = pq.top().id;
+                double d = pq.top().timeCost;
+                pq.pop();
+                if (d > table(x)) continue;
+                for (int j = edgeOffset[x]; j < edgeOffset[x + 1]; j++) {
+                    int y = edges[j].destination;
+                    double c = d + getEdgeCost(edges[j]);
+                    if (c < table(y)) {
+                        table(y) = c;
+                        pq.push({y, c});
+                    }
+                }
+            }
+        }
+    }
+
+    // Fills the legs and fuel cost of a found route from the road used for every leg.
+    // Time-dependent routes evaluate every road at the moment it is reached. The caller holds
+    // the shared traffic lock its search ran under, so the legs agree with the totals.
+    void fillLegs(RouteResult& result, const vector<int>& roads) {
+        result.legs.clear();
+        result.legs.reserve(roads.size());
+        double clock = result.departure; // Only used by time-dependent routes.
+        const VehicleProfile& vehicle = getVehicleProfile(result.vehicle);
+        const double* fuelPerKm = vehicle.litresPerKm(result.speed);
+        result.totalFuel = 0;     // Re-added in travel order for the vehicle actually driving.
+        for (size_t k = 0; k < roads.size(); k++) {
+            const Edge& edge = edges[roads[k]];
+            RouteLeg leg;
+            leg.from = result.route[k];
+            leg.to = result.route[k + 1];
+            leg.road = roads[k];
+            leg.traffic = edge.traffic;
+            leg.type = edge.type;
+            leg.distanceKM = edge.distanceKM;
+            leg.minutes = result.departure >= 0 ? getProfileTravelTime(edge, result.speed, clock) : getTravelTime(edge, result.speed);
+            leg.fuel = edge.distanceKM * fuelPerKm[edge.type];
+            clock += leg.minutes;
+            result.totalFuel = result.totalFuel + leg.fuel;
+            result.legs.push_back(leg);
+        }
+        result.fuelCost = result.totalFuel * vehicle.getFuelPrice();
+    }
+
+public:
+    // Constructor to initialize the RoutePlanner object.
+    // Passing false skips the built-in map (used when loading synthetic or imported maps).
+    RoutePlanner(bool loadDefaultMap = true) {
+        cityCount = 0;       // Starts the city count at 0.
+        heuristicScale = -1; // A* scale is computed on the first A* search.
+        landmarksReady = false;
+        landmarkStrategy = AVOID;
+        minEdgeCost = maxEdgeCost = 0;
+        treeCacheCapacity = 64;
+        treeCacheClock = 0;
+        repairGeneration = 0;
+        profileValues.assign(PROFILE_SLOTS, 0); // Profile 0 is "no profile".
+        if (loadDefaultMap) {
+            initializeMapData(); // Calls the function to load all hardcoded map data.
+            initializeTrafficProfiles(); // Rush-hour profiles for the busy roads.
+            buildLandmarks(4, AVOID); // Prepares the LANDMARKS mode once at startup.
+        }
+    }
+
+    // Returns the highest city ID in use.
+    int getCityCount() const { return cityCount; }
+
+    // Returns the number of directed roads in the compressed graph.
+    int getEdgeCount() { ensureGraphBuilt(); return (int)edges.size(); }
+
+    // Returns one directed road of the compressed graph (the index used by RouteLeg::road).
+    const Edge& getRoad(int road) { ensureGraphBuilt(); return edges[road]; }
+
+    // Returns the counters (settled cities, examined roads) of the calling thread's most recent search.
+    SearchStats getLastSearchStats() const { return getThreadWorkspace().stats; }
+
+    // Helper function: converts TrafficLevel enum to a numerical time multiplier.
+    double getTrafficMultiplier(TrafficLevel level) {
+        switch (level) {
+            case LOW: return 1.0;       // No delay.
+            case MODERATE: return 1.2;  // 20% slower.
+            case HIGH: return 1.5;      // 50% slower.
+            case JAMMED: return 2.5;    // 150% slower (2.5x time).
+            default: return 1.0;        // Default fallback is no delay.
+        }
+    }
+
+    // Helper function: turns minutes after midnight into "HH:MM" (with "+1d" on later days).
+    string formatClock(double minutes) {
+        int total = (int)floor(minutes + 0.5);
+        int days = total / 1440;
+        char text[32];
+        snprintf(text, sizeof(text), "%02d:%02d", total % 1440 / 60, total % 60);
+        return days > 0 ? string(text) + " +" + to_string(days) + "d" : string(text);
+    }
+
+    // Helper function: converts TrafficLevel enum to a readable string.
+    string getTrafficString(TrafficLevel level) {
+        switch (level) {
+            case LOW: return "Clear";       // Returns "Clear" text.
+            case MODERATE: return "Moderate"; // Returns "Moderate" text.
+            case HIGH: return "Heavy";        // Returns "Heavy" text.
+            case JAMMED: return "Jammed";     // Returns "Jammed" text.
+            default: return "Unknown";      // Default fallback text.
+        }
+    }
+
+    // Helper function: minutes needed to drive one road at the given speed, including traffic delay.
+    double getTravelTime(const Edge& edge, int speed) {
+        double multiplier = getTrafficMultiplier(edge.traffic); // Get traffic delay factor.
+        double baseTime = (edge.distanceKM / speed) * 60.0;     // (Distance / Speed) * 60 gives minutes.
+        return baseTime * multiplier;                           // Real time including traffic delay.
+    }
+
+    // Function to calculate fuel efficiency (km/L) of the standard petrol car based on speed
+    // and road type (see VehicleProfile for the curve and the other vehicles).
+    double calculateFuelEfficiency(int speed, RoadType type) {
+        return getVehicleProfile(PETROL_CAR).efficiency(speed, type);
+    }
+
+    // ==========================================
+    //      MAP DATA INITIALIZATION
+    // ==========================================
+    // Function to register a city name with an ID.
+    // Latitude and longitude (degrees) are optional; A* needs them for every city.
+    void addCity(int id, string name, double latitude = NAN, double longitude = NAN) {
+        if (id < 1) return;             // Checks if the ID is within the valid range.
+        if (id >= cityNames.size()) {
+            cityNames.resize(id + 1);   // Grows the name table on demand.
+            cityLat.resize(id + 1, NAN);
+            cityLon.resize(id + 1, NAN);
+        }
+        cityNames.set(id, name);        // Assigns the name to the table at the given index.
+        cityLat[id] = latitude;         // Stores the location of the city.
+        cityLon[id] = longitude;
+        cityCount = max(cityCount, id); // Updates total count to the highest ID used.
+        heuristicScale = -1;            // Locations changed, so the A* scale must be recomputed.
+    }
+
+    // Function to add a road (edge) between two cities.
+    // Roads are staged and compressed into the CSR arrays on the next search.
+    void addRoad(int u, int v, double dist, TrafficLevel traf, RoadType type, string name) {
+        if (u < 1 || v < 1 || u > cityCount || v > cityCount) return; // Ignores roads to unknown cities.
+        int nameId = internRoadName(name);           // Both directions share one stored name.
+        double cost = dist * getTrafficMultiplier(traf); // Precomputed speed-independent weight.
+        // Adds connection from City U to City V.
+        pending.push_back({u, {v, traf, type, 0, dist, cost}, nameId});
+        // Adds connection from City V to City U (since roads are two-way).
+        pending.push_back({v, {u, traf, type, 0, dist, cost}, nameId});
+    }
+
+    // Function to hardcode all the cities and roads into the system.
+    void initializeMapData() {
+        // 1. Define Cities (ID, Name, Latitude, Longitude)
+        addCity(1, "Karachi", 24.8607, 67.0011);      // Adds Karachi as City 1.
+        addCity(2, "Hyderabad", 25.3960, 68.3578);    // Adds Hyderabad as City 2.
+        addCity(3, "Sukkur", 27.7052, 68.8574);       // Adds Sukkur as City 3.
+        addCity(4, "Multan", 30.1575, 71.5249);       // Adds Multan as City 4.
+        addCity(5, "Faisalabad", 31.4504, 73.1350);   // Adds Faisalabad as City 5.
+        addCity(6, "Lahore", 31.5204, 74.3587);       // Adds Lahore as City 6.
+        addCity(7, "Islamabad", 33.6844, 73.0479);    // Adds Islamabad as City 7.
+        addCity(8, "Peshawar", 34.0151, 71.5249);     // Adds Peshawar as City 8.
+        addCity(9, "Quetta", 30.1798, 66.9750);       // Adds Quetta as City 9.
+        addCity(10, "Gwadar", 25.1216, 62.3254);      // Adds Gwadar as City 10.
+        addCity(11, "Sialkot", 32.4945, 74.5229);     // Adds Sialkot as City 11.
+        addCity(12, "Abbottabad", 34.1688, 73.2215);  // Adds Abbottabad as City 12.
+        addCity(13, "Gilgit", 35.9208, 74.3080);      // Adds Gilgit as City 13.
+        addCity(14, "Sahiwal", 30.6682, 73.1114);     // Adds Sahiwal as City 14.
+        addCity(15, "Bahawalpur", 29.3544, 71.6911);  // Adds Bahawalpur as City 15.
+
+        // 2. Define Roads (Source, Dest, Dist, Traffic, Type, Name)
+        
+        // South Corridor
+        addRoad(1, 2, 165, JAMMED, MOTORWAY, "M-9 Motorway"); // Adds M-9 from Karachi to Hyd.
+        addRoad(2, 3, 330, MODERATE, HIGHWAY, "N-5 National Hwy"); // Adds N-5 from Hyd to Sukkur.
+        addRoad(3, 4, 420, LOW, MOTORWAY, "M-5 Sukkur-Multan"); // Adds M-5 from Sukkur to Multan.
+        addRoad(3, 9, 390, LOW, HIGHWAY, "N-65 Highway"); // Adds N-65 from Sukkur to Quetta.
+        
+        // Central Corridor
+        addRoad(4, 5, 240, LOW, MOTORWAY, "M-4 Motorway"); // Adds M-4 from Multan to Faisalabad.
+        addRoad(4, 15, 90, MODERATE, HIGHWAY, "N-5 Lodhran"); // Adds road from Multan to Bahawalpur.
+        addRoad(15, 3, 300, LOW, HIGHWAY, "N-5 South"); // Adds road from BWP to Sukkur.
+        addRoad(4, 14, 180, MODERATE, HIGHWAY, "N-5 GT Road"); // Adds road from Multan to Sahiwal.
+        addRoad(14, 6, 170, HIGH, HIGHWAY, "N-5 Okara"); // Adds road from Sahiwal to Lahore.
+
+        // Punjab Grid
+        addRoad(5, 6, 150, HIGH, MOTORWAY, "M-3 Motorway"); // Adds M-3 from Fsd to Lahore.
+        addRoad(5, 7, 320, LOW, MOTORWAY, "M-4 (Goa-Pindi)"); // Adds M-4 from Fsd to Islamabad.
+        addRoad(6, 7, 375, MODERATE, MOTORWAY, "M-2 Motorway"); // Adds M-2 from Lahore to Islamabad.
+        addRoad(6, 11, 130, MODERATE, MOTORWAY, "M-11 Sialkot"); // Adds M-11 from Lahore to Sialkot.
+        
+        // North Corridor
+        addRoad(7, 8, 180, LOW, MOTORWAY, "M-1 Motorway"); // Adds M-1 from Islamabad to Peshawar.
+        addRoad(7, 12, 120, HIGH, HIGHWAY, "N-35 Karakoram"); // Adds N-35 from Isb to Abbottabad.
+        addRoad(12, 13, 450, HIGH, HIGHWAY, "KKH (Hazara)"); // Adds KKH from Abbottabad to Gilgit.
+
+        // West Corridor
+        addRoad(1, 10, 650, LOW, HIGHWAY, "N-10 Coastal Hwy"); // Adds Coastal Hwy from Karachi to Gwadar.
+        addRoad(10, 9, 920, LOW, HIGHWAY, "N-85 Highway"); // Adds N-85 from Gwadar to Quetta.
+        addRoad(9, 8, 800, LOW, HIGHWAY, "N-50 Zhob Route"); // Adds N-50 from Quetta to Peshawar.
+    }
+
+    // Builds a daily profile that is clear at night and reaches 'peak' in the morning
+    // (around 8:30) and evening (around 18:00) rush hours.
+    vector<double> makeRushHourProfile(double peak) {
+        vector<double> multipliers(PROFILE_SLOTS);
+        for (int k = 0; k < PROFILE_SLOTS; k++) {
+            double hour = k * PROFILE_SLOT_MINUTES / 60.0;
+            double morning = exp(-pow((hour - 8.5) / 1.5, 2));  // Bell curve around 8:30.
+            double evening = exp(-pow((hour - 18.0) / 2.0, 2)); // Wider bell curve around 18:00.
+            multipliers[k] = 1.0 + (peak - 1.0) * max(morning, evening);
+        }
+        return multipliers;
+    }
+
+    // Gives every busy road of the built-in map a rush-hour profile whose peak is its static
+    // traffic level, so the static level describes the rush hour and nights are clear.
+    // Roads with the same level share one profile.
+    void initializeTrafficProfiles() {
+        ensureGraphBuilt();
+        for (Edge& edge : edges) {
+            if (edge.traffic == LOW) continue; // Clear roads stay clear all day.
+            edge.profileId = (unsigned short)addTrafficProfile(makeRushHourProfile(getTrafficMultiplier(edge.traffic)));
+        }
+    }
+
+    // ==========================================
+    //      MAIN ALGORITHM (DIJKSTRA)
+    // ==========================================
+    // Runs Dijkstra from startNode in the given workspace without printing anything.
+    // Stops once endNode is settled (pass -1 to settle every reachable city).
+    // Queue picks the priority queue backend (see PRIORITY QUEUE BACKENDS).
+    template <typename Queue = BinaryHeapQueue>
+    void runDijkstra(int startNode, int endNode, int speed, QueryWorkspace& ws) {
+        ensureGraphBuilt(); // Compresses any newly added roads first.
+
+        // DP Arrays and Priority Queue setup (O(1): old entries are invalidated by generation).
+        ws.begin(cityCount);
+        Queue& pq = getThreadQueue<Queue>(); // Queue kept between queries on this thread.
+        pq.reset(cityCount, minEdgeCost * 60.0 / speed, maxEdgeCost * 60.0 / speed);
+
+        // Initialize Start Node
+        ws.touch(startNode);
+        ws.minTime[startNode] = 0;       // Time to reach start node is 0.
+        pq.push(startNode, 0);           // Adds start node to the queue.
+        const double* fuelPerKm = getVehicleProfile(PETROL_CAR).litresPerKm(speed); // Litres per km by road type.
+        METRIC(ws.stats.heapPushes++);
+
+        // Loop until there are no more nodes to process.
+        while (!pq.empty()) {
+            PqNode top = pq.pop();       // Takes the city with the lowest time cost.
+            int u = top.id;
+            double currentTime = top.timeCost;
+
+            if constexpr (!Queue::EXACT) {
+                // Quantised queue: the destination is final once the queue is past its quantum.
+                if (endNode != -1 && ws.timeOf(endNode) != INF &&
+                    pq.quantise(currentTime) > pq.quantise(ws.minTime[endNode])) break;
+            }
+            // Optimization: If we found a faster way to 'u' previously, skip this one.
+            if (currentTime > ws.minTime[u]) { METRIC(ws.stats.stalePops++); continue; }
+            ws.stats.settledNodes++;     // 'u' is expanded with its best time so far.
+            if (Queue::EXACT && u == endNode) break; // The destination is final: no need to go further.
+
+            // Iterate through all roads connected to the current city 'u' (one contiguous slice).
+            for (int i = edgeOffset[u]; i < edgeOffset[u + 1]; i++) {
+                const Edge& edge = edges[i]; // Current road in the CSR array.
+                int v = edge.destination;    // Get the neighbor city ID.
+                ws.stats.relaxedEdges++;     // Counts the road as examined.
+                ws.touch(v);                 // Makes sure v's entries belong to this query.
+                
+                // --- PHYSICS LOGIC START ---
+                // Calculates real time: (Distance / Speed) * 60 minutes, times the traffic delay.
+                double realTime = getTravelTime(edge, speed);
+
+                // Relaxation Step: Check if this new path is faster than the known path.
+                if (ws.minTime[u] + realTime < ws.minTime[v]) {
+                    ws.minTime[v] = ws.minTime[u] + realTime; // Update shortest time to v.
+                    ws.parent[v] = u;                         // Set u as the parent of v (for path rebuilding).
+                    ws.viaEdge[v] = i;                        // Remember which road was used.
+                    ws.pathDist[v] = ws.pathDist[u] + edge.distanceKM; // Update total distance to v.
+                    
+                    // Add this segment's fuel usage (one table read for its road type) to the total so far.
+                    ws.fuelConsumed[v] = ws.fuelConsumed[u] + edge.distanceKM * fuelPerKm[edge.type];
+                    
+                    pq.push(v, ws.minTime[v]); // Add v to the queue to explore its neighbors.
+                    METRIC(ws.stats.heapPushes++);
+                }
+                // --- PHYSICS LOGIC END ---
+            }
+        }
+    }
+
+    // Runs Dijkstra from startNode over the whole graph and copies the four DP arrays out.
+    // Used by the one-to-all benchmarks and checks.
+    template <typename Queue = BinaryHeapQueue>
+    void computeShortestPaths(int startNode, int speed, vector<double>& minTime, vector<int>& parent,
+                              vector<double>& fuelConsumed, vector<double>& pathDist) {
+        QueryWorkspace& ws = getThreadWorkspace();
+        runDijkstra<Queue>(startNode, -1, speed, ws);
+        minTime.assign(cityCount + 1, INF);
+        parent.assign(cityCount + 1, -1);
+        fuelConsumed.assign(cityCount + 1, 0.0);
+        pathDist.assign(cityCount + 1, 0.0);
+        for (int v = 0; v <= cityCount; v++) {
+            if (ws.timeOf(v) == INF) continue;
+            minTime[v] = ws.minTime[v];
+            parent[v] = ws.parent[v];
+            fuelConsumed[v] = ws.fuelConsumed[v];
+            pathDist[v] = ws.pathDist[v];
+        }
+    }
+
+    // Walks the parent links of a finished search from endNode back to startNode and
+    // returns the cities (in travel order) and the road used for every leg.
+    void traceRoute(const QueryWorkspace& ws, int startNode, int endNode, vector<int>& route, vector<int>& roads) {
+        route.clear();
+        roads.clear();
+        for (int v = endNode; v != startNode; v = ws.parent[v]) {
+            route.push_back(v);
+            roads.push_back(ws.viaEdge[v]);
+        }
+        route.push_back(startNode);
+        reverse(route.begin(), route.end());
+        reverse(roads.begin(), roads.end());
+    }
+
+    // Runs point-to-point Dijkstra and returns the route and totals of the destination.
+    template <typename Queue = BinaryHeapQueue>
+    bool computeDijkstraRoute(int startNode, int endNode, int speed, vector<int>& route,
+                              double& totalTime, double& totalDist, double& totalFuel, vector<int>* roadsOut = nullptr) {
+        if (startNode < 1 || startNode > cityCount || endNode < 1 || endNode > cityCount) return false;
+        QueryWorkspace& ws = getThreadWorkspace();
+        runDijkstra<Queue>(startNode, endNode, speed, ws);
+        route.clear();
+        vector<int> localRoads;
+        vector<int>& roads = roadsOut ? *roadsOut : localRoads; // Road index used for every leg.
+        roads.clear();
+        if (ws.timeOf(endNode) == INF) return false;
+        traceRoute(ws, startNode, endNode, route, roads);
+        totalTime = ws.minTime[endNode];
+        totalDist = ws.pathDist[endNode];
+        totalFuel = ws.fuelConsumed[endNode];
+        return true;
+    }
+
+    // ==========================================
+    //      SPEED-INVARIANT TREE CACHE
+    // ==========================================
+    // A road's time is its cost x 60 / speed, so the speed scales every road alike and the
+    // fastest route does not depend on it (only the fuel per km does). The shortest-path tree
+    // of a start city is therefore built once on the cost and kept; time, distance and fuel
+    // for any speed come from walking the route back through the tree. Queries from a cached
+    // start city do no search at all.
+    bool computeCachedRoute(int startNode, int endNode, int speed, vector<int>& route,
+                            double& totalTime, double& totalDist, double& totalFuel, vector<int>* roadsOut = nullptr) {
+        ensureGraphBuilt();
+        shared_lock<WriterFirstMutex> trafficLock(trafficMutex); // Traffic can't change mid-query.
+        return computeCachedRouteLocked(startNode, endNode, speed, route, totalTime, totalDist, totalFuel, roadsOut);
+    }
+
+    // computeCachedRoute for a caller that already holds the shared traffic lock.
+    bool computeCachedRouteLocked(int startNode, int endNode, int speed, vector<int>& route,
+                                  double& totalTime, double& totalDist, double& totalFuel, vector<int>* roadsOut = nullptr) {
+        route.clear();
+        vector<int> localRoads;
+        vector<int>& roads = roadsOut ? *roadsOut : localRoads; // Road index used for every leg.
+        roads.clear();
+        if (startNode < 1 || startNode > cityCount || endNode < 1 || endNode > cityCount) return false;
+        SearchStats& stats = getThreadWorkspace().stats;
+        stats = SearchStats();        // Stays zero when the tree is already cached.
+
+        bool found = false;
+        {
+            lock_guard<mutex> lock(treeCacheMutex);
+            auto it = treeCache.find(startNode);
+            if (it != treeCache.end()) {
+                it->second.lastUse = ++treeCacheClock;
+                if (!walkTree(it->second, startNode, endNode, route, roads)) return false;
+                found = true;
+            }
+        }
+        if (!found) {
+            // Builds the tree outside the lock so other threads keep answering from the cache.
+            CostTree tree;
+            computeCostDistances(startNode, tree.cost, tree.parent, nullptr, &tree.parentRoad, &stats);
+            bool reachable = walkTree(tree, startNode, endNode, route, roads);
+
+            lock_guard<mutex> lock(treeCacheMutex);
+            if (treeCacheCapacity > 0) {
+                if (treeCache.size() >= treeCacheCapacity) { // Drops the least recently used tree.
+                    auto oldest = treeCache.begin();
+                    for (auto it = treeCache.begin(); it != treeCache.end(); it++) {
+                        if (it->second.lastUse < oldest->second.lastUse) oldest = it;
+                    }
+                    treeCache.erase(oldest);
+                }
+                tree.lastUse = ++treeCacheClock;
+                treeCache[startNode] = std::move(tree);
+            }
+            if (!reachable) return false;
+        }
+        accumulateRoute(roads, speed, totalTime, totalDist, totalFuel);
+        return true;
+    }
+
+    // Sets how many start cities keep their tree (0 turns the cache off).
+    void setTreeCacheCapacity(size_t capacity) {
+        lock_guard<mutex> lock(treeCacheMutex);
+        treeCacheCapacity = capacity;
+        while (treeCache.size() > capacity) treeCache.erase(treeCache.begin());
+    }
+
+    // ==========================================
+    //      LIVE TRAFFIC UPDATES
+    // ==========================================
+    // Returns the index of the first road from 'from' to 'to' (-1 if there is none).
+    // Road indices stay valid until new roads are added.
+    int findRoad(int from, int to) {
+        ensureGraphBuilt();
+        if (from < 1 || from > cityCount) return -1;
+        for (int i = edgeOffset[from]; i < edgeOffset[from + 1]; i++) {
+            if (edges[i].destination == to) return i;
+        }
+        return -1;
+    }
+
+    // Returns the name of a road.
+    string getRoadName(int road) { ensureGraphBuilt(); return roadNames[edgeNameId[road]]; }
+
+    // Returns the number of distinct road names stored.
+    int getRoadNameCount() const { return roadNames.size(); }
+
+    // Changes the traffic on a road (both directions) while queries may be running on other
+    // threads. Cached state is repaired instead of rebuilt:
+    //  - cached speed-invariant trees are repaired in place (see repairTree);
+    //  - landmark tables are lowered where the road got cheaper (see lowerLandmarkTables);
+    //  - the bucket-queue cost range is widened if needed.
+    // The contraction hierarchy can't be repaired this way (a dearer road may break a
+    // witness path that made a shortcut unnecessary), so it is dropped and rebuilt on next use
+    // (by one query, through buildOnce).
+    // Returns false for an unknown road index.
+    bool updateTraffic(int road, TrafficLevel level) {
+        ensureGraphBuilt();
+        unique_lock<WriterFirstMutex> trafficLock(trafficMutex); // Waits for running queries to finish.
+        if (road < 0 || road >= (int)edges.size()) return false;
+        if (edges[road].traffic == level) return true;
+
+        vector<int> changed(1, road); // The road and its opposite direction.
+        if (twinRoad[road] != -1) changed.push_back(twinRoad[road]);
+        vector<double> oldCost;
+        for (int r : changed) {
+            oldCost.push_back(getEdgeCost(edges[r]));
+            edges[r].traffic = level;
+            edges[r].cost = edges[r].distanceKM * getTrafficMultiplier(level);
+        }
+        double cost = getEdgeCost(edges[road]);
+        if (cost > 0 && (minEdgeCost == 0 || cost < minEdgeCost)) minEdgeCost = cost;
+        maxEdgeCost = max(maxEdgeCost, cost);
+
+        hierarchy.clear();
+        overlay.customizeRoad(roadSource(road), edges[road].destination, edgeOffset, edges);
+        {
+            lock_guard<mutex> cacheLock(treeCacheMutex);
+            for (auto& entry : treeCache) repairTree(entry.second, changed, oldCost);
+        }
+        if (cost < oldCost[0]) lowerLandmarkTables(changed);
+        return true;
+    }
+
+    // ==========================================
+    //      BINARY GRAPH FILES
+    // ==========================================
+    // Writes the whole map (CSR arrays, road details, names, locations and traffic
+    // profiles) as a binary graph file that loadBinaryGraph can use in place.
+    // Layout: a GraphFileHeader, then every section on a 64-byte boundary. Returns false if
+    // the file can't be written.
+    bool saveBinaryGraph(const string& path) {
+        ensureGraphBuilt();
+        shared_lock<WriterFirstMutex> trafficLock(trafficMutex);
+        GraphFileHeader header;
+        memset(&header, 0, sizeof(header));
+        memcpy(header.magic, "RPGRAPH", 8);
+        header.version = GRAPH_FORMAT_VERSION;
+        header.byteOrder = 0x01020304;
+        header.edgeBytes = sizeof(Edge);
+        header.profileSlots = PROFILE_SLOTS;
+        header.cityCount = cityCount;
+        header.roadCount = edges.size();
+        header.minEdgeCost = minEdgeCost;
+        header.maxEdgeCost = maxEdgeCost;
+
+        // Copies of the name offsets padded to one entry per city (cities may have no name yet).
+        NameTable names = cityNames;
+        names.resize(cityCount + 1);
+        const void* data[GRAPH_SECTION_COUNT] = {
+            edgeOffset.data(), edges.data(), edgeNameId.data(), twinRoad.data(),
+            cityLat.data(), cityLon.data(), names.starts().data(), names.characters().data(),
+            roadNames.starts().data(), roadNames.characters().data(), profileValues.data()};
+        size_t bytes[GRAPH_SECTION_COUNT] = {
+            edgeOffset.size() * sizeof(int), edges.size() * sizeof(Edge), edgeNameId.size() * sizeof(int),
+            twinRoad.size() * sizeof(int), cityLat.size() * sizeof(double), cityLon.size() * sizeof(double),
+            names.starts().size() * sizeof(unsigned), names.characters().size(),
+            roadNames.starts().size() * sizeof(unsigned), roadNames.characters().size(), profileValues.size()};
+        unsigned long long offset = sizeof(GraphFileHeader);
+        for (int k = 0; k < GRAPH_SECTION_COUNT; k++) {
+            offset = (offset + 63) / 64 * 64;
+            header.sectionOffset[k] = offset;
+            header.sectionBytes[k] = bytes[k];
+            offset += bytes[k];
+        }
+
+        ofstream out(path, ios::binary);
+        if (!out) return false;
+        out.write((const char*)&header, sizeof(header));
+        const char padding[64] = {};
+        unsigned long long written = sizeof(header);
+        for (int k = 0; k < GRAPH_SECTION_COUNT; k++) {
+            out.write(padding, header.sectionOffset[k] - written);
+            if (bytes[k] > 0) out.write((const char*)data[k], bytes[k]);
+            written = header.sectionOffset[k] + bytes[k];
+        }
+        return (bool)out;
+    }
+
+    // Checks every index stored in a mapped graph file before the searches follow it: the
+    // offsets rise from 0 to the road count, and road targets, twins, name ids, profile ids,
+    // name offsets and costs are all in range. 'base' is the start of the mapped file.
+    static bool graphFileValid(const GraphFileHeader& header, const char* base) {
+        int cities = header.cityCount;
+        size_t roads = (size_t)header.roadCount;
+        auto section = [&](int k) { return base + header.sectionOffset[k]; };
+        const int* offset = (const int*)section(SECTION_OFFSETS);
+        const Edge* edge = (const Edge*)section(SECTION_EDGES);
+        const int* nameId = (const int*)section(SECTION_NAME_IDS);
+        const int* twin = (const int*)section(SECTION_TWINS);
+        size_t roadNameCount = header.sectionBytes[SECTION_ROAD_NAME_STARTS] / sizeof(unsigned);
+        roadNameCount = roadNameCount == 0 ? 0 : roadNameCount - 1;
+        size_t profileCount = header.sectionBytes[SECTION_PROFILES] / PROFILE_SLOTS;
+        if (!(header.minEdgeCost >= 0) || !(header.maxEdgeCost >= header.minEdgeCost)) return false;
+
+        if (offset[0] != 0 || (size_t)offset[cities + 1] != roads) return false;
+        for (int v = 0; v <= cities; v++) {
+            if (offset[v + 1] < offset[v]) return false;
+        }
+        for (size_t e = 0; e < roads; e++) {
+            const Edge& road = edge[e];
+            if (road.destination < 1 || road.destination > cities || road.traffic > JAMMED ||
+                road.type >= ROAD_TYPE_COUNT || road.profileId >= profileCount ||
+                !(road.distanceKM >= 0) || !(road.cost >= 0) || road.cost > header.maxEdgeCost) return false;
+            if (nameId[e] < 0 || (size_t)nameId[e] >= roadNameCount) return false;
+            if (twin[e] < -1 || (twin[e] >= 0 && (size_t)twin[e] >= roads)) return false;
+        }
+
+        // Both name tables: offsets rise and end inside the character section.
+        int tables[2][2] = {{SECTION_CITY_NAME_STARTS, SECTION_CITY_NAME_CHARS},
+                            {SECTION_ROAD_NAME_STARTS, SECTION_ROAD_NAME_CHARS}};
+        for (auto& table : tables) {
+            const unsigned* start = (const unsigned*)section(table[0]);
+            size_t count = header.sectionBytes[table[0]] / sizeof(unsigned);
+            for (size_t k = 0; k < count; k++) {
+                if ((k > 0 && start[k] < start[k - 1]) || start[k] > header.sectionBytes[table[1]]) return false;
+            }
+        }
+        return true;
+    }
+
+    // Replaces the current map with a binary graph file written by saveBinaryGraph. The file
+    // is memory-mapped and every array views it directly: nothing is parsed or copied. The
+    // header, the section sizes and every stored index are checked first (graphFileValid),
+    // which reads the file once; after that the arrays are used in place.
+    // Returns false (leaving the current map untouched) if the file is missing, was written
+    // by another format version or machine layout, is cut short or holds out-of-range data.
+    bool loadBinaryGraph(const string& path) {
+        MappedFile file;
+        if (!file.open(path) || file.size() < sizeof(GraphFileHeader)) return false;
+        GraphFileHeader header;
+        memcpy(&header, file.data(), sizeof(header));
+        if (memcmp(header.magic, "RPGRAPH", 8) != 0 || header.version != GRAPH_FORMAT_VERSION ||
+            header.byteOrder != 0x01020304 || header.edgeBytes != sizeof(Edge) ||
+            header.profileSlots != (unsigned)PROFILE_SLOTS || header.cityCount < 0 ||
+            header.cityCount >= INT_MAX - 1 || header.roadCount > (unsigned long long)INT_MAX) return false;
+
+        size_t cities = (size_t)header.cityCount, roads = (size_t)header.roadCount;
+        size_t expected[GRAPH_SECTION_COUNT] = {
+            (cities + 2) * sizeof(int), roads * sizeof(Edge), roads * sizeof(int), roads * sizeof(int),
+            (cities + 1) * sizeof(double), (cities + 1) * sizeof(double), (cities + 2) * sizeof(unsigned), 0,
+            0, 0, 0};
+        for (int k = 0; k < GRAPH_SECTION_COUNT; k++) {
+            if (header.sectionOffset[k] % 64 != 0 || header.sectionOffset[k] > file.size() ||
+                header.sectionBytes[k] > file.size() - header.sectionOffset[k]) return false;
+            if (expected[k] != 0 && header.sectionBytes[k] != expected[k]) return false;
+        }
+        if (header.sectionBytes[SECTION_ROAD_NAME_STARTS] % sizeof(unsigned) != 0 ||
+            header.sectionBytes[SECTION_PROFILES] == 0 || header.sectionBytes[SECTION_PROFILES] % PROFILE_SLOTS != 0) return false;
+        if (!graphFileValid(header, file.data())) return false;
+
+        unique_lock<WriterFirstMutex> trafficLock(trafficMutex);
+        char* base = file.data();
+        auto section = [&](int k) { return base + header.sectionOffset[k]; };
+        edgeOffset.view((int*)section(SECTION_OFFSETS), cities + 2);
+        edges.view((Edge*)section(SECTION_EDGES), roads);
+        edgeNameId.view((int*)section(SECTION_NAME_IDS), roads);
+        twinRoad.view((int*)section(SECTION_TWINS), roads);
+        cityLat.view((double*)section(SECTION_LATITUDES), cities + 1);
+        cityLon.view((double*)section(SECTION_LONGITUDES), cities + 1);
+        cityNames.starts().view((unsigned*)section(SECTION_CITY_NAME_STARTS), cities + 2);
+        cityNames.characters().view(section(SECTION_CITY_NAME_CHARS), header.sectionBytes[SECTION_CITY_NAME_CHARS]);
+        roadNames.starts().view((unsigned*)section(SECTION_ROAD_NAME_STARTS),
+                                header.sectionBytes[SECTION_ROAD_NAME_STARTS] / sizeof(unsigned));
+        roadNames.characters().view(section(SECTION_ROAD_NAME_CHARS), header.sectionBytes[SECTION_ROAD_NAME_CHARS]);
+        profileValues.view((unsigned char*)section(SECTION_PROFILES), header.sectionBytes[SECTION_PROFILES]);
+        graphFile.swap(file);         // The old mapping (if any) is released when 'file' goes away.
+
+        cityCount = header.cityCount;
+        minEdgeCost = header.minEdgeCost;
+        maxEdgeCost = header.maxEdgeCost;
+        vector<PendingRoad>().swap(pending);
+        roadNameIndex.clear();        // Both indexes are rebuilt when the next name or profile is added.
+        profileIndex.clear();
+        heuristicScale = -1;          // Everything derived from the old map is out of date.
+        hierarchy.clear();
+        overlay.clear();
+        landmarks.clear();
+        landmarkDist.clear();
+        landmarksReady = false;
+        {
+            lock_guard<mutex> cacheLock(treeCacheMutex);
+            treeCache.clear();
+        }
+        return true;
+    }
+
+    // Returns true if the map currently in use views a mapped graph file.
+    bool isGraphMapped() { return graphFile.size() > 0; }
+
+    // ==========================================
+    //      TIME-DEPENDENT TRAFFIC
+    // ==========================================
+    // A profile gives a road's traffic multiplier over the day: PROFILE_SLOTS breakpoints,
+    // shared by all profiles, with straight lines between them (wrapping at midnight). Each
+    // value is stored in one byte as 1 + value x PROFILE_STEP (1.0 .. 4.98), and equal
+    // profiles are stored once, so a road only carries a 2-byte profile id.
+    // Registers a profile of PROFILE_SLOTS multipliers and returns its id (equal profiles share one id).
+    int addTrafficProfile(const vector<double>& multipliers) {
+        if ((int)multipliers.size() != PROFILE_SLOTS) return 0;
+        string key(PROFILE_SLOTS, '\0');
+        for (int k = 0; k < PROFILE_SLOTS; k++) {
+            double steps = round((multipliers[k] - 1.0) / PROFILE_STEP);
+            key[k] = (char)(unsigned char)max(0.0, min(255.0, steps));
+        }
+        int stored = (int)(profileValues.size() / PROFILE_SLOTS);
+        if ((int)profileIndex.size() != stored - 1) { // Profiles came from a graph file.
+            profileIndex.clear();
+            for (int k = 1; k < stored; k++) {
+                profileIndex[string((const char*)&profileValues[(size_t)k * PROFILE_SLOTS], PROFILE_SLOTS)] = k;
+            }
+        }
+        auto found = profileIndex.find(key);
+        if (found != profileIndex.end()) return found->second;
+        int id = stored;
+        if (id > 65535) return 0;     // Ids must fit in Edge::profileId.
+        profileValues.append((const unsigned char*)key.data(), (const unsigned char*)key.data() + key.size());
+        profileIndex[key] = id;
+        return id;
+    }
+
+    // Attaches a profile to a road (both directions). Profile 0 removes it.
+    bool setRoadProfile(int road, int profileId) {
+        ensureGraphBuilt();
+        unique_lock<WriterFirstMutex> trafficLock(trafficMutex);
+        if (road < 0 || road >= (int)edges.size()) return false;
+        if (profileId < 0 || profileId >= (int)(profileValues.size() / PROFILE_SLOTS)) return false;
+        edges[road].profileId = (unsigned short)profileId;
+        if (twinRoad[road] != -1) edges[twinRoad[road]].profileId = (unsigned short)profileId;
+        return true;
+    }
+
+    // Returns the number of distinct profiles and the bytes they take.
+    int getProfileCount() const { return (int)(profileValues.size() / PROFILE_SLOTS) - 1; }
+    size_t getProfileBytes() const { return profileValues.size(); }
+
+    // Minutes needed to drive a road when entering it at 'departure' (minutes after midnight,
+    // may run past one day). A road without a profile takes getTravelTime all day.
+    // With a profile the car drives at speed / m(t), where m is the profile multiplier at the
+    // moment t, and the time is found by integrating that over the slots it crosses. On a
+    // straight piece m(t) = m0 + b(t - t0) the distance covered is speed x ln(m1 / m0) / b, so
+    // every slot is solved exactly. Cars can't overtake each other in this model, so leaving
+    // later never means arriving earlier (FIFO), which keeps time-dependent Dijkstra exact.
+    double getProfileTravelTime(const Edge& edge, int speed, double departure) {
+        if (edge.profileId == 0) return getTravelTime(edge, speed);
+        const unsigned char* values = &profileValues[(size_t)edge.profileId * PROFILE_SLOTS];
+        double rate = speed / 60.0;   // Km per minute at multiplier 1.
+        double remaining = edge.distanceKM;
+        double clock = fmod(departure, 1440.0);
+        if (clock < 0) clock += 1440.0;
+        double elapsed = 0;
+        while (true) {
+            int k = min(PROFILE_SLOTS - 1, (int)(clock / PROFILE_SLOT_MINUTES));
+            double slotEnd = (k + 1) * PROFILE_SLOT_MINUTES;
+            double left = 1 + values[k] * PROFILE_STEP;
+            double right = 1 + values[(k + 1) % PROFILE_SLOTS] * PROFILE_STEP;
+            double b = (right - left) / PROFILE_SLOT_MINUTES; // Slope of the multiplier.
+            double m0 = left + b * (clock - k * PROFILE_SLOT_MINUTES); // Multiplier right now.
+            double span = slotEnd - clock;
+            double x = b * span / m0;     // Relative change of the multiplier until the slot ends.
+            double reach = fabs(x) < 1e-12 ? rate * span / m0 : rate * log1p(x) / b;
+            if (reach >= remaining) {     // The road ends inside this slot.
+                double y = b * remaining / rate;
+                return elapsed + (fabs(y) < 1e-12 ? remaining * m0 / rate : m0 * expm1(y) / b);
+            }
+            remaining -= reach;
+            elapsed += span;
+            clock = slotEnd >= 1440.0 ? 0 : slotEnd;
+        }
+    }
+
+    // Time-dependent Dijkstra: every road is evaluated at the moment the car reaches it.
+    // 'departure' is minutes after midnight; totalTime is the trip length in minutes.
+    bool computeTimeDependentRoute(int startNode, int endNode, int speed, double departure, vector<int>& route,
+                                   double& totalTime, double& totalDist, double& totalFuel, vector<int>* roadsOut = nullptr) {
+        ensureGraphBuilt();
+        shared_lock<WriterFirstMutex> trafficLock(trafficMutex); // Traffic can't change mid-query.
+        return computeTimeDependentRouteLocked(startNode, endNode, speed, departure, route, totalTime, totalDist, totalFuel, roadsOut);
+    }
+
+    // computeTimeDependentRoute for a caller that already holds the shared traffic lock.
+    bool computeTimeDependentRouteLocked(int startNode, int endNode, int speed, double departure, vector<int>& route,
+                                         double& totalTime, double& totalDist, double& totalFuel, vector<int>* roadsOut = nullptr) {
+        QueryWorkspace& ws = getThreadWorkspace();
+        ws.begin(cityCount);
+        vector<PqNode>& pq = ws.heap; // Ordered by time since departure.
+        route.clear();
+        if (startNode < 1 || startNode > cityCount || endNode < 1 || endNode > cityCount) return false;
+
+        ws.touch(startNode);
+        ws.minTime[startNode] = 0;
+        pq.push_back({startNode, 0});
+        METRIC(ws.stats.heapPushes++);
+        const double* fuelPerKm = getVehicleProfile(PETROL_CAR).litresPerKm(speed);
+        while (!pq.empty()) {
+            pop_heap(pq.begin(), pq.end(), greater<PqNode>());
+            int u = pq.back().id;
+            double currentTime = pq.back().timeCost;
+            pq.pop_back();
+            if (currentTime > ws.minTime[u]) { METRIC(ws.stats.stalePops++); continue; }
+            ws.stats.settledNodes++;
+            if (u == endNode) break;
+
+            for (int i = edgeOffset[u]; i < edgeOffset[u + 1]; i++) {
+                const Edge& edge = edges[i];
+                int v = edge.destination;
+                ws.stats.relaxedEdges++;
+                ws.touch(v);
+                double arrival = currentTime + getProfileTravelTime(edge, speed, departure + currentTime);
+                if (arrival < ws.minTime[v]) {
+                    ws.minTime[v] = arrival;
+                    ws.parent[v] = u;
+                    ws.viaEdge[v] = i;
+                    ws.pathDist[v] = ws.pathDist[u] + edge.distanceKM;
+                    ws.fuelConsumed[v] = ws.fuelConsumed[u] + edge.distanceKM * fuelPerKm[edge.type];
+                    pq.push_back({v, arrival});
+                    push_heap(pq.begin(), pq.end(), greater<PqNode>());
+                    METRIC(ws.stats.heapPushes++);
+                }
+            }
+        }
+        vector<int> localRoads;
+        vector<int>& roads = roadsOut ? *roadsOut : localRoads; // Road index used for every leg.
+        roads.clear();
+        if (ws.timeOf(endNode) == INF) return false;
+        traceRoute(ws, startNode, endNode, route, roads);
+        totalTime = ws.minTime[endNode];
+        totalDist = ws.pathDist[endNode];
+        totalFuel = ws.fuelConsumed[endNode];
+        return true;
+    }
+
+    // ==========================================
+    //      BIDIRECTIONAL DIJKSTRA
+    // ==========================================
+    // Searches forward from startNode and backward from endNode at the same time.
+    // Every road is stored in both directions with the same details, so the backward
+    // search can walk the same CSR arrays. Stops as soon as the smallest keys of the two
+    // queues add up to at least the best meeting time found so far.
+    // Fills route (cities in travel order) and the three totals; returns false if unreachable.
+    bool computeBidirectionalRoute(int startNode, int endNode, int speed, vector<int>& route,
+                                   double& totalTime, double& totalDist, double& totalFuel, vector<int>* roadsOut = nullptr) {
+        ensureGraphBuilt(); // Compresses any newly added roads first.
+        if (startNode < 1 || startNode > cityCount || endNode < 1 || endNode > cityCount) return false;
+        QueryWorkspace* ws[2] = {&getThreadWorkspace(0), &getThreadWorkspace(1)}; // [0] forward, [1] backward.
+        ws[0]->begin(cityCount);
+        ws[1]->begin(cityCount);
+        SearchStats& stats = ws[0]->stats; // Both sides count into the forward workspace.
+
+        ws[0]->touch(startNode); ws[0]->minTime[startNode] = 0; ws[0]->heap.push_back({startNode, 0}); // Seeds the forward search.
+        ws[1]->touch(endNode);   ws[1]->minTime[endNode] = 0;   ws[1]->heap.push_back({endNode, 0});   // Seeds the backward search.
+        METRIC(stats.heapPushes += 2);
+
+        double best = (startNode == endNode) ? 0 : INF; // Best start->end time found so far.
+        int meet = (startNode == endNode) ? startNode : -1; // City where that best route crosses over.
+
+        while (!ws[0]->heap.empty() && !ws[1]->heap.empty()) {
+            double top0 = ws[0]->heap.front().timeCost, top1 = ws[1]->heap.front().timeCost;
+            // Meeting-point stopping rule: nothing left in either queue can improve 'best'.
+            if (top0 + top1 >= best) break;
+
+            QueryWorkspace& w = *ws[top0 <= top1 ? 0 : 1]; // Expands the cheaper side.
+            pop_heap(w.heap.begin(), w.heap.end(), greater<PqNode>());
+            int u = w.heap.back().id;
+            double currentTime = w.heap.back().timeCost;
+            w.heap.pop_back();
+            if (currentTime > w.minTime[u]) { METRIC(stats.stalePops++); continue; } // Skips stale queue entries.
+            stats.settledNodes++;
+
+            for (int i = edgeOffset[u]; i < edgeOffset[u + 1]; i++) {
+                const Edge& edge = edges[i];
+                int v = edge.destination;
+                stats.relaxedEdges++;
+                w.touch(v);
+                double newTime = w.minTime[u] + getTravelTime(edge, speed);
+                if (newTime < w.minTime[v]) {
+                    w.minTime[v] = newTime;   // Update shortest time to v on this side.
+                    w.viaEdge[v] = i;         // Remember the road used.
+                    w.parent[v] = u;          // Remember where it came from.
+                    w.heap.push_back({v, newTime});
+                    push_heap(w.heap.begin(), w.heap.end(), greater<PqNode>());
+                    METRIC(stats.heapPushes++);
+                }
+                // Checks whether the two searches now connect through v.
+                double through = ws[0]->timeOf(v) + ws[1]->timeOf(v);
+                if (through < best) {
+                    best = through;
+                    meet = v;
+                }
+            }
+        }
+
+        route.clear();
+        vector<int> localRoads;
+        vector<int>& roads = roadsOut ? *roadsOut : localRoads; // Road index used for every leg.
+        roads.clear();
+        if (meet == -1) return false; // The two searches never met.
+
+        // Rebuilds the route: start -> meet from the forward side, meet -> end from the backward side.
+        traceRoute(*ws[0], startNode, meet, route, roads);
+        for (int v = meet; v != endNode; v = ws[1]->parent[v]) {
+            route.push_back(ws[1]->parent[v]);
+            roads.push_back(ws[1]->viaEdge[v]);
+        }
+
+        accumulateRoute(roads, speed, totalTime, totalDist, totalFuel);
+        return true;
+    }
+
+    // ==========================================
+    //      A* SEARCH (GEOGRAPHIC HEURISTIC)
+    // ==========================================
+    // Lower bound on the minutes still needed from city u to the destination: the straight
+    // line driven at the user's speed with clear roads. Traffic multipliers are always >= 1.0
+    // and the speed is the fastest any road is driven at, so the bound never overestimates.
+    double estimateRemainingTime(int u, int endNode, int speed) {
+        double scale = heuristicScale.load(memory_order_relaxed);
+        if (scale <= 0) return 0; // No usable coordinates: behaves like Dijkstra.
+        double straight = greatCircleKM(cityLat[u], cityLon[u], cityLat[endNode], cityLon[endNode]);
+        return (straight * scale / speed) * 60.0;
+    }
+
+    // Goal-directed search shared by the A* and LANDMARKS modes. 'potential(v)' must return a
+    // lower bound on the minutes from v to endNode. Stops as soon as the destination is settled.
+    // Fills route (cities in travel order) and the three totals; returns false if unreachable.
+    template <typename Potential>
+    bool runGoalDirectedSearch(int startNode, int endNode, int speed, Potential potential, vector<int>& route,
+                               double& totalTime, double& totalDist, double& totalFuel, vector<int>* roadsOut) {
+        QueryWorkspace& ws = getThreadWorkspace();
+        ws.begin(cityCount);
+        vector<PqNode>& pq = ws.heap; // Ordered by time so far + estimate.
+
+        ws.touch(startNode);
+        ws.minTime[startNode] = 0;
+        ws.estimate[startNode] = potential(startNode);
+        pq.push_back({startNode, ws.estimate[startNode]});
+        METRIC(ws.stats.heapPushes++);
+
+        bool found = false;
+        while (!pq.empty()) {
+            pop_heap(pq.begin(), pq.end(), greater<PqNode>());
+            int u = pq.back().id;
+            double currentKey = pq.back().timeCost;
+            pq.pop_back();
+            if (currentKey > ws.minTime[u] + ws.estimate[u]) { METRIC(ws.stats.stalePops++); continue; } // Skips stale queue entries.
+            ws.stats.settledNodes++;
+            if (u == endNode) { found = true; break; } // The destination is final: stop here.
+
+            for (int i = edgeOffset[u]; i < edgeOffset[u + 1]; i++) {
+                const Edge& edge = edges[i];
+                int v = edge.destination;
+                ws.stats.relaxedEdges++;
+                ws.touch(v);
+                double newTime = ws.minTime[u] + getTravelTime(edge, speed);
+                if (newTime < ws.minTime[v]) {
+                    ws.minTime[v] = newTime;
+                    ws.viaEdge[v] = i;
+                    ws.parent[v] = u;
+                    if (ws.estimate[v] < 0) ws.estimate[v] = potential(v);
+                    pq.push_back({v, newTime + ws.estimate[v]});
+                    push_heap(pq.begin(), pq.end(), greater<PqNode>());
+                    METRIC(ws.stats.heapPushes++);
+                }
+            }
+        }
+        route.clear();
+        vector<int> localRoads;
+        vector<int>& roads = roadsOut ? *roadsOut : localRoads; // Road index used for every leg.
+        roads.clear();
+        if (!found) return false;
+
+        traceRoute(ws, startNode, endNode, route, roads);
+        accumulateRoute(roads, speed, totalTime, totalDist, totalFuel);
+        return true;
+    }
+
+    // Runs A* from startNode to endNode using the straight-line estimate.
+    bool computeAStarRoute(int startNode, int endNode, int speed, vector<int>& route,
+                           double& totalTime, double& totalDist, double& totalFuel, vector<int>* roadsOut = nullptr) {
+        ensureGraphBuilt(); // Compresses any newly added roads first.
+        if (startNode < 1 || startNode > cityCount || endNode < 1 || endNode > cityCount) return false;
+        buildOnce([&] { return heuristicScale >= 0; }, [&] { computeHeuristicScale(); });
+        return runGoalDirectedSearch(startNode, endNode, speed,
+                                     [&](int v) { return estimateRemainingTime(v, endNode, speed); },
+                                     route, totalTime, totalDist, totalFuel, roadsOut);
+    }
+
+    // ==========================================
+    //      ALT (LANDMARKS + TRIANGLE INEQUALITY)
+    // ==========================================
+    // Picks k landmarks and precomputes the cost from each of them to every city.
+    // Costs are speed-independent, so the tables serve every query speed.
+    void buildLandmarks(int k, LandmarkStrategy strategy) {
+        ensureGraphBuilt();
+        landmarkStrategy = strategy;
+        landmarks.clear();
+        landmarkDist.clear();
+        landmarksReady = false;
+        if (cityCount == 0) return;
+        k = min(k, cityCount);
+
+        mt19937 rng(2024);                               // Fixed seed: the same map gives the same landmarks.
+        uniform_int_distribution<int> cityDist(1, cityCount);
+        vector<double> dist;
+        vector<int> parent, order;
+        vector<double> table((size_t)(cityCount + 1) * k, INF); // Filled column by column below.
+
+        // Stores the distances of the newest landmark in the table.
+        auto addLandmark = [&](int city) {
+            computeCostDistances(city, dist, parent, nullptr);
+            size_t i = landmarks.size();
+            landmarks.push_back(city);
+            for (int v = 0; v <= cityCount; v++) table[(size_t)v * k + i] = dist[v];
+        };
+        // Lower bound between two cities using the landmarks chosen so far.
+        auto partialBound = [&](int u, int t) {
+            double bound = 0;
+            for (size_t i = 0; i < landmarks.size(); i++) {
+                double du = table[(size_t)u * k + i], dt = table[(size_t)t * k + i];
+                if (du != INF && dt != INF) bound = max(bound, fabs(dt - du));
+            }
+            return bound;
+        };
+
+        while ((int)landmarks.size() < k) {
+            int root = cityDist(rng);
+            computeCostDistances(root, dist, parent, &order);
+            int pick = -1;
+
+            if (strategy == FARTHEST || landmarks.empty()) {
+                // The city whose nearest landmark is farthest away (the first one: farthest from a random city).
+                double bestScore = -1;
+                for (int v : order) {
+                    double nearest = landmarks.empty() ? dist[v] : INF;
+                    for (size_t i = 0; i < landmarks.size(); i++) nearest = min(nearest, table[(size_t)v * k + i]);
+                    bool isLandmark = find(landmarks.begin(), landmarks.end(), v) != landmarks.end();
+                    if (!isLandmark && nearest > bestScore) { bestScore = nearest; pick = v; }
+                }
+            } else {
+                // Avoid: weight every city of the shortest-path tree of 'root' by how much the
+                // current bounds underestimate its distance, sum the weights per subtree
+                // (zero for subtrees that already hold a landmark), then start at the heaviest
+                // subtree and walk down its heaviest branch to a leaf.
+                vector<double> size(cityCount + 1, 0);
+                vector<char> hasLandmark(cityCount + 1, 0);
+                vector<int> heaviestChild(cityCount + 1, -1);
+                for (int l : landmarks) hasLandmark[l] = 1;
+                for (int idx = (int)order.size() - 1; idx >= 0; idx--) {
+                    int v = order[idx];
+                    size[v] += dist[v] - partialBound(root, v);
+                    if (hasLandmark[v]) size[v] = 0;
+                    int p = parent[v];
+                    if (p == -1) continue;
+                    if (hasLandmark[v]) hasLandmark[p] = 1;
+                    size[p] += size[v];
+                    if (heaviestChild[p] == -1 || size[v] > size[heaviestChild[p]]) heaviestChild[p] = v;
+                }
+                int v = -1;
+                for (int u : order) if (size[u] > 0 && (v == -1 || size[u] > size[v])) v = u;
+                if (v != -1) {
+                    while (heaviestChild[v] != -1 && size[heaviestChild[v]] > 0) v = heaviestChild[v];
+                    pick = v;
+                }
+            }
+
+            if (pick == -1) {
+                // Every city reachable from 'root' is already covered: fall back to any unused city.
+                for (int v = 1; v <= cityCount && pick == -1; v++) {
+                    if (find(landmarks.begin(), landmarks.end(), v) == landmarks.end()) pick = v;
+                }
+            }
+            addLandmark(pick);
+        }
+        landmarkDist.swap(table);
+        landmarksReady = true;
+    }
+
+    // Returns the cities currently used as landmarks.
+    const vector<int>& getLandmarks() const { return landmarks; }
+
+    // FNV-1a hash of the road layout and every road's current cost. Landmark tables are only
+    // valid bounds for the costs they were built on, so saved tables carry this hash.
+    unsigned long long landmarkGraphChecksum() {
+        unsigned long long hash = 14695981039346656037ULL;
+        auto mix = [&](const void* data, size_t bytes) {
+            const unsigned char* p = (const unsigned char*)data;
+            for (size_t i = 0; i < bytes; i++) hash = (hash ^ p[i]) * 1099511628211ULL;
+        };
+        for (int v = 0; v <= cityCount + 1; v++) mix(&edgeOffset[v], sizeof(int));
+        for (size_t e = 0; e < edges.size(); e++) {
+            double cost = getEdgeCost(edges[e]);
+            mix(&edges[e].destination, sizeof(int));
+            mix(&cost, sizeof(double));
+        }
+        return hash;
+    }
+
+    // Saves the landmark tables in a small binary file. Returns false if the file can't be written.
+    // Layout: "ALT2", cityCount, roadCount, k, the road checksum (see landmarkGraphChecksum),
+    // the k landmark IDs, then (cityCount + 1) x k costs.
+    bool saveLandmarks(const string& path) {
+        ensureGraphBuilt();
+        if (landmarkDist.empty()) return false;
+        ofstream out(path, ios::binary);
+        if (!out) return false;
+        int header[3] = {cityCount, (int)edges.size(), (int)landmarks.size()};
+        unsigned long long checksum = landmarkGraphChecksum();
+        out.write("ALT2", 4);
+        out.write((const char*)header, sizeof(header));
+        out.write((const char*)&checksum, sizeof(checksum));
+        out.write((const char*)landmarks.data(), landmarks.size() * sizeof(int));
+        out.write((const char*)landmarkDist.data(), landmarkDist.size() * sizeof(double));
+        return (bool)out;
+    }
+
+    // Loads landmark tables saved by saveLandmarks. Returns false if the file is missing,
+    // damaged or was made for a different map or different road costs (the bounds would
+    // then be wrong and ALT would return longer routes without noticing).
+    bool loadLandmarks(const string& path) {
+        ensureGraphBuilt();
+        ifstream in(path, ios::binary);
+        char magic[4];
+        int header[3];
+        unsigned long long checksum;
+        if (!in.read(magic, 4) || string(magic, 4) != "ALT2") return false;
+        if (!in.read((char*)header, sizeof(header))) return false;
+        if (header[0] != cityCount || header[1] != (int)edges.size() || header[2] < 1 || header[2] > cityCount) return false;
+        if (!in.read((char*)&checksum, sizeof(checksum)) || checksum != landmarkGraphChecksum()) return false;
+        vector<int> ids(header[2]);
+        vector<double> table((size_t)(cityCount + 1) * header[2]);
+        if (!in.read((char*)ids.data(), ids.size() * sizeof(int))) return false;
+        if (!in.read((char*)table.data(), table.size() * sizeof(double))) return false;
+        landmarks.swap(ids);
+        landmarkDist.swap(table);
+        landmarksReady = true;
+        return true;
+    }
+
+    // Runs A* with the landmark bounds as potential (rebuilding the tables if roads changed).
+    bool computeLandmarkRoute(int startNode, int endNode, int speed, vector<int>& route,
+                              double& totalTime, double& totalDist, double& totalFuel, vector<int>* roadsOut = nullptr) {
+        ensureGraphBuilt();
+        if (startNode < 1 || startNode > cityCount || endNode < 1 || endNode > cityCount) return false;
+        buildOnce([&] { return (bool)landmarksReady; },
+                  [&] { buildLandmarks(landmarks.empty() ? 8 : (int)landmarks.size(), landmarkStrategy); });
+        double toMinutes = 60.0 / speed; // Converts clear-road km into minutes at this speed.
+        return runGoalDirectedSearch(startNode, endNode, speed,
+                                     [&](int v) { return landmarkLowerBound(v, endNode) * toMinutes; },
+                                     route, totalTime, totalDist, totalFuel, roadsOut);
+    }
+
+    // ==========================================
+    //      CONTRACTION HIERARCHY QUERIES
+    // ==========================================
+    // Runs the offline preprocessing over the current graph. Road weights are
+    // distance x traffic multiplier, which is the travel time at any speed up to a constant.
+    void buildContractionHierarchy() {
+        ensureGraphBuilt();
+        vector<double> edgeCost(edges.size());
+        for (size_t i = 0; i < edges.size(); i++) edgeCost[i] = getEdgeCost(edges[i]);
+        hierarchy.build(cityCount, edgeOffset, edges, edgeCost);
+    }
+
+    // Returns the number of shortcuts in the hierarchy (0 if it has not been built).
+    int getShortcutCount() const { return hierarchy.getShortcutCount(); }
+
+    // Answers a query on the hierarchy (building it first if needed) and unpacks every
+    // shortcut into real roads. Totals are accumulated leg by leg like plain Dijkstra.
+    bool computeHierarchyRoute(int startNode, int endNode, int speed, vector<int>& route,
+                               double& totalTime, double& totalDist, double& totalFuel, vector<int>* roadsOut = nullptr) {
+        ensureGraphBuilt();
+        if (startNode < 1 || startNode > cityCount || endNode < 1 || endNode > cityCount) return false;
+        buildOnce([&] { return hierarchy.isReady(); }, [&] { buildContractionHierarchy(); });
+        QueryWorkspace& ws = getThreadWorkspace();
+        ws.begin(cityCount); // Only used for its counters here.
+        vector<int> localRoads;
+        vector<int>& roads = roadsOut ? *roadsOut : localRoads; // Road index used for every leg.
+        if (!hierarchy.query(startNode, endNode, route, roads, ws.stats)) return false;
+        accumulateRoute(roads, speed, totalTime, totalDist, totalFuel);
+        return true;
+    }
+
+    // ==========================================
+    //      CUSTOMIZABLE ROUTE PLANNING QUERIES
+    // ==========================================
+    // Partitions the current graph and customizes the overlay for the current traffic.
+    // 'cellSizes' gives the largest cell of every level (empty = automatic).
+    void buildPartitionOverlay(vector<int> cellSizes = vector<int>(), int threads = 0) {
+        ensureGraphBuilt();
+        overlay.partition(cityCount, edgeOffset, edges, cityLat, cityLon, cellSizes);
+        overlay.customize(edgeOffset, edges, threads);
+    }
+
+    // Re-runs the whole customization phase (the partition is kept). updateTraffic already
+    // re-customizes the cells a change touches, so this is only needed after costs were
+    // changed some other way.
+    void customizePartitionOverlay(int threads = 0) {
+        ensureGraphBuilt();
+        unique_lock<WriterFirstMutex> trafficLock(trafficMutex);
+        if (!overlay.isPartitioned()) overlay.partition(cityCount, edgeOffset, edges, cityLat, cityLon);
+        overlay.customize(edgeOffset, edges, threads);
+    }
+
+    // Returns the partition overlay (for statistics).
+    const PartitionOverlay& getPartitionOverlay() const { return overlay; }
+
+    // Multi-level Dijkstra on the partition overlay (built on first use).
+    bool computeOverlayRoute(int startNode, int endNode, int speed, vector<int>& route,
+                             double& totalTime, double& totalDist, double& totalFuel, vector<int>* roadsOut = nullptr) {
+        ensureGraphBuilt();
+        buildOnce([&] { return overlay.isReady(); }, [&] { buildPartitionOverlay(); });
+        QueryWorkspace& ws = getThreadWorkspace();
+        ws.begin(cityCount); // Only used for its counters here.
+        vector<int> localRoads;
+        vector<int>& roads = roadsOut ? *roadsOut : localRoads; // Road index used for every leg.
+        if (startNode < 1 || startNode > cityCount || endNode < 1 || endNode > cityCount) return false;
+        if (!overlay.query(startNode, endNode, edgeOffset, edges, route, roads, ws.stats)) return false;
+        accumulateRoute(roads, speed, totalTime, totalDist, totalFuel);
+        return true;
+    }
+
+    // ==========================================
+    //      MANY-TO-MANY TRAVEL MATRIX
+    // ==========================================
+    // Computes time, distance and fuel for every origin x destination pair at once using
+    // buckets on the contraction hierarchy: one upward search per destination drops
+    // (destination, cost) entries into buckets at every city it reaches, then one upward
+    // search per origin scans the buckets of the cities it reaches. Both phases run on all
+    // cores. Values equal findRoute up to floating-point rounding; INF marks unreachable pairs.
+    // Fuel is costed for 'vehicle'.
+    TravelMatrix computeTravelMatrix(const vector<int>& sources, const vector<int>& targets, int speed, int threads = 0,
+                                     VehicleKind vehicle = PETROL_CAR) {
+        ensureGraphBuilt();
+        shared_lock<WriterFirstMutex> trafficLock(trafficMutex); // Traffic can't change mid-query.
+        buildOnce([&] { return hierarchy.isReady(); }, [&] { buildContractionHierarchy(); });
+        threads = resolveThreadCount(threads);
+
+        TravelMatrix matrix;
+        matrix.rows = (int)sources.size();
+        matrix.cols = (int)targets.size();
+        size_t cells = (size_t)matrix.rows * matrix.cols;
+        matrix.minTime.assign(cells, INF);
+        matrix.pathDist.assign(cells, INF);
+        matrix.fuelConsumed.assign(cells, INF);
+        auto valid = [&](int city) { return city >= 1 && city <= cityCount; };
+
+        typedef ContractionHierarchy::UpwardEntry UpwardEntry;
+        vector<ContractionHierarchy::UpwardWorkspace> spaces(threads);
+        vector<vector<UpwardEntry>> reached(threads);   // Per-thread result buffer.
+        for (auto& space : spaces) hierarchy.initWorkspace(space);
+
+        // 1. Backward searches from every destination.
+        vector<vector<UpwardEntry>> targetReach(matrix.cols);
+        parallelFor(matrix.cols, threads, [&](int col, int tid) {
+            if (valid(targets[col])) hierarchy.upwardSearch(targets[col], spaces[tid], targetReach[col]);
+        });
+
+        // 2. Buckets: for every city, the destinations that reached it (CSR by city).
+        struct BucketEntry { int col; double weight; double km[ROAD_TYPE_COUNT]; };
+        vector<int> bucketOffset(cityCount + 2, 0);
+        for (auto& list : targetReach) for (auto& e : list) bucketOffset[e.node + 1]++;
+        for (int v = 0; v <= cityCount; v++) bucketOffset[v + 1] += bucketOffset[v];
+        vector<BucketEntry> buckets(bucketOffset[cityCount + 1]);
+        vector<int> cursor(bucketOffset.begin(), bucketOffset.end() - 1);
+        for (int col = 0; col < matrix.cols; col++) {
+            for (auto& e : targetReach[col]) {
+                BucketEntry& b = buckets[cursor[e.node]++];
+                b.col = col;
+                b.weight = e.weight;
+                for (int t = 0; t < ROAD_TYPE_COUNT; t++) b.km[t] = e.km[t];
+            }
+            vector<UpwardEntry>().swap(targetReach[col]);
+        }
+
+        // 3. Forward searches from every origin, scanning buckets.
+        double toMinutes = 60.0 / speed;
+        const double* fuelPerKm = getVehicleProfile(vehicle).litresPerKm(speed);
+        parallelFor(matrix.rows, threads, [&](int row, int tid) {
+            if (!valid(sources[row])) return;
+            hierarchy.upwardSearch(sources[row], spaces[tid], reached[tid]);
+            vector<double> best(matrix.cols, INF);
+            vector<double> km((size_t)matrix.cols * ROAD_TYPE_COUNT, 0);
+            for (auto& e : reached[tid]) {
+                for (int i = bucketOffset[e.node]; i < bucketOffset[e.node + 1]; i++) {
+                    const BucketEntry& b = buckets[i];
+                    double total = e.weight + b.weight;
+                    if (total >= best[b.col]) continue;
+                    best[b.col] = total;
+                    for (int t = 0; t < ROAD_TYPE_COUNT; t++) km[(size_t)b.col * ROAD_TYPE_COUNT + t] = e.km[t] + b.km[t];
+                }
+            }
+            for (int col = 0; col < matrix.cols; col++) {
+                if (best[col] == INF) continue;
+                size_t cell = (size_t)row * matrix.cols + col;
+                double dist = 0, fuel = 0;
+                for (int t = 0; t < ROAD_TYPE_COUNT; t++) {
+                    dist += km[(size_t)col * ROAD_TYPE_COUNT + t];
+                    fuel += km[(size_t)col * ROAD_TYPE_COUNT + t] * fuelPerKm[t];
+                }
+                matrix.minTime[cell] = best[col] * toMinutes;
+                matrix.pathDist[cell] = dist;
+                matrix.fuelConsumed[cell] = fuel;
+            }
+        });
+        return matrix;
+    }
+
+    // ==========================================
+    //      MULTI-CRITERIA (PARETO) ROUTING
+    // ==========================================
+    // Martins-style label-setting search over (time, fuel, distance). A city keeps a bag of
+    // labels, one per route found so far that no other route to it beats in all three
+    // criteria. Labels leave the queue in order of time, so the first label of a city is the
+    // fastest route and later ones must save fuel or distance to survive.
+    // Two things keep it fast on large maps:
+    //  - target pruning: a label is dropped once a route already found to the destination is
+    //    no worse than the label plus a lower bound on the rest of the trip in every criterion
+    //    (the bounds come from three one-to-all searches from the destination);
+    //  - bounded bags: a city keeps at most maxLabels labels (the fastest ones), so the
+    //    frontier is cut to its maxLabels fastest routes in the worst case.
+    // Returns the frontier sorted by time (the first route is the Dijkstra route).
+    vector<ParetoRoute> computeParetoRoutes(int startNode, int endNode, int speed, size_t maxLabels = 8,
+                                           VehicleKind vehicle = PETROL_CAR) {
+        ensureGraphBuilt();
+        shared_lock<WriterFirstMutex> trafficLock(trafficMutex); // Traffic can't change mid-query.
+        vector<ParetoRoute> frontier;
+        SearchStats& stats = getThreadWorkspace().stats;
+        stats = SearchStats();
+        if (startNode < 1 || startNode > cityCount || endNode < 1 || endNode > cityCount) return frontier;
+
+        // Lower bounds from every city to the destination. Roads are two-way with equal
+        // details, so searching outward from the destination gives the distances towards it.
+        // The bounds are shrunk a little so rounding can never prune an equal route.
+        vector<double> boundTime, boundFuel, boundDist;
+        computeBoundsFrom(endNode, boundTime, [&](const Edge& e) { return getTravelTime(e, speed); });
+        const double* fuelPerKm = getVehicleProfile(vehicle).litresPerKm(speed);
+        computeBoundsFrom(endNode, boundFuel, [&](const Edge& e) { return e.distanceKM * fuelPerKm[e.type]; });
+        computeBoundsFrom(endNode, boundDist, [&](const Edge& e) { return e.distanceKM; });
+        if (boundTime[startNode] == INF) return frontier;
+
+        struct Label {
+            double time, fuel, dist;  // Totals from the start city.
+            int city;                 // City the label belongs to.
+            int pred;                 // Label it was extended from (-1 = start).
+            int road;                 // Road used from the predecessor's city.
+        };
+        vector<Label> labels;         // Every label created; the queue and bags hold indices.
+        auto later = [&](int a, int b) { // Heap order: time, then fuel, then distance.
+            const Label& x = labels[a];
+            const Label& y = labels[b];
+            if (x.time != y.time) return x.time > y.time;
+            if (x.fuel != y.fuel) return x.fuel > y.fuel;
+            return x.dist > y.dist;
+        };
+        auto dominates = [](double t1, double f1, double d1, const Label& l) {
+            return t1 <= l.time && f1 <= l.fuel && d1 <= l.dist;
+        };
+        // True if a settled label of the same city, or a destination label plus nothing, beats l.
+        vector<vector<int>> bags(cityCount + 1);
+        auto isBeaten = [&](const Label& l) {
+            for (int b : bags[l.city]) {
+                if (dominates(labels[b].time, labels[b].fuel, labels[b].dist, l)) return true;
+            }
+            const double slack = 1 - 1e-9;
+            Label rest = {l.time + boundTime[l.city] * slack, l.fuel + boundFuel[l.city] * slack,
+                          l.dist + boundDist[l.city] * slack, l.city, -1, -1};
+            for (int b : bags[endNode]) {
+                if (dominates(labels[b].time, labels[b].fuel, labels[b].dist, rest)) return true;
+            }
+            return false;
+        };
+
+        vector<int> heap;
+        labels.push_back({0, 0, 0, startNode, -1, -1});
+        heap.push_back(0);
+        while (!heap.empty()) {
+            pop_heap(heap.begin(), heap.end(), later);
+            int id = heap.back();
+            heap.pop_back();
+            Label cur = labels[id];
+            if (bags[cur.city].size() >= maxLabels || isBeaten(cur)) continue;
+            bags[cur.city].push_back(id); // The label is settled: it joins the city's bag.
+            stats.settledNodes++;
+            if (cur.city == endNode) continue; // Routes are not extended past the destination.
+
+            for (int i = edgeOffset[cur.city]; i < edgeOffset[cur.city + 1]; i++) {
+                const Edge& edge = edges[i];
+                stats.relaxedEdges++;
+                if (boundTime[edge.destination] == INF) continue;
+                Label next = {cur.time + getTravelTime(edge, speed),
+                              cur.fuel + edge.distanceKM * fuelPerKm[edge.type],
+                              cur.dist + edge.distanceKM, edge.destination, id, i};
+                if (bags[next.city].size() >= maxLabels || isBeaten(next)) continue;
+                labels.push_back(next);
+                heap.push_back((int)labels.size() - 1);
+                push_heap(heap.begin(), heap.end(), later);
+            }
+        }
+
+        for (int b : bags[endNode]) { // Settled in time order, so the frontier is sorted by time.
+            ParetoRoute option;
+            option.totalTime = labels[b].time;
+            option.totalFuel = labels[b].fuel;
+            option.totalDist = labels[b].dist;
+            for (int l = b; labels[l].pred != -1; l = labels[l].pred) {
+                option.route.push_back(labels[l].city);
+                option.roads.push_back(labels[l].road);
+            }
+            option.route.push_back(startNode);
+            reverse(option.route.begin(), option.route.end());
+            reverse(option.roads.begin(), option.roads.end());
+            frontier.push_back(option);
+        }
+        return frontier;
+    }
+
+    // ==========================================
+    //      ALTERNATIVE ROUTES (PLATEAU METHOD)
+    // ==========================================
+    // Finds up to limits.maxRoutes routes: the fastest one, then alternatives that are
+    // clearly different and still sensible. Two searches do all the heavy work: one forward
+    // from the start and one backward from the destination, both cut off at (1 + maxStretch)
+    // x the fastest time. A "plateau" is a stretch of roads used by both trees; every city v
+    // gives the route start -> v along the forward tree, v -> destination along the backward
+    // tree, and the longer the plateau ending at v, the more natural that route is. Via cities
+    // are tried best first (low 2 x time - plateau time) and an alternative is kept if it
+    //  - takes at most (1 + maxStretch) x the fastest time (bounded stretch),
+    //  - shares at most maxSharing x the fastest time with every option kept before it,
+    //  - visits no city twice, and
+    //  - is locally optimal: every part of it up to localOptimality x the fastest time is a
+    //    fastest route itself. Parts inside either tree are fastest by construction, so only
+    //    the part around the plateau is checked, with one short search (a T-test).
+    // The result is sorted by time; the first option is the fastest route.
+    vector<AlternativeRoute> planAlternativeRoutes(int startNode, int endNode, int speed,
+                                                   const AlternativeLimits& limits = AlternativeLimits()) {
+        auto t0 = chrono::steady_clock::now();
+        ensureGraphBuilt();
+        vector<AlternativeRoute> options;
+        vector<vector<int>> optionRoads;
+        if (startNode < 1 || startNode > cityCount || endNode < 1 || endNode > cityCount) return options;
+        shared_lock<WriterFirstMutex> trafficLock(trafficMutex); // Searches and legs see the same traffic.
+        SearchStats stats;
+        {
+            QueryWorkspace& fw = getThreadWorkspace(0);  // Forward tree from the start.
+            QueryWorkspace& bw = getThreadWorkspace(1);  // Backward tree from the destination.
+            QueryWorkspace& check = getThreadWorkspace(2); // Local optimality checks.
+
+            vector<int> settled, backSettled;
+            double best = growBoundedTree(startNode, endNode, speed, limits.maxStretch, INF, fw, &settled, stats);
+            if (best == INF) return options;
+            double limit = best * (1 + limits.maxStretch);
+            // Roads are two-way with equal details, so the backward tree walks the same arrays.
+            growBoundedTree(endNode, -1, speed, 0, limit, bw, &backSettled, stats);
+
+            // Time every tree route shares with the fastest route, kept in the otherwise unused
+            // 'estimate' entries: a forward route leaves it for good at its last city on it, and
+            // so does a backward one. Parents are settled before their children.
+            for (int v = endNode; v != -1; v = fw.parent[v]) fw.estimate[v] = fw.minTime[v];
+            for (int v = endNode; v != -1; v = fw.parent[v]) bw.estimate[v] = bw.minTime[v];
+            for (int v : settled) if (fw.estimate[v] < 0) fw.estimate[v] = fw.estimate[fw.parent[v]];
+            for (int v : backSettled) if (bw.estimate[v] < 0) bw.estimate[v] = bw.estimate[bw.parent[v]];
+
+            // True if the forward tree road into v is also the backward tree road out of its parent.
+            auto onPlateau = [&](int v) {
+                int p = fw.parent[v];
+                return p != -1 && bw.timeOf(p) != INF && bw.parent[p] == v && twinRoad[fw.viaEdge[v]] == bw.viaEdge[p];
+            };
+            // Every plateau is scored at its last city (closest to the destination) with
+            // 2 x time + time shared with the fastest route - plateau time.
+            struct Candidate { double score; int via; int plateauRoads; };
+            vector<Candidate> candidates;
+            for (int v : settled) {
+                if (bw.timeOf(v) == INF || fw.minTime[v] + bw.minTime[v] > limit) continue;
+                double shared = fw.estimate[v] + bw.estimate[v];
+                if (shared > limits.maxSharing * best) continue;
+                int next = bw.parent[v];
+                if (next != -1 && fw.timeOf(next) != INF && fw.parent[next] == v && onPlateau(next)) continue;
+                int first = v, count = 0;
+                while (onPlateau(first)) { first = fw.parent[first]; count++; }
+                double plateau = fw.minTime[v] - fw.minTime[first];
+                candidates.push_back({2 * (fw.minTime[v] + bw.minTime[v]) + shared - plateau, v, count});
+            }
+            sort(candidates.begin(), candidates.end(),
+                 [](const Candidate& a, const Candidate& b) { return a.score < b.score || (a.score == b.score && a.via < b.via); });
+
+            // Builds the route through a via city: cities and roads in travel order. Returns
+            // the position of the via city in the route.
+            auto buildRoute = [&](int via, vector<int>& route, vector<int>& roads) {
+                traceRoute(fw, startNode, via, route, roads);
+                int position = (int)route.size() - 1;
+                for (int v = via; v != endNode; v = bw.parent[v]) {
+                    int back = bw.viaEdge[v]; // Road from bw.parent[v] to v.
+                    route.push_back(bw.parent[v]);
+                    roads.push_back(twinRoad[back] != -1 ? twinRoad[back] : back);
+                }
+                return position;
+            };
+            auto addOption = [&](const vector<int>& route, const vector<int>& roads, double sharing) {
+                AlternativeRoute option;
+                option.result.startNode = startNode;
+                option.result.endNode = endNode;
+                option.result.speed = speed;
+                option.result.found = true;
+                option.result.route = route;
+                accumulateRoute(roads, speed, option.result.totalTime, option.result.totalDist, option.result.totalFuel);
+                option.stretch = best > 0 ? option.result.totalTime / best - 1 : 0;
+                option.sharing = sharing;
+                options.push_back(option);
+                optionRoads.push_back(roads);
+            };
+
+            vector<int> route, roads;
+            buildRoute(endNode, route, roads);
+            addOption(route, roads, 0);
+            vector<unordered_map<int, double>> used(1); // Road -> minutes, for every option kept.
+            for (int r : roads) used[0][r] = getTravelTime(edges[r], speed);
+
+            int examined = 0;
+            if (best == 0) candidates.clear(); // Start and destination are the same city.
+            for (const Candidate& c : candidates) {
+                if ((int)options.size() >= limits.maxRoutes || examined >= limits.maxCandidates) break;
+                examined++;
+                int head = buildRoute(c.via, route, roads), tail = head - c.plateauRoads;
+                vector<double> at(route.size(), 0); // Minutes from the start to every city of the route.
+                for (size_t k = 0; k < roads.size(); k++) at[k + 1] = at[k] + getTravelTime(edges[roads[k]], speed);
+                if (at.back() > limit) continue;
+
+                double sharing = 0;
+                for (auto& option : used) {
+                    double shared = 0;
+                    for (size_t k = 0; k < roads.size(); k++) {
+                        auto found = option.find(roads[k]);
+                        if (found != option.end()) shared += found->second;
+                    }
+                    sharing = max(sharing, shared / best);
+                }
+                if (sharing > limits.maxSharing) continue;
+
+                vector<int> cities(route);
+                sort(cities.begin(), cities.end());
+                if (adjacent_find(cities.begin(), cities.end()) != cities.end()) continue;
+
+                // T-test: the stretch from the last city within reach before the plateau to
+                // the last one within reach after it must be a fastest route.
+                double reach = limits.localOptimality * best;
+                int x = tail, y = head;
+                while (x > 0 && at[tail] - at[x - 1] <= reach) x--;
+                while (y < (int)route.size() - 1 && at[y + 1] - at[head] <= reach) y++;
+                if (x < tail || y > head) {
+                    // If either tree's route between the two ends passes the other end, that
+                    // subroute is a fastest one and its time is known without searching.
+                    int from = route[x], to = route[y];
+                    double segment = at[y] - at[x], fastest = -1;
+                    for (int v = to; v != -1 && fastest < 0 && fw.minTime[v] >= fw.minTime[from]; v = fw.parent[v]) {
+                        if (v == from) fastest = fw.minTime[to] - fw.minTime[from];
+                    }
+                    for (int v = from; v != -1 && fastest < 0 && bw.minTime[v] >= bw.minTime[to]; v = bw.parent[v]) {
+                        if (v == to) fastest = bw.minTime[from] - bw.minTime[to];
+                    }
+                    if (fastest < 0) fastest = growBoundedTree(from, to, speed, 0, segment * (1 + 1e-9), check, nullptr, stats);
+                    if (fastest < segment * (1 - 1e-9)) continue;
+                }
+
+                addOption(route, roads, sharing);
+                used.push_back(unordered_map<int, double>());
+                for (int r : roads) used.back()[r] = getTravelTime(edges[r], speed);
+            }
+        }
+
+        // Faster options first; the fastest route stays on top.
+        vector<int> order(options.size());
+        for (size_t k = 0; k < order.size(); k++) order[k] = (int)k;
+        stable_sort(order.begin(), order.end(),
+                    [&](int a, int b) { return options[a].result.totalTime < options[b].result.totalTime; });
+        vector<AlternativeRoute> sorted;
+        double searchMs = chrono::duration<double, milli>(chrono::steady_clock::now() - t0).count();
+        for (int k : order) {
+            AlternativeRoute& option = options[k];
+            option.result.stats = stats;
+            option.result.searchMs = searchMs;
+            fillLegs(option.result, optionRoads[k]);
+            sorted.push_back(option);
+        }
+        getThreadWorkspace().stats = stats;
+        return sorted;
+    }
+
+    // ==========================================
+    //      ISOCHRONES (REACHABILITY WITHIN A BUDGET)
+    // ==========================================
+    // Returns the cities reachable from 'origin' within the budget, nearest first, and every
+    // road the budget runs out on with how far along it the car gets.
+    IsochroneResult computeIsochrone(int origin, int speed, double budget, BudgetKind kind = TIME_BUDGET,
+                                     VehicleKind vehicle = PETROL_CAR) {
+        ensureGraphBuilt();
+        shared_lock<WriterFirstMutex> trafficLock(trafficMutex); // Traffic can't change mid-query.
+        return isochroneFrom(origin, speed, budget, kind, vehicle);
+    }
+
+    // Computes the isochrones of many origins at once, spread over 'threads' threads (0 = all
+    // cores). Each thread searches in its own workspace, so the origins run independently.
+    vector<IsochroneResult> computeIsochrones(const vector<int>& origins, int speed, double budget,
+                                              BudgetKind kind = TIME_BUDGET, int threads = 0,
+                                              VehicleKind vehicle = PETROL_CAR) {
+        ensureGraphBuilt();
+        shared_lock<WriterFirstMutex> trafficLock(trafficMutex); // Traffic can't change mid-batch.
+        vector<IsochroneResult> results(origins.size());
+        parallelFor((int)origins.size(), threads, [&](int k, int) {
+            results[k] = isochroneFrom(origins[k], speed, budget, kind, vehicle);
+        });
+        return results;
+    }
+
+    // Prints the cities reachable from 'origin' within the budget (hours of driving or litres
+    // of the vehicle's fuel) and the roads where the budget runs out.
+    void findIsochrone(int origin, int speed, double budget, BudgetKind kind = TIME_BUDGET, VehicleKind vehicle = PETROL_CAR) {
+        if (origin < 1 || origin > cityCount) {
+            cout << "Invalid City ID Selected!" << endl;
+            return;
+        }
+        double limit = kind == TIME_BUDGET ? budget * 60 : budget; // Hours are searched as minutes.
+        IsochroneResult area = computeIsochrone(origin, speed, limit, kind, vehicle);
+        auto spent = [&](double value) {
+            if (kind == FUEL_BUDGET) {
+                ostringstream text;
+                text << fixed << setprecision(1) << value << " L";
+                return text.str();
+            }
+            return to_string((int)value / 60) + "h " + to_string((int)value % 60) + "m";
+        };
+
+        cout << "\n Reachable from " << cityNames[origin] << " within " << spent(limit)
+             << " at " << speed << " km/h" << (kind == FUEL_BUDGET ? " (" + getVehicleProfile(vehicle).getName() + ")" : "") << endl;
+        cout << "--------------------------------------------------------" << endl;
+        for (size_t k = 0; k < area.cities.size(); k++) {
+            cout << "  " << left << setw(20) << cityNames[area.cities[k]] << right << spent(area.spent[k]) << endl;
+        }
+        if (!area.cutRoads.empty()) {
+            cout << "--------------------------------------------------------" << endl;
+            cout << " Budget runs out on:" << endl;
+            for (const CutRoad& cut : area.cutRoads) {
+                cout << "  " << left << setw(18) << roadNames[edgeNameId[cut.road]] << right << fixed << setprecision(0)
+                     << setw(5) << cut.reachedKM << " of " << edges[cut.road].distanceKM << " km from "
+                     << cityNames[cut.from] << " towards " << cityNames[cut.to] << endl;
+            }
+        }
+        cout << "--------------------------------------------------------" << endl;
+    }
+
+    // Builds whatever 'mode' needs ahead of time (A* scale, landmark tables, hierarchy or
+    // overlay) under the exclusive lock, so no query has to build it lazily. The searches
+    // themselves keep their scratch state per thread (QueryWorkspace, the hierarchy's and the
+    // overlay's thread-local query spaces), so once this has run, queries in that mode can
+    // run on many threads at once. Waits for running queries like a traffic update does.
+    void prepareSearchMode(SearchMode mode) {
+        ensureGraphBuilt();
+        unique_lock<WriterFirstMutex> trafficLock(trafficMutex);
+        if (mode == ASTAR && heuristicScale < 0) computeHeuristicScale();
+        if (mode == LANDMARKS && landmarkDist.empty()) buildLandmarks(landmarks.empty() ? 8 : (int)landmarks.size(), landmarkStrategy);
+        if (mode == CONTRACTION_HIERARCHY && !hierarchy.isReady()) buildContractionHierarchy();
+        if (mode == PARTITION_OVERLAY && !overlay.isReady()) buildPartitionOverlay();
+    }
+
+    // Runs one point-to-point query with the chosen algorithm without printing anything.
+    // Fills route (cities in travel order) and the totals, and if 'roads' is given the road
+    // index used for every leg; returns false if a city ID is out of range or the destination
+    // can't be reached.
+    bool computeRoute(int startNode, int endNode, int speed, SearchMode mode, vector<int>& route,
+                      double& totalTime, double& totalDist, double& totalFuel, vector<int>* roads = nullptr) {
+        ensureGraphBuilt();
+        shared_lock<WriterFirstMutex> trafficLock(trafficMutex); // Traffic can't change mid-query.
+        return computeRouteLocked(startNode, endNode, speed, mode, route, totalTime, totalDist, totalFuel, roads);
+    }
+
+    // computeRoute for a caller that already holds the shared traffic lock.
+    bool computeRouteLocked(int startNode, int endNode, int speed, SearchMode mode, vector<int>& route,
+                            double& totalTime, double& totalDist, double& totalFuel, vector<int>* roads = nullptr) {
+        if (mode == BIDIRECTIONAL) return computeBidirectionalRoute(startNode, endNode, speed, route, totalTime, totalDist, totalFuel, roads);
+        if (mode == ASTAR) return computeAStarRoute(startNode, endNode, speed, route, totalTime, totalDist, totalFuel, roads);
+        if (mode == CONTRACTION_HIERARCHY) return computeHierarchyRoute(startNode, endNode, speed, route, totalTime, totalDist, totalFuel, roads);
+        if (mode == LANDMARKS) return computeLandmarkRoute(startNode, endNode, speed, route, totalTime, totalDist, totalFuel, roads);
+        if (mode == PARTITION_OVERLAY) return computeOverlayRoute(startNode, endNode, speed, route, totalTime, totalDist, totalFuel, roads);
+        return computeDijkstraRoute(startNode, endNode, speed, route, totalTime, totalDist, totalFuel, roads);
+    }
+
+    // Computes a route without printing anything and returns it as a RouteResult: the legs
+    // with the exact road used for each, the totals, the search counters and the query time.
+    // Plain Dijkstra is answered from the speed-invariant tree cache, so asking again with
+    // another speed skips the search. The fastest route is the same for every vehicle; only
+    // its fuel and cost depend on 'vehicle'.
+    RouteResult planRoute(int startNode, int endNode, int speed, SearchMode mode = DIJKSTRA,
+                          VehicleKind vehicle = PETROL_CAR) {
+        auto t0 = chrono::steady_clock::now();
+        RouteResult result;
+        result.startNode = startNode;
+        result.endNode = endNode;
+        result.speed = speed;
+        result.vehicle = vehicle;
+        if (startNode < 1 || startNode > cityCount || endNode < 1 || endNode > cityCount) return result;
+
+        ensureGraphBuilt();
+        shared_lock<WriterFirstMutex> trafficLock(trafficMutex); // Search and legs see the same traffic.
+        vector<int> roads;
+        result.found = mode == DIJKSTRA
+            ? computeCachedRouteLocked(startNode, endNode, speed, result.route, result.totalTime, result.totalDist, result.totalFuel, &roads)
+            : computeRouteLocked(startNode, endNode, speed, mode, result.route, result.totalTime, result.totalDist, result.totalFuel, &roads);
+        METRIC(auto searched = chrono::steady_clock::now());
+        result.stats = getLastSearchStats();
+        if (result.found) fillLegs(result, roads);
+        auto t1 = chrono::steady_clock::now();
+        result.searchMs = chrono::duration<double, milli>(t1 - t0).count();
+        METRIC(queryMetrics().record(mode, result.stats, chrono::duration_cast<chrono::nanoseconds>(searched - t0).count(),
+                                     chrono::duration_cast<chrono::nanoseconds>(t1 - searched).count()));
+        return result;
+    }
+
+    // Same as planRoute for a departure at 'departure' minutes after midnight, with every
+    // road evaluated at the time the car actually reaches it.
+    RouteResult planRouteDepartingAt(int startNode, int endNode, int speed, double departure) {
+        auto t0 = chrono::steady_clock::now();
+        RouteResult result;
+        result.startNode = startNode;
+        result.endNode = endNode;
+        result.speed = speed;
+        result.departure = departure;
+        if (startNode < 1 || startNode > cityCount || endNode < 1 || endNode > cityCount) return result;
+
+        ensureGraphBuilt();
+        shared_lock<WriterFirstMutex> trafficLock(trafficMutex); // Search and legs see the same traffic.
+        vector<int> roads;
+        result.found = computeTimeDependentRouteLocked(startNode, endNode, speed, departure, result.route,
+                                                       result.totalTime, result.totalDist, result.totalFuel, &roads);
+        result.stats = getLastSearchStats();
+        if (result.found) fillLegs(result, roads);
+        result.searchMs = chrono::duration<double, milli>(chrono::steady_clock::now() - t0).count();
+        return result;
+    }
+
+    // Main function to calculate the shortest path.
+    void findRoute(int startNode, int endNode, int speed, SearchMode mode = DIJKSTRA, VehicleKind vehicle = PETROL_CAR) {
+        // Validates that the input IDs exist in our data.
+        if (startNode < 1 || startNode > cityCount || endNode < 1 || endNode > cityCount) {
+            cout << "Invalid City ID Selected!" << endl; // Prints error if invalid.
+            return; // Exits the function.
+        }
+
+        RouteResult result = planRoute(startNode, endNode, speed, mode, vehicle);
+
+        // Check if the destination is reachable.
+        if (!result.found) {
+            cout << "\nError: No road connection exists between these cities." << endl; // Prints error if unreachable.
+            return;
+        }
+
+        // If reachable, print the full receipt/itinerary.
+        printDetailedReceipt(result);
+    }
+
+    // Prints the receipt of the fastest route when leaving at 'departure' (minutes after midnight).
+    void findRouteDepartingAt(int startNode, int endNode, int speed, double departure) {
+        if (startNode < 1 || startNode > cityCount || endNode < 1 || endNode > cityCount) {
+            cout << "Invalid City ID Selected!" << endl;
+            return;
+        }
+        RouteResult result = planRouteDepartingAt(startNode, endNode, speed, departure);
+        if (!result.found) {
+            cout << "\nError: No road connection exists between these cities." << endl;
+            return;
+        }
+        printDetailedReceipt(result);
+    }
+
+    // ==========================================
+    //      FLEET ROUTING
+    // ==========================================
+    // Plans every trip of a fleet, spread over 'threads' threads (0 = all cores). Each trip is
+    // costed for its own vehicle: fuel from that vehicle's table, cost at its fuel's price.
+    vector<RouteResult> planFleetRoutes(const vector<FleetTrip>& trips, SearchMode mode = DIJKSTRA, int threads = 0) {
+        prepareSearchMode(mode); // Builds what the mode needs once, before the threads start.
+        vector<RouteResult> results(trips.size());
+        parallelFor((int)trips.size(), threads, [&](int k, int) {
+            const FleetTrip& trip = trips[k];
+            results[k] = planRoute(trip.startNode, trip.endNode, trip.speed, mode, trip.vehicle);
+        });
+        return results;
+    }
+
+    // Prints what the same trip costs with every vehicle (one search; the route is shared).
+    void findFleetCosts(int startNode, int endNode, int speed) {
+        if (startNode < 1 || startNode > cityCount || endNode < 1 || endNode > cityCount) {
+            cout << "Invalid City ID Selected!" << endl;
+            return;
+        }
+        vector<FleetTrip> trips;
+        for (int v = 0; v < VEHICLE_KIND_COUNT; v++) trips.push_back({(VehicleKind)v, startNode, endNode, speed});
+        vector<RouteResult> results = planFleetRoutes(trips, DIJKSTRA, 1);
+        if (!results[0].found) {
+            cout << "\nError: No road connection exists between these cities." << endl;
+            return;
+        }
+
+        const RouteResult& route = results[0];
+        cout << "\n Fleet costs: " << cityNames[startNode] << " -> " << cityNames[endNode] << " at " << speed
+             << " km/h, " << fixed << setprecision(1) << route.totalDist << " km, "
+             << (int)route.totalTime / 60 << "h " << (int)route.totalTime % 60 << "m" << endl;
+        cout << "--------------------------------------------------------" << endl;
+        cout << left << setw(16) << " Vehicle" << setw(9) << "Fuel" << right << setw(10) << "Litres"
+             << setw(10) << "km/L" << setw(14) << "Cost (PKR)" << endl;
+        cout << "--------------------------------------------------------" << endl;
+        for (const RouteResult& r : results) {
+            const VehicleProfile& vehicle = getVehicleProfile(r.vehicle);
+            cout << " " << left << setw(15) << vehicle.getName() << setw(9) << (vehicle.getFuel() == DIESEL ? "diesel" : "petrol")
+                 << right << setw(10) << r.totalFuel << setw(10) << r.totalDist / r.totalFuel
+                 << setw(14) << setprecision(0) << r.fuelCost << setprecision(1) << endl;
+        }
+        cout << "--------------------------------------------------------" << endl;
+    }
+
+    // ==========================================
+    //      MULTI-STOP DELIVERY RUNS
+    // ==========================================
+    // Plans a run from stops[0] (the depot) through every other stop: builds the stop-to-stop
+    // matrix on the contraction hierarchy on all cores, orders the stops with TourSolver on
+    // minutes or litres, then plans the route of every leg in parallel.
+    TourResult planTour(const vector<int>& stops, int speed, bool roundTrip = true, VehicleKind vehicle = PETROL_CAR,
+                        TourObjective objective = TOUR_TIME, int threads = 0) {
+        TourResult tour;
+        tour.roundTrip = roundTrip;
+        tour.speed = speed;
+        tour.vehicle = vehicle;
+        tour.objective = objective;
+        if (stops.empty()) return tour;
+        for (int city : stops) {
+            if (city < 1 || city > cityCount) return tour;
+        }
+
+        auto t0 = chrono::steady_clock::now();
+        prepareSearchMode(CONTRACTION_HIERARCHY); // The matrix and the legs both use the hierarchy.
+        TravelMatrix matrix = computeTravelMatrix(stops, stops, speed, threads, vehicle);
+        auto t1 = chrono::steady_clock::now();
+        TourSolver solver(objective == TOUR_FUEL ? matrix.fuelConsumed : matrix.minTime, (int)stops.size(), roundTrip);
+        vector<int> order = solver.solve();
+        tour.exact = solver.wasExact();
+        auto t2 = chrono::steady_clock::now();
+        tour.matrixMs = chrono::duration<double, milli>(t1 - t0).count();
+        tour.solveMs = chrono::duration<double, milli>(t2 - t1).count();
+
+        for (int k : order) tour.stops.push_back(stops[k]);
+        if (roundTrip && stops.size() > 1) tour.stops.push_back(stops[0]);
+        for (size_t k = 0; k + 1 < tour.stops.size(); k++) {
+            if (matrix.minTime[(size_t)order[k] * matrix.cols + order[(k + 1) % order.size()]] >= INF) return tour;
+        }
+
+        planTourLegs(tour, threads);
+        tour.legsMs = chrono::duration<double, milli>(chrono::steady_clock::now() - t2).count();
+        return tour;
+    }
+
+    // Plans the route between every pair of consecutive stops of 'tour' in parallel on the
+    // hierarchy and adds up the totals.
+    void planTourLegs(TourResult& tour, int threads) {
+        tour.legs.assign(tour.stops.size() > 1 ? tour.stops.size() - 1 : 0, RouteResult());
+        parallelFor((int)tour.legs.size(), threads, [&](int k, int) {
+            tour.legs[k] = planRoute(tour.stops[k], tour.stops[k + 1], tour.speed, CONTRACTION_HIERARCHY, tour.vehicle);
+        });
+        for (const RouteResult& leg : tour.legs) {
+            tour.totalTime += leg.totalTime;
+            tour.totalDist += leg.totalDist;
+            tour.totalFuel += leg.totalFuel;
+            tour.fuelCost += leg.fuelCost;
+        }
+        tour.found = true;
+    }
+
+    // Prints the itinerary of a run from stops[0] through every other stop.
+    void findTour(const vector<int>& stops, int speed, bool roundTrip = true, VehicleKind vehicle = PETROL_CAR,
+                  TourObjective objective = TOUR_TIME) {
+        for (int city : stops) {
+            if (city < 1 || city > cityCount) {
+                cout << "Invalid City ID Selected!" << endl;
+                return;
+            }
+        }
+        TourResult tour = planTour(stops, speed, roundTrip, vehicle, objective);
+        if (!tour.found) {
+            cout << "\nError: Some stops have no road connection between them." << endl;
+            return;
+        }
+        printTourReceipt(tour);
+    }
+
+    // ==========================================
+    //      CAPACITATED FLEET ROUTING
+    // ==========================================
+    // Splits the orders of 'problem' over the fleet and orders every vehicle's stops. A leg
+    // costs its fuel (vehicle table, fastest route) at the fuel's price plus its driving time
+    // with traffic at costPerHour. 'starts' searches (0 = one per thread) run in parallel from
+    // different savings starts, 'iterations' ruin-and-recreate steps each; the cheapest result
+    // wins and its routes are then re-ordered by TourSolver.
+    FleetPlan planFleet(const FleetProblem& problem, int iterations = 20000, int starts = 0, int threads = 0) {
+        FleetPlan plan;
+        if (problem.depot < 1 || problem.depot > cityCount || problem.capacity <= 0) return plan;
+        vector<int> nodes(1, problem.depot);
+        vector<double> demand(1, 0);
+        for (const DeliveryOrder& order : problem.orders) {
+            if (order.city < 1 || order.city > cityCount || order.demand > problem.capacity) return plan;
+            nodes.push_back(order.city);
+            demand.push_back(order.demand);
+        }
+        int n = (int)nodes.size();
+
+        auto t0 = chrono::steady_clock::now();
+        prepareSearchMode(CONTRACTION_HIERARCHY); // The matrix and the legs both use the hierarchy.
+        TravelMatrix matrix = computeTravelMatrix(nodes, nodes, problem.speed, threads, problem.vehicle);
+        double price = getVehicleProfile(problem.vehicle).getFuelPrice();
+        vector<double> costs(matrix.minTime.size());
+        for (size_t cell = 0; cell < costs.size(); cell++) {
+            if (matrix.minTime[cell] >= INF) return plan;
+            costs[cell] = matrix.fuelConsumed[cell] * price + matrix.minTime[cell] / 60 * problem.costPerHour;
+        }
+        auto t1 = chrono::steady_clock::now();
+        plan.matrixMs = chrono::duration<double, milli>(t1 - t0).count();
+
+        VrpSolver solver(costs, demand, n, problem.capacity, problem.maxVehicles);
+        if (starts <= 0) starts = resolveThreadCount(threads);
+        vector<VrpSolver::Solution> results(starts);
+        parallelFor(starts, threads, [&](int k, int) { results[k] = solver.solve(iterations, k); });
+        int bestStart = 0;
+        for (int k = 1; k < starts; k++) {
+            if (results[k].cost < results[bestStart].cost) bestStart = k;
+        }
+        VrpSolver::Solution& best = results[bestStart];
+        VrpSolver::Solution start = solver.savings();
+        plan.savingsUnassigned = (int)start.unassigned.size();
+        plan.savingsCost = start.cost - solver.unassignedPenalty() * start.unassigned.size(); // Routes only.
+        plan.solutions = (long long)starts * iterations;
+
+        // Re-orders the stops of every route, keeping the new order only if it's cheaper.
+        for (vector<int>& route : best.routes) {
+            vector<int> local(1, 0);
+            local.insert(local.end(), route.begin(), route.end());
+            int k = (int)local.size();
+            vector<double> sub((size_t)k * k);
+            for (int a = 0; a < k; a++) {
+                for (int b = 0; b < k; b++) sub[(size_t)a * k + b] = costs[(size_t)local[a] * n + local[b]];
+            }
+            TourSolver tsp(sub, k, true);
+            vector<int> order = tsp.solve();
+            vector<int> identity(k);
+            for (int a = 0; a < k; a++) identity[a] = a;
+            if (tsp.tourCost(order) >= tsp.tourCost(identity)) continue;
+            for (int a = 1; a < k; a++) route[a - 1] = local[order[a]];
+        }
+        auto t2 = chrono::steady_clock::now();
+        plan.solveMs = chrono::duration<double, milli>(t2 - t1).count();
+        if (!best.unassigned.empty()) return plan; // The orders don't fit the vehicles available.
+
+        plan.routes.resize(best.routes.size());
+        plan.orders.resize(best.routes.size());
+        plan.loads = best.load;
+        for (size_t r = 0; r < best.routes.size(); r++) {
+            for (int order : best.routes[r]) plan.orders[r].push_back(order - 1); // Node 0 is the depot.
+        }
+        parallelFor((int)best.routes.size(), threads, [&](int r, int) {
+            TourResult& tour = plan.routes[r];
+            tour.speed = problem.speed;
+            tour.vehicle = problem.vehicle;
+            tour.stops.push_back(problem.depot);
+            for (int order : best.routes[r]) tour.stops.push_back(nodes[order]);
+            tour.stops.push_back(problem.depot);
+            planTourLegs(tour, 1);
+        });
+        for (const TourResult& tour : plan.routes) {
+            plan.totalTime += tour.totalTime;
+            plan.totalDist += tour.totalDist;
+            plan.totalFuel += tour.totalFuel;
+            plan.fuelCost += tour.fuelCost;
+        }
+        plan.totalCost = plan.fuelCost + plan.totalTime / 60 * problem.costPerHour;
+        plan.found = true;
+        plan.legsMs = chrono::duration<double, milli>(chrono::steady_clock::now() - t2).count();
+        return plan;
+    }
+
+    // Prints the fleet plan of 'problem': one line per vehicle with its load, time, distance,
+    // fuel and cost, followed by the cities it visits.
+    void findFleetPlan(const FleetProblem& problem) {
+        FleetPlan plan = planFleet(problem);
+        if (!plan.found) {
+            cout << "\nError: Invalid city, an order larger than a vehicle, an unreachable stop, or too few vehicles." << endl;
+            return;
+        }
+        const VehicleProfile& vehicle = getVehicleProfile(problem.vehicle);
+        cout << "\n Fleet plan: " << problem.orders.size() << " orders from " << cityNames[problem.depot] << ", "
+             << plan.routes.size() << " x " << vehicle.getName() << " (capacity " << problem.capacity << ") at "
+             << problem.speed << " km/h" << endl;
+        cout << "--------------------------------------------------------" << endl;
+        cout << left << setw(4) << " #" << setw(8) << "Load" << setw(10) << "Time" << setw(13) << "  Dist."
+             << setw(10) << " Fuel" << "Cost" << endl;
+        cout << "--------------------------------------------------------" << endl;
+        for (size_t r = 0; r < plan.routes.size(); r++) {
+            const TourResult& tour = plan.routes[r];
+            string time = to_string((int)tour.totalTime / 60) + "h " + to_string((int)tour.totalTime % 60) + "m";
+            cout << left << " " << setw(3) << r + 1 << setw(8) << fixed << setprecision(0) << plan.loads[r]
+                 << setw(10) << time << setprecision(1) << right << setw(7) << tour.totalDist << " km   "
+                 << setw(6) << tour.totalFuel << " L   " << "Rs. " << setprecision(0)
+                 << tour.fuelCost + tour.totalTime / 60 * problem.costPerHour << endl;
+            string via = "    via";     // Cities along this route, depot to depot.
+            for (int city : tour.stops) via += " " + cityNames[city];
+            cout << via << endl;
+        }
+        cout << "--------------------------------------------------------" << endl;
+        cout << " Total: " << setprecision(1) << plan.totalDist << " km, " << plan.totalFuel << " L, "
+             << (int)plan.totalTime / 60 << "h " << (int)plan.totalTime % 60 << "m driving" << endl;
+        cout << " Cost : Rs. " << setprecision(0) << plan.totalCost << " (fuel " << plan.fuelCost << ", drivers "
+             << plan.totalCost - plan.fuelCost << ")" << endl;
+        cout << "--------------------------------------------------------" << endl;
+    }
+
+    // Prints the Pareto frontier between two cities: faster routes first, every later one
+    // cheaper in fuel or shorter than all faster ones.
+    void findParetoRoutes(int startNode, int endNode, int speed, VehicleKind vehicle = PETROL_CAR) {
+        if (startNode < 1 || startNode > cityCount || endNode < 1 || endNode > cityCount) {
+            cout << "Invalid City ID Selected!" << endl;
+            return;
+        }
+        vector<ParetoRoute> frontier = computeParetoRoutes(startNode, endNode, speed, 8, vehicle);
+        if (frontier.empty()) {
+            cout << "\nError: No road connection exists between these cities." << endl;
+            return;
+        }
+
+        cout << "\n Route options: " << cityNames[startNode] << " -> " << cityNames[endNode]
+             << " at " << speed << " km/h" << endl;
+        cout << "--------------------------------------------------------" << endl;
+        cout << left << setw(4) << " #" << setw(10) << "Time" << setw(13) << "  Dist."
+             << setw(10) << " Fuel" << "Cost" << endl;
+        cout << "--------------------------------------------------------" << endl;
+        for (size_t k = 0; k < frontier.size(); k++) {
+            const ParetoRoute& option = frontier[k];
+            string time = to_string((int)option.totalTime / 60) + "h " + to_string((int)option.totalTime % 60) + "m";
+            cout << left << " " << setw(3) << k + 1 << setw(10) << time
+                 << fixed << setprecision(1) << right << setw(7) << option.totalDist << " km   "
+                 << setw(6) << option.totalFuel << " L   "
+                 << "Rs. " << setprecision(0) << option.totalFuel * getVehicleProfile(vehicle).getFuelPrice() << endl;
+            string via = "    via";     // Cities along this option.
+            for (int city : option.route) via += " " + cityNames[city];
+            cout << via << endl;
+        }
+        cout << "--------------------------------------------------------" << endl;
+    }
+
+    // Prints the fastest route and up to maxRoutes - 1 alternatives, each with its extra
+    // time over the fastest route, the share of it driven on earlier options and its roads.
+    void findAlternativeRoutes(int startNode, int endNode, int speed, int maxRoutes = 3) {
+        if (startNode < 1 || startNode > cityCount || endNode < 1 || endNode > cityCount) {
+            cout << "Invalid City ID Selected!" << endl;
+            return;
+        }
+        AlternativeLimits limits;
+        limits.maxRoutes = maxRoutes;
+        vector<AlternativeRoute> options = planAlternativeRoutes(startNode, endNode, speed, limits);
+        if (options.empty()) {
+            cout << "\nError: No road connection exists between these cities." << endl;
+            return;
+        }
+
+        cout << "\n Alternative routes: " << cityNames[startNode] << " -> " << cityNames[endNode]
+             << " at " << speed << " km/h" << endl;
+        cout << "--------------------------------------------------------" << endl;
+        cout << left << setw(4) << " #" << setw(10) << "Time" << setw(13) << "  Dist."
+             << setw(10) << " Fuel" << setw(9) << "Extra" << "Shared" << endl;
+        cout << "--------------------------------------------------------" << endl;
+        for (size_t k = 0; k < options.size(); k++) {
+            const RouteResult& option = options[k].result;
+            string time = to_string((int)option.totalTime / 60) + "h " + to_string((int)option.totalTime % 60) + "m";
+            cout << left << " " << setw(3) << k + 1 << setw(10) << time
+                 << fixed << setprecision(1) << right << setw(7) << option.totalDist << " km   "
+                 << setw(6) << option.totalFuel << " L   "
+                 << setw(4) << setprecision(0) << options[k].stretch * 100 << "%   "
+                 << setw(4) << options[k].sharing * 100 << "%" << endl;
+            string via = "    via";     // Roads along this option, each named once per stretch.
+            string previous;
+            for (const RouteLeg& leg : option.legs) {
+                string name = roadNames[edgeNameId[leg.road]];
+                if (name != previous) via += (previous.empty() ? " " : ", ") + name;
+                previous = name;
+            }
+            cout << via << endl;
+        }
+        cout << "--------------------------------------------------------" << endl;
+    }
+
+    // ==========================================
+    //          OUTPUT FORMATTING
+    // ==========================================
+    // Function to print the final results table of a planned route.
+    // Every leg names the road the search actually used, so parallel roads print correctly.
+    void printDetailedReceipt(const RouteResult& result, ostream& out = cout) {
+        if (result.departure >= 0) { // Time-dependent routes also show the clock times.
+            out << "\n Departure   : " << formatClock(result.departure) << endl;
+            out << " Arrival     : " << formatClock(result.departure + result.totalTime) << endl;
+        }
+        out << "\n";
+        out << "########################################################" << endl;
+        out << "              SMART ROUTE NAVIGATOR RESULTS             " << endl;
+        out << "########################################################" << endl;
+        out << " Origin      : " << cityNames[result.startNode] << endl; // Prints origin city name.
+        out << " Destination : " << cityNames[result.endNode] << endl;   // Prints destination city name.
+        out << " Avg Speed   : " << result.speed << " km/h" << endl;     // Prints user speed.
+        printVehicleLine(result.vehicle, out);
+        out << "--------------------------------------------------------" << endl;
+        printLegHeader(out);
+        printLegRows(result.legs, out);
+        out << "--------------------------------------------------------" << endl;
+        printTotals(result.totalTime, result.totalDist, result.totalFuel, result.fuelCost, out);
+        out << "########################################################" << endl;
+        out << "Note: Traffic conditions may vary based on weather." << endl;
+    }
+
+    // Prints the itinerary of a multi-stop run in the same layout as printDetailedReceipt:
+    // one block of roads per stop-to-stop leg, then the totals of the whole run.
+    void printTourReceipt(const TourResult& tour, ostream& out = cout) {
+        int stopCount = (int)tour.stops.size() - (tour.roundTrip && tour.stops.size() > 1 ? 1 : 0);
+        out << "\n";
+        out << "########################################################" << endl;
+        out << "              SMART ROUTE NAVIGATOR RESULTS             " << endl;
+        out << "########################################################" << endl;
+        out << " Depot       : " << cityNames[tour.stops[0]] << endl;
+        out << " Stops       : " << stopCount - 1 << (tour.roundTrip ? " (round trip)" : " (ends at last stop)") << endl;
+        out << " Avg Speed   : " << tour.speed << " km/h" << endl;
+        printVehicleLine(tour.vehicle, out);
+        out << " Order       : " << (tour.exact ? "optimal" : "local search") << " for least "
+            << (tour.objective == TOUR_FUEL ? "fuel" : "time") << endl;
+        out << "--------------------------------------------------------" << endl;
+        printLegHeader(out);
+        for (size_t k = 0; k < tour.legs.size(); k++) {
+            const RouteResult& leg = tour.legs[k];
+            if (k > 0) out << "--------------------------------------------------------" << endl;
+            bool back = tour.roundTrip && k + 1 == tour.legs.size(); // Last leg of a round trip.
+            out << (back ? " Return" : " Stop " + to_string(k + 1)) << ": " << cityNames[leg.startNode] << " -> " << cityNames[leg.endNode]
+                << " (" << (int)leg.totalTime / 60 << "h " << (int)leg.totalTime % 60 << "m)" << endl;
+            printLegRows(leg.legs, out);
+        }
+        out << "--------------------------------------------------------" << endl;
+        printTotals(tour.totalTime, tour.totalDist, tour.totalFuel, tour.fuelCost, out);
+        out << "########################################################" << endl;
+        out << "Note: Traffic conditions may vary based on weather." << endl;
+    }
+
+    // Receipt line naming the vehicle, its fuel and the fuel price.
+    void printVehicleLine(VehicleKind kind, ostream& out) {
+        const VehicleProfile& vehicle = getVehicleProfile(kind);
+        out << " Vehicle     : " << vehicle.getName() << " (" << (vehicle.getFuel() == DIESEL ? "diesel" : "petrol")
+            << ", PKR " << (int)vehicle.getFuelPrice() << "/L)" << endl;
+    }
+
+    // Receipt table header.
+    void printLegHeader(ostream& out) {
+        // Sets up table headers with specific widths.
+        out << left << setw(20) << "Leg From -> To" 
+            << setw(18) << "Via Road" 
+            << setw(10) << "Cond." 
+            << "Dist." << endl;
+        out << "--------------------------------------------------------" << endl;
+    }
+
+    // Receipt rows: one per road driven, in travel order.
+    void printLegRows(const vector<RouteLeg>& legs, ostream& out) {
+        for (const RouteLeg& step : legs) {
+            string rName = roadNames[edgeNameId[step.road]]; // Get road name from the shared table.
+            string tCond = getTrafficString(step.traffic);   // Traffic as it was when the legs were filled.
+
+            string leg = cityNames[step.from] + "->" + cityNames[step.to]; // Create string "CityA->CityB".
+            // Truncate leg name if too long for cleaner output alignment.
+            if(leg.length() > 18) leg = leg.substr(0, 18);
+
+            // Print the row for this leg of the journey.
+            out << left << setw(20) << leg
+                << setw(18) << rName 
+                << setw(10) << tCond 
+                << step.distanceKM << " km" << endl;
+        }
+    }
+
+    // Receipt summary totals.
+    void printTotals(double totalTime, double totalDist, double totalFuel, double fuelCost, ostream& out) {
+        // Final Calculations for time and cost.
+        int hrs = (int)totalTime / 60;  // Convert total minutes to hours.
+        int mins = (int)totalTime % 60; // Get remaining minutes.
+
+        // Print the final summary totals.
+        out << right << setw(35) << "TOTAL DISTANCE : " << setw(10) << totalDist << " km" << endl;
+        out << right << setw(35) << "ESTIMATED TIME : " << hrs << "h " << mins << "m" << endl;
+        out << right << setw(35) << "FUEL REQUIRED : " << fixed << setprecision(1) << totalFuel << " L" << endl;
+        out << right << setw(35) << "EST. FUEL COST : " << "PKR " << setprecision(2) << fuelCost << endl;
+    }
+
+    // Function to display the list of cities to the user.
+    void displayMenu() {
+        cout << "\n--- AVAILABLE CITIES ---" << endl;
+        for (int i = 1; i <= cityCount; i++) {
+            // Prints ID and Name in 3 columns for better layout.
+            cout << left << setw(3) << i << ". " << setw(15) << cityNames[i];
+            if (i % 3 == 0) cout << endl; // Inserts a new line every 3 cities.
+        }
+        if (cityCount % 3 != 0) cout << endl; // Ensures final newline if not divisible by 3.
+    }
+};
+
+// ==========================================
+//      ROAD NETWORK IMPORT
+// ==========================================
+// Streams node and road extracts into a RoutePlanner. Files are read in fixed-size chunks
+// cut at line ends; each batch of chunks (one per thread) is parsed in parallel into
+// compact records, which are then added to the planner in file order. At most one batch of
+// raw text is held in memory at a time, whatever the file size.
+//
+// CSV (fields separated by commas, optional surrounding double quotes, header line optional):
+//   nodes: id,name,lat,lon
+//   roads: from,to,length_km,class,name[,maxspeed[,speed[,traffic]]]
+// OSM-like text (one element per line, nodes before the ways that use them):
+//   node <id> <lat> <lon> [name=<rest of line>]
+//   way <id> <node>,<node>,... [class=<c>] [maxspeed=<kmh>] [speed=<kmh>] [traffic=<t>] [name=<rest of line>]
+// Node IDs may be any 64-bit numbers; cities get IDs 1, 2, ... in file order. A way becomes
+// one road per pair of consecutive nodes, as long as the straight line between them. Roads
+// with an empty length are also measured from the node locations. Roads are always two-way.
+//
+// Road classes map onto RoadType: motorway (and _link) -> MOTORWAY; trunk, primary,
+// secondary, highway (and _link) -> HIGHWAY; anything else -> LOCAL. An explicit traffic tag
+// (low/clear, moderate, high/heavy, jammed) wins; otherwise the observed speed over the speed
+// limit gives the level (>= 0.8 low, >= 0.6 moderate, >= 0.35 high, below that jammed), and a
+// road without both is taken as clear.
+
+// Counters of one import.
+struct ImportStats {
+    long long nodes = 0;          // Cities added.
+    long long roads = 0;          // Two-way roads added (two directed roads each).
+    long long skipped = 0;        // Lines that could not be used (bad fields, unknown nodes, duplicates).
+    long long bytes = 0;          // Text read.
+    double parseSeconds = 0;      // Reading, parsing and adding to the planner.
+    double buildSeconds = 0;      // Compressing the roads into the CSR graph.
+};
+
+class RoadNetworkImporter {
+private:
+    // One parsed node.
+    struct NodeRecord {
+        long long id;             // ID used in the file.
+        double lat, lon;          // Location in degrees.
+        string name;              // Name (empty = "Node <id>").
+    };
+    // One parsed road, already resolved to city IDs.
+    struct RoadRecord {
+        int u, v;                 // The two cities.
+        double distanceKM;        // Length of the road.
+        TrafficLevel traffic;     // Traffic condition.
+        RoadType type;            // Road category.
+        int name;                 // Index into the chunk's name list.
+    };
+    // Everything parsed from one chunk.
+    struct ChunkResult {
+        vector<NodeRecord> nodes;
+        vector<RoadRecord> roads;
+        vector<string> names;     // Road names used by the chunk's roads.
+        long long skipped = 0;
+    };
+
+    RoutePlanner& planner;        // Planner receiving the map.
+    int threads;                  // Parser threads (0 = all cores).
+    size_t chunkBytes;            // Text read per chunk.
+    unordered_map<long long, int> cityOf; // City ID of every file node ID.
+    vector<double> lat, lon;      // Location of every city added so far (index 0 unused).
+    ImportStats stats;
+
+    // Reads 'path' chunk by chunk, parsing every batch of chunks in parallel and then
+    // committing the results in file order. Returns false if the file can't be opened.
+    template <typename Parse>
+    bool streamFile(const string& path, Parse parse) {
+        ifstream in(path, ios::binary);
+        if (!in) return false;
+        int workers = resolveThreadCount(threads);
+        vector<string> chunks(workers);
+        vector<ChunkResult> results(workers);
+        string carry;             // Start of a line cut off at the end of the previous chunk.
+        bool finished = false;
+        while (!finished) {
+            int filled = 0;
+            while (filled < workers && !finished) {
+                string& chunk = chunks[filled];
+                chunk.swap(carry);
+                carry.clear();
+                size_t kept = chunk.size();
+                chunk.resize(kept + chunkBytes);
+                in.read(&chunk[kept], chunkBytes);
+                size_t got = (size_t)in.gcount();
+                chunk.resize(kept + got);
+                stats.bytes += got;
+                if (got < chunkBytes) finished = true;
+                if (!finished) {
+                    size_t cut = chunk.rfind('\n');
+                    if (cut == string::npos) { carry.swap(chunk); continue; } // A very long line: read on.
+                    carry.assign(chunk, cut + 1, string::npos);
+                    chunk.resize(cut + 1);
+                }
+                if (!chunk.empty()) filled++;
+            }
+            parallelFor(filled, workers, [&](int i, int) {
+                results[i] = ChunkResult();
+                const char* p = chunks[i].data();
+                const char* end = p + chunks[i].size();
+                while (p < end) {
+                    const char* lineEnd = (const char*)memchr(p, '\n', end - p);
+                    if (!lineEnd) lineEnd = end;
+                    const char* stop = lineEnd;
+                    if (stop > p && stop[-1] == '\r') stop--;
+                    if (stop > p) parse(p, stop, results[i]);
+                    p = lineEnd + 1;
+                }
+            });
+            for (int i = 0; i < filled; i++) commit(results[i]);
+        }
+        return true;
+    }
+
+    // Adds the records of one chunk to the planner.
+    void commit(ChunkResult& result) {
+        stats.skipped += result.skipped;
+        for (NodeRecord& node : result.nodes) {
+            if (cityOf.count(node.id)) { stats.skipped++; continue; } // Duplicate node.
+            int city = (int)lat.size();
+            cityOf[node.id] = city;
+            lat.push_back(node.lat);
+            lon.push_back(node.lon);
+            planner.addCity(city, node.name.empty() ? "Node " + to_string(node.id) : node.name, node.lat, node.lon);
+            stats.nodes++;
+        }
+        for (const RoadRecord& road : result.roads) {
+            planner.addRoad(road.u, road.v, road.distanceKM, road.traffic, road.type, result.names[road.name]);
+            stats.roads++;
+        }
+    }
+
+    // City ID of a file node ID (0 if unknown). Safe to call from parser threads.
+    int cityFor(long long id) const {
+        auto found = cityOf.find(id);
+        return found == cityOf.end() ? 0 : found->second;
+    }
+
+    // Splits a CSV line into at most 'maxFields' fields, dropping surrounding quotes.
+    static int splitCsv(const char* p, const char* end, string* fields, int maxFields) {
+        int count = 0;
+        while (count < maxFields) {
+            const char* comma = (const char*)memchr(p, ',', end - p);
+            const char* fieldEnd = comma ? comma : end;
+            const char* a = p;
+            const char* b = fieldEnd;
+            while (a < b && *a == ' ') a++;
+            while (b > a && b[-1] == ' ') b--;
+            if (b - a >= 2 && *a == '"' && b[-1] == '"') { a++; b--; }
+            fields[count++].assign(a, b);
+            if (!comma) break;
+            p = comma + 1;
+        }
+        return count;
+    }
+
+    // Parses a whole field as a number. Returns false if it is empty or not a number.
+    static bool toNumber(const string& text, double& value) {
+        if (text.empty()) return false;
+        char* stop;
+        value = strtod(text.c_str(), &stop);
+        return *stop == '\0';
+    }
+    static bool toId(const string& text, long long& value) {
+        if (text.empty()) return false;
+        char* stop;
+        value = strtoll(text.c_str(), &stop, 10);
+        return *stop == '\0';
+    }
+
+    // Returns the next space-separated word at p (empty at the end) and moves p past it.
+    static string nextWord(const char*& p, const char* end) {
+        while (p < end && *p == ' ') p++;
+        const char* start = p;
+        while (p < end && *p != ' ') p++;
+        return string(start, p);
+    }
+
+    // Straight-line length of a road between two imported cities.
+    double straightLength(int u, int v) const { return greatCircleKM(lat[u], lon[u], lat[v], lon[v]); }
+
+public:
+    RoadNetworkImporter(RoutePlanner& target, int threadCount = 0, size_t chunkSize = 4 << 20)
+        : planner(target), threads(threadCount), chunkBytes(max<size_t>(chunkSize, 1024)), lat(1, 0), lon(1, 0) {}
+
+    // Maps a road class tag onto a RoadType.
+    static RoadType roadTypeOf(string tag) {
+        for (char& c : tag) c = (char)tolower((unsigned char)c);
+        if (tag.size() > 5 && tag.compare(tag.size() - 5, 5, "_link") == 0) tag.resize(tag.size() - 5);
+        if (tag == "motorway") return MOTORWAY;
+        if (tag == "trunk" || tag == "primary" || tag == "secondary" || tag == "highway") return HIGHWAY;
+        return LOCAL;
+    }
+
+    // Maps traffic and speed tags onto a TrafficLevel (see the format notes above).
+    // Empty tags and non-positive speeds count as missing.
+    static TrafficLevel trafficLevelOf(string tag, double maxSpeed, double speed) {
+        for (char& c : tag) c = (char)tolower((unsigned char)c);
+        if (tag == "low" || tag == "clear") return LOW;
+        if (tag == "moderate") return MODERATE;
+        if (tag == "high" || tag == "heavy") return HIGH;
+        if (tag == "jammed") return JAMMED;
+        if (maxSpeed <= 0 || speed <= 0) return LOW;
+        double ratio = speed / maxSpeed;
+        if (ratio >= 0.8) return LOW;
+        if (ratio >= 0.6) return MODERATE;
+        if (ratio >= 0.35) return HIGH;
+        return JAMMED;
+    }
+
+    // Imports a node CSV and a road CSV. Returns false if a file can't be opened.
+    bool importCsv(const string& nodePath, const string& roadPath) {
+        auto t0 = chrono::steady_clock::now();
+        bool ok = streamFile(nodePath, [](const char* p, const char* end, ChunkResult& out) {
+            string f[4];
+            NodeRecord node;
+            if (splitCsv(p, end, f, 4) < 4 || !toId(f[0], node.id) || !toNumber(f[2], node.lat) || !toNumber(f[3], node.lon)) {
+                if (!f[0].empty() && !isdigit((unsigned char)f[0][0]) && f[0][0] != '-') return; // Header line.
+                out.skipped++;
+                return;
+            }
+            node.name = f[1];
+            out.nodes.push_back(node);
+        });
+        ok = ok && streamFile(roadPath, [this](const char* p, const char* end, ChunkResult& out) {
+            string f[8];
+            int count = splitCsv(p, end, f, 8);
+            long long from, to;
+            if (count < 5 || !toId(f[0], from) || !toId(f[1], to)) {
+                if (!f[0].empty() && !isdigit((unsigned char)f[0][0]) && f[0][0] != '-') return; // Header line.
+                out.skipped++;
+                return;
+            }
+            int u = cityFor(from), v = cityFor(to);
+            if (u == 0 || v == 0) { out.skipped++; return; }
+            double length = 0, maxSpeed = 0, speed = 0;
+            if (!toNumber(f[2], length) || length <= 0) length = straightLength(u, v);
+            if (count > 5) toNumber(f[5], maxSpeed);
+            if (count > 6) toNumber(f[6], speed);
+            out.names.push_back(f[4]);
+            out.roads.push_back({u, v, length, trafficLevelOf(count > 7 ? f[7] : "", maxSpeed, speed),
+                                 roadTypeOf(f[3]), (int)out.names.size() - 1});
+        });
+        finish(t0);
+        return ok;
+    }
+
+    // Imports an OSM-like text file. Returns false if it can't be opened.
+    // The file is read twice: first for the nodes, then for the ways, because a way must
+    // not be parsed in the same batch as the nodes it uses.
+    bool importOsmText(const string& path) {
+        auto t0 = chrono::steady_clock::now();
+        bool ok = true;
+        for (int pass = 0; pass < 2 && ok; pass++) ok = streamFile(path, [this, pass](const char* p, const char* end, ChunkResult& out) {
+            bool isNode = end - p > 5 && memcmp(p, "node ", 5) == 0;
+            bool isWay = end - p > 4 && memcmp(p, "way ", 4) == 0;
+            if (pass == 1 && !isNode && !isWay) out.skipped++; // Unknown line (counted once).
+            if (pass == 0 ? !isNode : !isWay) return;           // Not this pass's kind of line.
+            // The name tag runs to the end of the line; everything before it is split on spaces.
+            const char* nameAt = p;
+            while ((nameAt = (const char*)memchr(nameAt, ' ', end - nameAt)) && (end - nameAt < 6 || memcmp(nameAt, " name=", 6) != 0)) nameAt++;
+            string name = nameAt ? string(nameAt + 6, end) : "";
+            if (nameAt) end = nameAt;
+            string kind = nextWord(p, end);
+            if (kind == "node") {
+                NodeRecord node;
+                if (!toId(nextWord(p, end), node.id) || !toNumber(nextWord(p, end), node.lat) ||
+                    !toNumber(nextWord(p, end), node.lon)) { out.skipped++; return; }
+                node.name = name;
+                out.nodes.push_back(node);
+            } else if (kind == "way") {
+                long long id;
+                string refs, tag, roadClass, traffic;
+                double maxSpeed = 0, speed = 0;
+                if (!toId(nextWord(p, end), id) || (refs = nextWord(p, end)).empty()) { out.skipped++; return; }
+                while (!(tag = nextWord(p, end)).empty()) {
+                    size_t eq = tag.find('=');
+                    if (eq == string::npos) continue;
+                    string key = tag.substr(0, eq), value = tag.substr(eq + 1);
+                    if (key == "class" || key == "highway") roadClass = value;
+                    else if (key == "maxspeed") toNumber(value, maxSpeed);
+                    else if (key == "speed") toNumber(value, speed);
+                    else if (key == "traffic") traffic = value;
+                }
+                RoadType type = roadTypeOf(roadClass);
+                TrafficLevel level = trafficLevelOf(traffic, maxSpeed, speed);
+                out.names.push_back(name.empty() ? "Way " + to_string(id) : name);
+                int previous = 0;
+                size_t start = 0;
+                while (start <= refs.size()) {
+                    size_t comma = refs.find(',', start);
+                    if (comma == string::npos) comma = refs.size();
+                    long long ref;
+                    int city = toId(refs.substr(start, comma - start), ref) ? cityFor(ref) : 0;
+                    if (city == 0) {
+                        out.skipped++;    // Unknown node: the way is cut there.
+                    } else if (previous != 0 && previous != city) {
+                        out.roads.push_back({previous, city, straightLength(previous, city), level, type, (int)out.names.size() - 1});
+                    }
+                    previous = city;
+                    start = comma + 1;
+                }
+            }
+        });
+        finish(t0);
+        return ok;
+    }
+
+    const ImportStats& getStats() const { return stats; }
+
+private:
+    // Builds the CSR graph and records the timings of an import.
+    void finish(chrono::steady_clock::time_point t0) {
+        auto t1 = chrono::steady_clock::now();
+        planner.getEdgeCount();   // Forces the CSR build.
+        auto t2 = chrono::steady_clock::now();
+        stats.parseSeconds += chrono::duration<double>(t1 - t0).count();
+        stats.buildSeconds += chrono::duration<double>(t2 - t1).count();
+    }
+};
+
+// Prints the counters of an import with its rate in directed roads per second.
+void printImportStats(const ImportStats& stats) {
+    double seconds = stats.parseSeconds + stats.buildSeconds;
+    cout << fixed << setprecision(2);
+    cout << "  " << stats.nodes << " cities, " << stats.roads * 2 << " directed roads, " << stats.skipped
+         << " lines skipped, " << stats.bytes / double(1 << 20) << " MiB read" << endl;
+    cout << "  parse " << stats.parseSeconds * 1000 << " ms + build " << stats.buildSeconds * 1000 << " ms = "
+         << setprecision(0) << (seconds > 0 ? stats.roads * 2 / seconds : 0) << " edges/s" << setprecision(2) << endl;
+}
+
+// ==========================================
+//      QUERY SERVER
+// ==========================================
+// Keeps one RoutePlanner in memory and answers route requests from local clients, one per
+// line, over stdin/stdout or a Unix domain socket:
+//   <requestId> <startId> <destinationId> <speed> [dijkstra|bidir|astar|ch|alt|crp] [car|truck|bus]
+//       -> <requestId> OK <minutes> <km> <litres> <PKR> <city>,<city>,...
+//       -> <requestId> ERR <reason>
+//   stats    -> STATS served=<n> p50_us=<t> p99_us=<t> max_us=<t> (since the server started)
+//   metrics  -> the query histograms (METRIC lines, then END) of a -DROUTE_METRICS build.
+//   shutdown -> BYE, then a socket server stops once the requests already read are answered.
+// One reader per connection only splits lines and queues them. A pool of workers takes up to
+// batchSize requests at a time, answers them and sends each connection its answers in one
+// write. The queue holds at most 'capacity' requests: once it is full the readers stop
+// reading, so a client that sends too fast is held back by its pipe or socket buffer instead
+// of growing the server's memory. Answers carry the request ID and may come back out of order.
+// Traffic must not be changed while the server runs (prepared search modes would go stale).
+class QueryServer {
+private:
+    // One client: where its answers go. The socket is closed when the last answer is sent.
+    struct Connection {
+        int fd = -1;              // Socket of the client (-1 = answers go to 'stream').
+        ostream* stream = nullptr; // Output stream of a stdin/stdout client.
+        mutex writeMutex;         // Keeps the answers of different workers from interleaving.
+
+        ~Connection() {
+#ifndef _WIN32
+            if (fd >= 0) ::close(fd);
+#endif
+        }
+
+        // Sends a block of answers. Answers to a client that went away are dropped.
+        void send(const string& text) {
+            lock_guard<mutex> lock(writeMutex);
+            if (stream) {
+                stream->write(text.data(), text.size());
+                stream->flush();
+                return;
+            }
+#ifndef _WIN32
+            for (size_t done = 0; done < text.size();) {
+                ssize_t sent = ::send(fd, text.data() + done, text.size() - done, MSG_NOSIGNAL);
+                if (sent <= 0) return;
+                done += (size_t)sent;
+            }
+#endif
+        }
+    };
+
+    // One request line waiting for a worker.
+    struct Request {
+        shared_ptr<Connection> connection; // Where the answer goes.
+        string line;                       // The request as received.
+        chrono::steady_clock::time_point received; // When the reader queued it.
+    };
+
+    static const int LATENCY_BUCKETS = 640; // 16 buckets per doubling, from 1 us to about 2^40 us.
+
+    RoutePlanner& planner;
+    int workerCount;              // Worker threads (0 = all cores).
+    size_t capacity;              // Most requests waiting at once.
+    int batchSize;                // Most requests a worker takes at a time.
+    deque<Request> queue;         // Requests waiting for a worker.
+    mutex queueMutex;             // Guards the queue and 'draining'.
+    condition_variable notEmpty;  // Signalled when a request is queued (or the server drains).
+    condition_variable notFull;   // Signalled when workers take requests off a full queue.
+    bool draining;                // Workers stop once the queue is empty.
+    vector<thread> workers;
+    bool prepared[PARTITION_OVERLAY + 1]; // Search modes prepared by start() (the ones served).
+    mutex latencyMutex;           // Guards the latency histogram.
+    vector<long long> latencyCount; // Requests answered per latency bucket.
+    long long served;             // Requests answered so far.
+    double slowestMicros;         // Slowest answer so far.
+    atomic<bool> stopping;        // Set by a "shutdown" request.
+    int listenFd;                 // Listening socket of serveUnixSocket (-1 = none).
+    mutex clientMutex;            // Guards clientFds.
+    vector<int> clientFds;        // Sockets whose readers are still running.
+
+    static int latencyBucket(double micros) {
+        if (micros < 1) return 0;
+        return min(LATENCY_BUCKETS - 1, 1 + (int)(log2(micros) * 16));
+    }
+
+    static double bucketLimit(int bucket) { // Largest latency counted in a bucket.
+        return bucket == 0 ? 1 : exp2(bucket / 16.0);
+    }
+
+    // Queues one request, waiting while the queue is full (backpressure).
+    void push(const shared_ptr<Connection>& connection, string line) {
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (line.empty()) return;
+        Request request = {connection, std::move(line), chrono::steady_clock::now()};
+        {
+            unique_lock<mutex> lock(queueMutex);
+            notFull.wait(lock, [&] { return queue.size() < capacity; });
+            queue.push_back(std::move(request));
+        }
+        notEmpty.notify_one();
+    }
+
+    // Answers one request line (with its newline).
+    string answer(const string& line) {
+        if (line == "stats") return latencySummary() + "\n";
+        if (line == "metrics") {
+#ifdef ROUTE_METRICS
+            ostringstream out;
+            queryMetrics().dump(out);
+            return out.str() + "END\n";
+#else
+            return "ERR metrics disabled (build with -DROUTE_METRICS)\n";
+#endif
+        }
+        if (line == "shutdown") {
+            requestShutdown();
+            return "BYE\n";
+        }
+        char id[64], modeName[32] = "dijkstra", vehicleName[32] = "car";
+        int start, destination, speed;
+        int fields = sscanf(line.c_str(), "%63s %d %d %d %31s %31s", id, &start, &destination, &speed, modeName, vehicleName);
+        if (fields < 1) return "- ERR empty request\n";
+        if (fields < 4) return string(id) + " ERR expected: <requestId> <startId> <destinationId> <speed> [mode] [vehicle]\n";
+        SearchMode mode;
+        if (!parseMode(modeName, mode)) return string(id) + " ERR unknown mode " + modeName + "\n";
+        VehicleKind vehicle;
+        if (!parseVehicleName(vehicleName, vehicle)) return string(id) + " ERR unknown vehicle " + vehicleName + "\n";
+        if (speed < 1) return string(id) + " ERR speed must be positive\n";
+        if (start < 1 || start > planner.getCityCount() || destination < 1 || destination > planner.getCityCount()) {
+            return string(id) + " ERR unknown city\n";
+        }
+        if (!prepared[mode]) return string(id) + " ERR mode " + modeName + " not served\n";
+
+        RouteResult result = planner.planRoute(start, destination, speed, mode, vehicle);
+        if (!result.found) return string(id) + " ERR no road connection\n";
+        char numbers[160];
+        snprintf(numbers, sizeof(numbers), " OK %.3f %.3f %.3f %.2f ", result.totalTime, result.totalDist,
+                 result.totalFuel, result.fuelCost);
+        string text = string(id) + numbers;
+        for (size_t k = 0; k < result.route.size(); k++) {
+            if (k > 0) text += ',';
+            text += to_string(result.route[k]);
+        }
+        text += '\n';
+        return text;
+    }
+
+    // Worker loop: takes a batch, answers it, sends every connection its answers at once.
+    void work() {
+        vector<Request> batch;
+        vector<string> answers;
+        vector<char> sent;
+        vector<double> latencies;
+        while (true) {
+            batch.clear();
+            {
+                unique_lock<mutex> lock(queueMutex);
+                notEmpty.wait(lock, [&] { return !queue.empty() || draining; });
+                if (queue.empty()) return; // Draining and nothing left.
+                while (!queue.empty() && (int)batch.size() < batchSize) {
+                    batch.push_back(std::move(queue.front()));
+                    queue.pop_front();
+                }
+            }
+            notFull.notify_all();
+
+            answers.resize(batch.size());
+            for (size_t k = 0; k < batch.size(); k++) answers[k] = answer(batch[k].line);
+            sent.assign(batch.size(), 0);
+            for (size_t k = 0; k < batch.size(); k++) {
+                if (sent[k]) continue;
+                string text;
+                for (size_t j = k; j < batch.size(); j++) {
+                    if (sent[j] || batch[j].connection != batch[k].connection) continue;
+                    text += answers[j];
+                    sent[j] = 1;
+                }
+                batch[k].connection->send(text);
+            }
+
+            auto now = chrono::steady_clock::now();
+            latencies.clear();
+            for (auto& request : batch) latencies.push_back(chrono::duration<double, micro>(now - request.received).count());
+            lock_guard<mutex> lock(latencyMutex);
+            for (double micros : latencies) {
+                latencyCount[latencyBucket(micros)]++;
+                slowestMicros = max(slowestMicros, micros);
+            }
+            served += (long long)latencies.size();
+        }
+    }
+
+    // Reads request lines from a client socket until it closes or the server shuts down.
+    void readSocket(const shared_ptr<Connection>& connection) {
+#ifndef _WIN32
+        string pending;
+        char buffer[1 << 16];
+        while (!stopping) {
+            ssize_t got = ::read(connection->fd, buffer, sizeof(buffer));
+            if (got <= 0) break;
+            pending.append(buffer, (size_t)got);
+            size_t begin = 0;
+            for (size_t end; (end = pending.find('\n', begin)) != string::npos; begin = end + 1) {
+                push(connection, pending.substr(begin, end - begin));
+            }
+            pending.erase(0, begin);
+        }
+        push(connection, pending); // A last request without a newline.
+#endif
+    }
+
+    // Stops accepting clients and stops every reader (called by a "shutdown" request).
+    void requestShutdown() {
+        stopping = true;
+#ifndef _WIN32
+        if (listenFd >= 0) ::shutdown(listenFd, SHUT_RDWR);
+        lock_guard<mutex> lock(clientMutex);
+        for (int fd : clientFds) ::shutdown(fd, SHUT_RD);
+#endif
+    }
+
+public:
+    // 'workers' threads answer requests (0 = all cores), at most 'capacity' requests wait at
+    // once and a worker takes up to 'batchSize' of them at a time.
+    QueryServer(RoutePlanner& routePlanner, int workers = 0, size_t queueCapacity = 4096, int batch = 64)
+        : planner(routePlanner) {
+        workerCount = resolveThreadCount(workers);
+        capacity = max((size_t)1, queueCapacity);
+        batchSize = max(1, batch);
+        draining = false;
+        for (auto& flag : prepared) flag = false;
+        latencyCount.assign(LATENCY_BUCKETS, 0);
+        served = 0;
+        slowestMicros = 0;
+        stopping = false;
+        listenFd = -1;
+    }
+
+    ~QueryServer() { stop(); }
+
+    // Turns a mode name into a SearchMode. (the last word of a request line).
+    // Returns false for an unknown name.
+    static bool parseMode(const string& name, SearchMode& mode) {
+        static const pair<const char*, SearchMode> names[] = {
+            {"dijkstra", DIJKSTRA}, {"bidir", BIDIRECTIONAL}, {"astar", ASTAR},
+            {"ch", CONTRACTION_HIERARCHY}, {"alt", LANDMARKS}, {"crp", PARTITION_OVERLAY}};
+        for (auto& entry : names) {
+            if (name == entry.first) { mode = entry.second; return true; }
+        }
+        return false;
+    }
+
+    // Builds the graph, prepares the search modes to serve and starts the workers. Modes are
+    // prepared here, before any worker runs, because prepareSearchMode needs the exclusive
+    // traffic lock and would otherwise hold up every worker while it builds. Requests in
+    // other modes are answered with an error.
+    void start(const vector<SearchMode>& modes = {DIJKSTRA, BIDIRECTIONAL, ASTAR, CONTRACTION_HIERARCHY,
+                                                  LANDMARKS, PARTITION_OVERLAY}) {
+        planner.getEdgeCount();   // Compresses the roads before any worker reads them.
+        for (SearchMode mode : modes) {
+            planner.prepareSearchMode(mode);
+            prepared[mode] = true;
+        }
+        draining = false;
+        for (int t = 0; t < workerCount; t++) workers.emplace_back(&QueryServer::work, this);
+    }
+
+    // Answers every queued request, then stops the workers.
+    void stop() {
+        {
+            lock_guard<mutex> lock(queueMutex);
+            draining = true;
+        }
+        notEmpty.notify_all();
+        for (auto& t : workers) t.join();
+        workers.clear();
+    }
+
+    // Returns the latency summary sent for a "stats" request.
+    string latencySummary() {
+        lock_guard<mutex> lock(latencyMutex);
+        auto percentile = [&](double fraction) {
+            long long rank = (long long)ceil(fraction * served), seen = 0;
+            for (int b = 0; b < LATENCY_BUCKETS; b++) {
+                seen += latencyCount[b];
+                if (seen >= rank && seen > 0) return min(bucketLimit(b), slowestMicros);
+            }
+            return 0.0;
+        };
+        char text[160];
+        snprintf(text, sizeof(text), "STATS served=%lld p50_us=%.1f p99_us=%.1f max_us=%.1f",
+                 served, percentile(0.5), percentile(0.99), slowestMicros);
+        return text;
+    }
+
+    // Serves one line-delimited client on streams (stdin/stdout) until its input ends.
+    // Call stop() afterwards to wait for the last answers.
+    void serveStream(istream& in, ostream& out) {
+        auto connection = make_shared<Connection>();
+        connection->stream = &out;
+        string line;
+        while (!stopping && getline(in, line)) push(connection, line);
+    }
+
+    // Serves one connected client socket until it closes; the socket is closed once its last
+    // answer has been sent.
+    void serveConnection(int fd) {
+        auto connection = make_shared<Connection>();
+        connection->fd = fd;
+        {
+            lock_guard<mutex> lock(clientMutex);
+            clientFds.push_back(fd);
+        }
+        readSocket(connection);
+        lock_guard<mutex> lock(clientMutex);
+        clientFds.erase(find(clientFds.begin(), clientFds.end(), fd));
+    }
+
+    // Listens on a Unix domain socket and serves every client on its own reader thread
+    // until a client sends "shutdown". Returns false if the socket can't be opened.
+    bool serveUnixSocket(const string& path) {
+#ifdef _WIN32
+        return false;
+#else
+        sockaddr_un address;
+        memset(&address, 0, sizeof(address));
+        address.sun_family = AF_UNIX;
+        if (path.size() >= sizeof(address.sun_path)) return false;
+        strcpy(address.sun_path, path.c_str());
+        int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd < 0) return false;
+        unlink(path.c_str());     // Removes a socket file left by an earlier run.
+        if (bind(fd, (sockaddr*)&address, sizeof(address)) != 0 || listen(fd, 128) != 0) {
+            ::close(fd);
+            return false;
+        }
+        listenFd = fd;
+        vector<thread> readers;
+        while (!stopping) {
+            int client = accept(fd, nullptr, nullptr);
+            if (client < 0) {
+                if (stopping) break;
+                continue;
+            }
+            readers.emplace_back(&QueryServer::serveConnection, this, client);
+        }
+        for (auto& t : readers) t.join();
+        listenFd = -1;
+        ::close(fd);
+        unlink(path.c_str());
+        return true;
+#endif
+    }
+};
+
+// ==========================================
+//              BENCHMARKS
+// ==========================================
+// Structure describing one two-way road of a synthetic benchmark map.
+struct SyntheticRoad {
+    int u, v;             // The two cities joined by the road.
+    double distanceKM;    // Length of the road.
+    TrafficLevel traffic; // Traffic condition on the road.
+    RoadType type;        // Road category.
+};
+
+// Structure holding a whole synthetic map: city locations plus roads.
+struct SyntheticMap {
+    int cityCount = 0;           // Cities are numbered 1..cityCount.
+    vector<double> lat, lon;     // Location of every city in degrees (index 0 unused).
+    vector<SyntheticRoad> roads; // Two-way roads between the cities.
+};
+
+// Builds a width x height grid of cities (about 5.5 km apart, starting near Gwadar) with
+// random road types and traffic. Each road is 5-60% longer than the straight line between
+// its cities, like a real winding road (the range can be widened for mountain terrain).
+// The same seed always produces the same map.
+SyntheticMap generateGridMap(int width, int height, unsigned seed, double minWinding = 1.05, double maxWinding = 1.6) {
+    mt19937 rng(seed);                                        // Reproducible random generator.
+    uniform_real_distribution<double> windingDist(minWinding, maxWinding); // Road length / straight-line length.
+    uniform_int_distribution<int> trafficDist(0, 3);          // Any of the four traffic levels.
+    uniform_int_distribution<int> typeDist(0, 2);             // Any of the three road types.
+    const double spacing = min(0.05, 60.0 / max(width, height)); // Grid spacing in degrees (huge grids are squeezed).
+
+    SyntheticMap map;
+    map.cityCount = width * height;
+    map.lat.assign(map.cityCount + 1, 0);
+    map.lon.assign(map.cityCount + 1, 0);
+    map.roads.reserve((size_t)width * height * 2);
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            int id = y * width + x + 1; // City IDs start at 1 like the built-in map.
+            map.lat[id] = 24.0 + y * spacing;
+            map.lon[id] = 61.0 + x * spacing;
+        }
+    }
+    auto addRoad = [&](int u, int v) {
+        double straight = greatCircleKM(map.lat[u], map.lon[u], map.lat[v], map.lon[v]);
+        map.roads.push_back({u, v, straight * windingDist(rng), (TrafficLevel)trafficDist(rng), (RoadType)typeDist(rng)});
+    };
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            int id = y * width + x + 1;
+            if (x + 1 < width)  addRoad(id, id + 1);
+            if (y + 1 < height) addRoad(id, id + width);
+        }
+    }
+    return map;
+}
+
+// Gives each of 'cityCount' cities a random point in a square near Gwadar, about one city
+// per 5.5 x 5.5 km (huge maps are squeezed into 60 x 60 degrees), and returns its side.
+void placeRandomCities(SyntheticMap& map, int cityCount, mt19937& rng, double& side) {
+    side = min(0.05 * sqrt((double)cityCount), 60.0);
+    uniform_real_distribution<double> offset(0, side);
+    map.cityCount = cityCount;
+    map.lat.assign(cityCount + 1, 0);
+    map.lon.assign(cityCount + 1, 0);
+    for (int id = 1; id <= cityCount; id++) {
+        map.lat[id] = 24.0 + offset(rng);
+        map.lon[id] = 61.0 + offset(rng);
+    }
+}
+
+// Builds a random geometric map: cities at random points, each joined to its 'neighbours'
+// nearest cities, like towns linked to the towns around them. Pieces left apart are then
+// joined to the nearest city outside them, so every city can reach every other. A bucket
+// grid (about two cities per cell) keeps the neighbour search near-linear up to 10^7 cities.
+SyntheticMap generateGeometricMap(int cityCount, unsigned seed, int neighbours = 4) {
+    mt19937 rng(seed);
+    uniform_real_distribution<double> windingDist(1.05, 1.6);
+    SyntheticMap map;
+    double side;
+    placeRandomCities(map, cityCount, rng, side);
+
+    int cells = max(1, (int)sqrt(cityCount / 2.0));          // Buckets per side.
+    double cellSize = side / cells;
+    auto cellOf = [&](int id, int& cx, int& cy) {
+        cx = min(cells - 1, (int)((map.lon[id] - 61.0) / cellSize));
+        cy = min(cells - 1, (int)((map.lat[id] - 24.0) / cellSize));
+    };
+    vector<int> cellStart((size_t)cells * cells + 1, 0), cellCities(cityCount);
+    for (int id = 1; id <= cityCount; id++) {
+        int cx, cy;
+        cellOf(id, cx, cy);
+        cellStart[(size_t)cy * cells + cx + 1]++;
+    }
+    for (size_t c = 1; c < cellStart.size(); c++) cellStart[c] += cellStart[c - 1];
+    vector<int> fill(cellStart.begin(), cellStart.end() - 1);
+    for (int id = 1; id <= cityCount; id++) {
+        int cx, cy;
+        cellOf(id, cx, cy);
+        cellCities[fill[(size_t)cy * cells + cx]++] = id;
+    }
+
+    // Visits the cities of the buckets in growing square rings around 'id' and offers each to
+    // 'offer' (squared distance, city) until 'done' holds for the distance already covered.
+    auto searchAround = [&](int id, auto offer, auto done) {
+        int cx, cy;
+        cellOf(id, cx, cy);
+        for (int ring = 0; ring <= cells; ring++) {
+            for (int y = max(0, cy - ring); y <= min(cells - 1, cy + ring); y++) {
+                bool edgeRow = y == cy - ring || y == cy + ring; // Inner rows only have the two end cells.
+                for (int x = max(0, cx - ring); x <= min(cells - 1, cx + ring); x++) {
+                    if (!edgeRow && x != cx - ring && x != cx + ring) continue;
+                    size_t c = (size_t)y * cells + x;
+                    for (int k = cellStart[c]; k < cellStart[c + 1]; k++) {
+                        int other = cellCities[k];
+                        if (other == id) continue;
+                        double dy = map.lat[other] - map.lat[id], dx = map.lon[other] - map.lon[id];
+                        offer(dx * dx + dy * dy, other);
+                    }
+                }
+            }
+            double covered = ring * cellSize; // Any city in a farther ring is at least this far.
+            if (done(covered * covered)) return;
+        }
+    };
+
+    vector<unsigned long long> links; // Both ends of a road packed as (smaller << 32 | larger).
+    links.reserve((size_t)cityCount * neighbours);
+    vector<pair<double, int>> nearest;
+    for (int id = 1; id <= cityCount; id++) {
+        nearest.clear();
+        searchAround(id, [&](double d2, int other) {
+            if ((int)nearest.size() == neighbours && d2 >= nearest.back().first) return;
+            if ((int)nearest.size() == neighbours) nearest.pop_back();
+            nearest.insert(upper_bound(nearest.begin(), nearest.end(), make_pair(d2, other)), {d2, other});
+        }, [&](double covered2) { return (int)nearest.size() == neighbours && nearest.back().first <= covered2; });
+        for (auto& n : nearest) {
+            links.push_back((unsigned long long)min(id, n.second) << 32 | (unsigned)max(id, n.second));
+        }
+    }
+    sort(links.begin(), links.end());
+    links.erase(unique(links.begin(), links.end()), links.end());
+
+    // Joins the pieces: each piece outside the largest one gets a road from one of its cities
+    // to the nearest city of another piece, until one piece is left.
+    vector<int> root(cityCount + 1);
+    for (int id = 0; id <= cityCount; id++) root[id] = id;
+    auto pieceOf = [&](int x) {
+        while (root[x] != x) x = root[x] = root[root[x]];
+        return x;
+    };
+    for (auto link : links) root[pieceOf((int)(link >> 32))] = pieceOf((int)(link & 0xffffffffu));
+    for (bool joined = true; joined;) {
+        joined = false;
+        vector<int> size(cityCount + 1, 0), first(cityCount + 1, 0);
+        for (int id = cityCount; id >= 1; id--) {
+            size[pieceOf(id)]++;
+            first[pieceOf(id)] = id;
+        }
+        int largest = pieceOf(1);
+        for (int id = 1; id <= cityCount; id++) if (size[id] > size[largest]) largest = id;
+        for (int piece = 1; piece <= cityCount; piece++) {
+            if (size[piece] == 0 || piece == largest || pieceOf(piece) != piece) continue;
+            int from = first[piece], best = 0;
+            double bestD2 = INF;
+            searchAround(from, [&](double d2, int other) {
+                if (d2 < bestD2 && pieceOf(other) != piece) { bestD2 = d2; best = other; }
+            }, [&](double covered2) { return best != 0 && bestD2 <= covered2; });
+            if (best == 0) continue;
+            links.push_back((unsigned long long)min(from, best) << 32 | (unsigned)max(from, best));
+            root[piece] = pieceOf(best);
+            joined = true;
+        }
+    }
+
+    map.roads.reserve(links.size());
+    for (auto link : links) {
+        int u = (int)(link >> 32), v = (int)(link & 0xffffffffu);
+        double straight = greatCircleKM(map.lat[u], map.lon[u], map.lat[v], map.lon[v]);
+        map.roads.push_back({u, v, max(0.1, straight * windingDist(rng)), LOW, LOCAL});
+    }
+    return map;
+}
+
+// Builds a scale-free map by preferential attachment (Barabasi-Albert): cities arrive one by
+// one and each links to 'links' earlier cities chosen with probability proportional to how
+// many roads they already have, so a few hubs gather most of the roads, like the cities of a
+// national highway network. City locations are random; every city can reach every other.
+SyntheticMap generateScaleFreeMap(int cityCount, unsigned seed, int links = 2) {
+    mt19937 rng(seed);
+    uniform_real_distribution<double> windingDist(1.05, 1.6);
+    SyntheticMap map;
+    double side;
+    placeRandomCities(map, cityCount, rng, side);
+
+    auto addRoad = [&](int u, int v) {
+        double straight = greatCircleKM(map.lat[u], map.lon[u], map.lat[v], map.lon[v]);
+        map.roads.push_back({u, v, max(0.1, straight * windingDist(rng)), LOW, LOCAL});
+    };
+    vector<int> roadEnds;     // Every city once per road it has: a uniform pick is preferential.
+    roadEnds.reserve((size_t)cityCount * links * 2);
+    map.roads.reserve((size_t)cityCount * links);
+    int seedCities = min(cityCount, links + 1);
+    for (int u = 1; u <= seedCities; u++) {
+        for (int v = u + 1; v <= seedCities; v++) {
+            addRoad(u, v);
+            roadEnds.push_back(u);
+            roadEnds.push_back(v);
+        }
+    }
+    vector<int> chosen;
+    for (int v = seedCities + 1; v <= cityCount; v++) {
+        chosen.clear();
+        uniform_int_distribution<size_t> pick(0, roadEnds.size() - 1);
+        while ((int)chosen.size() < links) {
+            int u = roadEnds[pick(rng)];
+            if (find(chosen.begin(), chosen.end(), u) == chosen.end()) chosen.push_back(u);
+        }
+        for (int u : chosen) {
+            addRoad(u, v);
+            roadEnds.push_back(u);
+            roadEnds.push_back(v);
+        }
+    }
+    return map;
+}
+
+// Gives the roads of a synthetic map the mix of a real network instead of a uniform one:
+// most roads are local, the longest ones are more often highways or motorways, and most
+// roads are clear (55% low, 25% moderate, 15% high, 5% jammed traffic).
+void applyRealisticRoadMix(SyntheticMap& map, unsigned seed) {
+    if (map.roads.empty()) return;
+    mt19937 rng(seed);
+    uniform_real_distribution<double> unit(0, 1);
+    discrete_distribution<int> trafficDist({55, 25, 15, 5});
+    vector<double> lengths;
+    for (auto& r : map.roads) lengths.push_back(r.distanceKM);
+    nth_element(lengths.begin(), lengths.begin() + lengths.size() / 2, lengths.end());
+    double median = lengths[lengths.size() / 2];
+    for (auto& r : map.roads) {
+        double longer = min(1.0, max(0.0, r.distanceKM / median - 1)); // 0 up to the median, 1 at twice it.
+        double draw = unit(rng);
+        r.type = draw < 0.03 + 0.12 * longer ? MOTORWAY : draw < 0.2 + 0.3 * longer ? HIGHWAY : LOCAL;
+        r.traffic = (TrafficLevel)trafficDist(rng);
+    }
+}
+
+// Loads a synthetic map into an empty planner.
+void loadSyntheticMap(RoutePlanner& planner, const SyntheticMap& map) {
+    for (int id = 1; id <= map.cityCount; id++) planner.addCity(id, "City " + to_string(id), map.lat[id], map.lon[id]);
+    for (auto& r : map.roads) planner.addRoad(r.u, r.v, r.distanceKM, r.traffic, r.type, "Synthetic Road");
+    planner.getEdgeCount(); // Forces the CSR build so it is not timed by the caller.
+}
+
+// The road record the CSR graph and the packed Edge replaced, kept for the CSR benchmark:
+// every road carried its own name string and was stored in a per-city vector.
+struct LegacyEdge {
+    int destination;
+    double distanceKM;
+    TrafficLevel traffic;
+    RoadType type;
+    string roadName;
+};
+
+// Reference Dijkstra on the old layout (one separately allocated vector of roads per city).
+void legacyShortestPaths(RoutePlanner& planner, const vector<vector<LegacyEdge>>& adj, int startNode, int speed,
+                         vector<double>& minTime, vector<int>& parent,
+                         vector<double>& fuelConsumed, vector<double>& pathDist) {
+    priority_queue<PqNode, vector<PqNode>, greater<PqNode>> pq;
+    minTime.assign(adj.size(), INF);
+    parent.assign(adj.size(), -1);
+    fuelConsumed.assign(adj.size(), 0.0);
+    pathDist.assign(adj.size(), 0.0);
+    minTime[startNode] = 0;
+    pq.push({startNode, 0});
+    while (!pq.empty()) {
+        int u = pq.top().id;
+        double currentTime = pq.top().timeCost;
+        pq.pop();
+        if (currentTime > minTime[u]) continue;
+        for (auto& edge : adj[u]) {
+            int v = edge.destination;
+            double realTime = (edge.distanceKM / speed) * 60.0 * planner.getTrafficMultiplier(edge.traffic);
+            if (minTime[u] + realTime < minTime[v]) {
+                minTime[v] = minTime[u] + realTime;
+                parent[v] = u;
+                pathDist[v] = pathDist[u] + edge.distanceKM;
+                fuelConsumed[v] = fuelConsumed[u] + (edge.distanceKM / planner.calculateFuelEfficiency(speed, edge.type));
+                pq.push({v, minTime[v]});
+            }
+        }
+    }
+}
+
+// Compares relaxation throughput and memory per road of the CSR graph with packed edges
+// against the old per-city vectors of LegacyEdge.
+void runCsrBenchmark(int side, int queries) {
+    SyntheticMap map = generateGridMap(side, side, 42); // Same map for both layouts.
+    const vector<SyntheticRoad>& roads = map.roads;
+    int n = map.cityCount;
+
+    RoutePlanner planner(false);                   // Empty planner for the synthetic map.
+    loadSyntheticMap(planner, map);
+    vector<vector<LegacyEdge>> adj(n + 1);         // The old layout, built from the same roads.
+    for (auto& r : roads) {
+        adj[r.u].push_back({r.v, r.distanceKM, r.traffic, r.type, "Synthetic Road"});
+        adj[r.v].push_back({r.u, r.distanceKM, r.traffic, r.type, "Synthetic Road"});
+    }
+
+    // Memory of each layout: records, per-city vectors or offsets, and heap-allocated names
+    // (the CSR graph's few distinct names are stored once and left out).
+    double directed = (double)roads.size() * 2;
+    size_t legacyBytes = adj.size() * sizeof(vector<LegacyEdge>);
+    for (auto& list : adj) {
+        legacyBytes += list.capacity() * sizeof(LegacyEdge);
+        for (auto& edge : list) { // Names longer than the short-string buffer live on the heap.
+            if (edge.roadName.capacity() > string().capacity()) legacyBytes += edge.roadName.capacity() + 1;
+        }
+    }
+    size_t csrBytes = (size_t)directed * (sizeof(Edge) + sizeof(int)) + (n + 2) * sizeof(int);
+
+    mt19937 rng(7);
+    uniform_int_distribution<int> nodeDist(1, n);
+    vector<int> sources(queries);
+    for (auto& s : sources) s = nodeDist(rng); // Same sources for both layouts.
+
+    vector<double> minTime, fuelConsumed, pathDist;
+    vector<int> parent;
+    double checksumCsr = 0, checksumLegacy = 0; // Used to confirm both layouts agree.
+
+    auto t0 = chrono::steady_clock::now();
+    for (int s : sources) {
+        legacyShortestPaths(planner, adj, s, 100, minTime, parent, fuelConsumed, pathDist);
+        checksumLegacy += minTime[n] + fuelConsumed[n];
+    }
+    auto t1 = chrono::steady_clock::now();
+    for (int s : sources) {
+        planner.computeShortestPaths(s, 100, minTime, parent, fuelConsumed, pathDist);
+        checksumCsr += minTime[n] + fuelConsumed[n];
+    }
+    auto t2 = chrono::steady_clock::now();
+
+    double legacySec = chrono::duration<double>(t1 - t0).count();
+    double csrSec = chrono::duration<double>(t2 - t1).count();
+    double relaxations = (double)roads.size() * 2 * queries; // Every road is scanned once per full search.
+
+    cout << "Grid " << side << "x" << side << " (" << n << " cities, " << roads.size() * 2 << " directed roads), "
+         << queries << " full searches" << endl;
+    cout << fixed << setprecision(2);
+    cout << "  vector-per-city : " << setw(8) << legacySec * 1000 << " ms  "
+         << setw(8) << relaxations / legacySec / 1e6 << " M relax/s  "
+         << setw(6) << legacyBytes / directed << " bytes/road (" << sizeof(LegacyEdge) << "-byte record with its name)" << endl;
+    cout << "  CSR             : " << setw(8) << csrSec * 1000 << " ms  "
+         << setw(8) << relaxations / csrSec / 1e6 << " M relax/s  "
+         << setw(6) << csrBytes / directed << " bytes/road (" << sizeof(Edge) << "-byte record + " << sizeof(int)
+         << "-byte name id, " << planner.getRoadNameCount() << " distinct names stored once)" << endl;
+    cout << "  results match   : " << (fabs(checksumCsr - checksumLegacy) < 1e-6 ? "yes" : "NO") << endl;
+}
+
+// Compares settled cities and query time of plain vs bidirectional Dijkstra on random pairs.
+void runBidirectionalBenchmark(int side, int queries) {
+    int n = side * side;
+    RoutePlanner planner(false);
+    loadSyntheticMap(planner, generateGridMap(side, side, 42));
+
+    mt19937 rng(11);
+    uniform_int_distribution<int> nodeDist(1, n);
+    vector<double> minTime, fuelConsumed, pathDist;
+    vector<int> parent;
+    long long settledPlain = 0, settledBidir = 0; // Total settled cities of each mode.
+    double secPlain = 0, secBidir = 0;            // Total query time of each mode.
+    int mismatches = 0;                           // Queries where the totals differ.
+
+    for (int q = 0; q < queries; q++) {
+        int s = nodeDist(rng), t = nodeDist(rng);
+
+        auto t0 = chrono::steady_clock::now();
+        planner.computeShortestPaths(s, 100, minTime, parent, fuelConsumed, pathDist);
+        auto t1 = chrono::steady_clock::now();
+        settledPlain += planner.getLastSearchStats().settledNodes;
+
+        double time, dist, fuel;
+        vector<int> route;
+        planner.computeBidirectionalRoute(s, t, 100, route, time, dist, fuel);
+        auto t2 = chrono::steady_clock::now();
+        settledBidir += planner.getLastSearchStats().settledNodes;
+
+        secPlain += chrono::duration<double>(t1 - t0).count();
+        secBidir += chrono::duration<double>(t2 - t1).count();
+        if (fabs(time - minTime[t]) > 1e-6 || fabs(dist - pathDist[t]) > 1e-6 || fabs(fuel - fuelConsumed[t]) > 1e-6) mismatches++;
+    }
+
+    cout << "Grid " << side << "x" << side << " (" << n << " cities), " << queries << " random queries" << endl;
+    cout << fixed << setprecision(2);
+    cout << "  Dijkstra      : " << setw(10) << (double)settledPlain / queries << " settled/query  "
+         << setw(8) << secPlain * 1000 / queries << " ms/query" << endl;
+    cout << "  Bidirectional : " << setw(10) << (double)settledBidir / queries << " settled/query  "
+         << setw(8) << secBidir * 1000 / queries << " ms/query" << endl;
+    cout << "  mismatching totals : " << mismatches << endl;
+}
+
+// Returns a short printable name for a search mode.
+string getModeName(SearchMode mode) {
+    switch (mode) {
+        case DIJKSTRA: return "Dijkstra";
+        case BIDIRECTIONAL: return "Bidirectional";
+        case ASTAR: return "A*";
+        case CONTRACTION_HIERARCHY: return "CH";
+        case LANDMARKS: return "ALT";
+        case PARTITION_OVERLAY: return "CRP";
+        default: return "Unknown";
+    }
+}
+
+// Runs the same queries with every listed mode and prints settled cities and time per query.
+// Totals are checked against plain Dijkstra; any difference is reported as a mismatch.
+void compareModes(RoutePlanner& planner, const vector<pair<int, int>>& queries, int speed,
+                  const string& label, const vector<SearchMode>& modes) {
+    int count = (int)queries.size();
+    vector<double> refTime(count), refDist(count), refFuel(count); // Dijkstra answers.
+    vector<int> route;
+    for (int q = 0; q < count; q++) {
+        planner.computeRoute(queries[q].first, queries[q].second, speed, DIJKSTRA, route, refTime[q], refDist[q], refFuel[q]);
+    }
+
+    cout << label << ", " << count << " queries at " << speed << " km/h" << endl;
+    cout << fixed << setprecision(3);
+    for (SearchMode mode : modes) {
+        long long settled = 0;
+        double seconds = 0;
+        int mismatches = 0;
+        for (int q = 0; q < count; q++) {
+            double time, dist, fuel;
+            auto t0 = chrono::steady_clock::now();
+            planner.computeRoute(queries[q].first, queries[q].second, speed, mode, route, time, dist, fuel);
+            seconds += chrono::duration<double>(chrono::steady_clock::now() - t0).count();
+            settled += planner.getLastSearchStats().settledNodes;
+            if (fabs(time - refTime[q]) > 1e-6 || fabs(dist - refDist[q]) > 1e-6 || fabs(fuel - refFuel[q]) > 1e-6) mismatches++;
+        }
+        cout << "  " << left << setw(14) << getModeName(mode) << right << ": "
+             << setw(12) << (double)settled / count << " settled/query  "
+             << setw(10) << seconds * 1000 / count << " ms/query  "
+             << mismatches << " mismatches" << endl;
+    }
+}
+
+// Returns every ordered pair of cities of a small map.
+vector<pair<int, int>> allPairs(int cityCount) {
+    vector<pair<int, int>> pairs;
+    for (int s = 1; s <= cityCount; s++) {
+        for (int t = 1; t <= cityCount; t++) pairs.push_back({s, t});
+    }
+    return pairs;
+}
+
+// Returns 'count' random (start, destination) pairs with a fixed seed.
+vector<pair<int, int>> randomPairs(int cityCount, int count, unsigned seed) {
+    mt19937 rng(seed);
+    uniform_int_distribution<int> nodeDist(1, cityCount);
+    vector<pair<int, int>> pairs;
+    for (int q = 0; q < count; q++) pairs.push_back({nodeDist(rng), nodeDist(rng)});
+    return pairs;
+}
+
+// Compares A* against Dijkstra on every pair of the built-in map and on a large synthetic grid.
+void runAStarBenchmark(int side, int queries) {
+    RoutePlanner builtIn;
+    compareModes(builtIn, allPairs(builtIn.getCityCount()), 100, "Built-in map (all pairs)", {DIJKSTRA, ASTAR});
+
+    RoutePlanner synthetic(false);
+    loadSyntheticMap(synthetic, generateGridMap(side, side, 42));
+    compareModes(synthetic, randomPairs(side * side, queries, 13), 100,
+                 "Grid " + to_string(side) + "x" + to_string(side), {DIJKSTRA, ASTAR});
+}
+
+// Compares ALT against Dijkstra and A* on the built-in map and on a "mountain" grid whose
+// roads wind 1.5-4x the straight-line distance, where coordinates say little about travel time.
+// Also checks that saved landmark tables load back unchanged, and are refused once a road's
+// traffic has changed.
+void runLandmarkBenchmark(int side, int queries, int k) {
+    RoutePlanner builtIn;
+    compareModes(builtIn, allPairs(builtIn.getCityCount()), 100, "Built-in map (all pairs)", {DIJKSTRA, ASTAR, LANDMARKS});
+
+    RoutePlanner mountain(false);
+    loadSyntheticMap(mountain, generateGridMap(side, side, 42, 1.5, 4.0));
+    for (LandmarkStrategy strategy : {FARTHEST, AVOID}) {
+        auto t0 = chrono::steady_clock::now();
+        mountain.buildLandmarks(k, strategy);
+        double buildSec = chrono::duration<double>(chrono::steady_clock::now() - t0).count();
+        string name = strategy == FARTHEST ? "farthest" : "avoid";
+        cout << fixed << setprecision(3) << k << " landmarks (" << name << ") built in " << buildSec << " s" << endl;
+        compareModes(mountain, randomPairs(side * side, queries, 19), 100,
+                     "Mountain grid " + to_string(side) + "x" + to_string(side), {DIJKSTRA, ASTAR, LANDMARKS});
+    }
+
+    string path = "landmarks_benchmark.bin";
+    vector<int> before = mountain.getLandmarks();
+    bool saved = mountain.saveLandmarks(path);
+    bool loaded = saved && mountain.loadLandmarks(path);
+    cout << "Persisted tables: " << (loaded && before == mountain.getLandmarks() ? "saved and reloaded" : "FAILED") << endl;
+    mountain.updateTraffic(0, mountain.getRoad(0).traffic == JAMMED ? LOW : JAMMED);
+    bool stale = mountain.loadLandmarks(path);
+    cout << "Tables after a traffic change: " << (stale ? "LOADED (stale)" : "rejected") << endl;
+    remove(path.c_str());
+}
+
+// Measures hierarchy preprocessing and query time and checks every query against Dijkstra.
+void runHierarchyBenchmark(int side, int queries) {
+    RoutePlanner planner(false);
+    loadSyntheticMap(planner, generateGridMap(side, side, 42));
+    int n = planner.getCityCount();
+
+    auto t0 = chrono::steady_clock::now();
+    planner.buildContractionHierarchy();
+    double buildSec = chrono::duration<double>(chrono::steady_clock::now() - t0).count();
+
+    mt19937 rng(17);
+    uniform_int_distribution<int> nodeDist(1, n);
+    vector<double> minTime, fuelConsumed, pathDist;
+    vector<int> parent;
+    long long settled = 0;
+    double querySec = 0;
+    int mismatches = 0;
+    for (int q = 0; q < queries; q++) {
+        int s = nodeDist(rng), t = nodeDist(rng);
+        double time = INF, dist = INF, fuel = INF;
+        auto q0 = chrono::steady_clock::now();
+        vector<int> route;
+        bool found = planner.computeHierarchyRoute(s, t, 100, route, time, dist, fuel);
+        querySec += chrono::duration<double>(chrono::steady_clock::now() - q0).count();
+        settled += planner.getLastSearchStats().settledNodes;
+
+        planner.computeShortestPaths(s, 100, minTime, parent, fuelConsumed, pathDist);
+        if (!found) {
+            if (minTime[t] < INF) mismatches++; // Dijkstra reached a city the hierarchy missed.
+        } else if (time != minTime[t] || dist != pathDist[t] || fuel != fuelConsumed[t]) {
+            mismatches++;
+        }
+    }
+
+    cout << "Grid " << side << "x" << side << " (" << n << " cities, " << planner.getEdgeCount() << " directed roads)" << endl;
+    cout << fixed << setprecision(3);
+    cout << "  preprocessing : " << buildSec << " s, " << planner.getShortcutCount() << " shortcuts" << endl;
+    cout << "  query         : " << querySec * 1000 / queries << " ms/query, "
+         << (double)settled / queries << " settled/query" << endl;
+    cout << "  totals differing from Dijkstra : " << mismatches << " of " << queries << endl;
+}
+
+// Builds a sources x targets matrix on a synthetic grid, reports cells per second and
+// checks a sample of rows against one-to-all Dijkstra.
+void runMatrixBenchmark(int side, int sourceCount, int targetCount) {
+    RoutePlanner planner(false);
+    loadSyntheticMap(planner, generateGridMap(side, side, 42));
+    int n = planner.getCityCount();
+    mt19937 rng(23);
+    uniform_int_distribution<int> nodeDist(1, n);
+    vector<int> sources(sourceCount), targets(targetCount);
+    for (auto& s : sources) s = nodeDist(rng);
+    for (auto& t : targets) t = nodeDist(rng);
+
+    auto t0 = chrono::steady_clock::now();
+    planner.buildContractionHierarchy();
+    auto t1 = chrono::steady_clock::now();
+    TravelMatrix matrix = planner.computeTravelMatrix(sources, targets, 100);
+    auto t2 = chrono::steady_clock::now();
+
+    // Checks a few rows against plain Dijkstra (relative tolerance for rounding).
+    vector<double> minTime, fuelConsumed, pathDist;
+    vector<int> parent;
+    int checkedRows = min(sourceCount, 5), mismatches = 0;
+    auto t3 = chrono::steady_clock::now();
+    for (int r = 0; r < checkedRows; r++) {
+        planner.computeShortestPaths(sources[r], 100, minTime, parent, fuelConsumed, pathDist);
+        for (int c = 0; c < targetCount; c++) {
+            size_t cell = (size_t)r * targetCount + c;
+            auto close = [](double a, double b) { return fabs(a - b) <= 1e-9 * max(1.0, fabs(b)); };
+            if (!close(matrix.minTime[cell], minTime[targets[c]]) || !close(matrix.pathDist[cell], pathDist[targets[c]]) ||
+                !close(matrix.fuelConsumed[cell], fuelConsumed[targets[c]])) mismatches++;
+        }
+    }
+    double dijkstraPerRow = chrono::duration<double>(chrono::steady_clock::now() - t3).count() / checkedRows;
+
+    double matrixSec = chrono::duration<double>(t2 - t1).count();
+    cout << "Grid " << side << "x" << side << " (" << n << " cities), " << sourceCount << " x " << targetCount
+         << " matrix on " << resolveThreadCount(0) << " threads" << endl;
+    cout << fixed << setprecision(3);
+    cout << "  hierarchy build   : " << chrono::duration<double>(t1 - t0).count() << " s" << endl;
+    cout << "  matrix            : " << matrixSec << " s (" << (double)sourceCount * targetCount / matrixSec / 1e6 << " M cells/s)" << endl;
+    cout << "  one-to-all rows   : " << dijkstraPerRow * sourceCount << " s estimated for all rows on one core" << endl;
+    cout << "  mismatching cells : " << mismatches << " of " << (long long)checkedRows * targetCount << " checked" << endl;
+}
+
+// Times one queue backend on point-to-point and one-to-all searches. Returns the total
+// seconds and prints one line; times are checked against the binary-heap answers.
+template <typename Queue>
+double timeQueue(RoutePlanner& planner, const string& name, const vector<pair<int, int>>& pairs,
+                 const vector<double>& refTime, const vector<int>& sources, double refChecksum) {
+    long long settled = 0;
+    int mismatches = 0;
+    vector<int> route;
+    auto t0 = chrono::steady_clock::now();
+    for (size_t q = 0; q < pairs.size(); q++) {
+        double time = INF, dist, fuel;
+        planner.computeDijkstraRoute<Queue>(pairs[q].first, pairs[q].second, 100, route, time, dist, fuel);
+        settled += planner.getLastSearchStats().settledNodes;
+        if (fabs(time - refTime[q]) > 1e-9 * max(1.0, refTime[q])) mismatches++;
+    }
+    auto t1 = chrono::steady_clock::now();
+    vector<double> minTime, fuelConsumed, pathDist;
+    vector<int> parent;
+    double checksum = 0;
+    for (int s : sources) {
+        planner.computeShortestPaths<Queue>(s, 100, minTime, parent, fuelConsumed, pathDist);
+        for (double t : minTime) if (t != INF) checksum += t;
+    }
+    auto t2 = chrono::steady_clock::now();
+    if (fabs(checksum - refChecksum) > 1e-6 * max(1.0, refChecksum)) mismatches++;
+
+    double p2pSec = chrono::duration<double>(t1 - t0).count();
+    double fullSec = chrono::duration<double>(t2 - t1).count();
+    cout << "  " << left << setw(14) << name << right << ": "
+         << setw(9) << p2pSec * 1000 / pairs.size() << " ms/query  "
+         << setw(10) << (double)settled / pairs.size() << " expanded/query  "
+         << setw(9) << fullSec * 1000 / sources.size() << " ms/one-to-all  "
+         << mismatches << " mismatches" << endl;
+    return p2pSec + fullSec;
+}
+
+// Compares the priority queue backends of Dijkstra on grids of growing size and names the
+// fastest one for each size.
+void runQueueBenchmark(int maxSide, int queries) {
+    for (int side : {30, 100, 300, 1000}) {
+        if (side > maxSide) break;
+        RoutePlanner planner(false);
+        loadSyntheticMap(planner, generateGridMap(side, side, 42));
+        int n = planner.getCityCount();
+        vector<pair<int, int>> pairs = randomPairs(n, queries, 29);
+        vector<int> sources;
+        for (int q = 0; q < max(1, queries / 10); q++) sources.push_back(pairs[q].first);
+
+        // Reference answers from the binary heap.
+        vector<double> refTime(pairs.size(), INF), minTime, fuelConsumed, pathDist;
+        vector<int> route, parent;
+        for (size_t q = 0; q < pairs.size(); q++) {
+            double dist, fuel;
+            planner.computeDijkstraRoute(pairs[q].first, pairs[q].second, 100, route, refTime[q], dist, fuel);
+        }
+        double refChecksum = 0;
+        for (int s : sources) {
+            planner.computeShortestPaths(s, 100, minTime, parent, fuelConsumed, pathDist);
+            for (double t : minTime) if (t != INF) refChecksum += t;
+        }
+
+        cout << "Grid " << side << "x" << side << " (" << n << " cities), " << pairs.size()
+             << " point-to-point + " << sources.size() << " one-to-all searches" << endl;
+        cout << fixed << setprecision(3);
+        vector<pair<double, string>> results;
+        results.push_back({timeQueue<BinaryHeapQueue>(planner, "binary heap", pairs, refTime, sources, refChecksum), "binary heap"});
+        results.push_back({timeQueue<QuaternaryHeapQueue>(planner, "4-ary heap", pairs, refTime, sources, refChecksum), "4-ary heap"});
+        results.push_back({timeQueue<RadixHeapQueue>(planner, "radix heap", pairs, refTime, sources, refChecksum), "radix heap"});
+        results.push_back({timeQueue<DialBucketQueue>(planner, "Dial buckets", pairs, refTime, sources, refChecksum), "Dial buckets"});
+        cout << "  fastest       : " << min_element(results.begin(), results.end())->second << endl;
+    }
+}
+
+// Asks every query at all speeds from 40 to 160 km/h, once with a fresh Dijkstra search each
+// time and once through the speed-invariant tree cache, and compares time and totals.
+void runTreeCacheBenchmark(int side, int queries) {
+    RoutePlanner planner(false);
+    loadSyntheticMap(planner, generateGridMap(side, side, 42));
+    vector<pair<int, int>> pairs = randomPairs(planner.getCityCount(), queries, 31);
+    vector<int> route;
+    double secSearch = 0, secCached = 0;
+    int lookups = 0, searches = 0, mismatches = 0;
+
+    for (auto& q : pairs) {
+        for (int speed = 40; speed <= 160; speed += 10) {
+            double time = INF, dist = 0, fuel = 0, cTime = INF, cDist = 0, cFuel = 0;
+            auto t0 = chrono::steady_clock::now();
+            planner.computeDijkstraRoute(q.first, q.second, speed, route, time, dist, fuel);
+            auto t1 = chrono::steady_clock::now();
+            planner.computeCachedRoute(q.first, q.second, speed, route, cTime, cDist, cFuel);
+            auto t2 = chrono::steady_clock::now();
+            secSearch += chrono::duration<double>(t1 - t0).count();
+            secCached += chrono::duration<double>(t2 - t1).count();
+            if (planner.getLastSearchStats().settledNodes > 0) searches++;
+            lookups++;
+            auto close = [](double a, double b) { return fabs(a - b) <= 1e-9 * max(1.0, fabs(b)); };
+            if (!close(cTime, time) || !close(cDist, dist) || !close(cFuel, fuel)) mismatches++;
+        }
+    }
+
+    cout << "Grid " << side << "x" << side << " (" << planner.getCityCount() << " cities), " << queries
+         << " queries x 13 speeds" << endl;
+    cout << fixed << setprecision(3);
+    cout << "  search every time : " << secSearch * 1000 / lookups << " ms/query" << endl;
+    cout << "  tree cache        : " << secCached * 1000 / lookups << " ms/query (" << searches
+         << " trees built for " << lookups << " queries)" << endl;
+    cout << "  mismatching totals : " << mismatches << endl;
+}
+
+// Computes Pareto frontiers on random pairs and reports frontier size, query time and
+// whether the fastest option matches Dijkstra's time.
+void runParetoBenchmark(int side, int queries, int maxLabels) {
+    RoutePlanner planner(false);
+    loadSyntheticMap(planner, generateGridMap(side, side, 42));
+    vector<pair<int, int>> pairs = randomPairs(planner.getCityCount(), queries, 37);
+    vector<int> route;
+    double seconds = 0;
+    long long options = 0, settled = 0;
+    size_t largest = 0;
+    int mismatches = 0;
+    for (auto& q : pairs) {
+        auto t0 = chrono::steady_clock::now();
+        vector<ParetoRoute> frontier = planner.computeParetoRoutes(q.first, q.second, 100, maxLabels);
+        seconds += chrono::duration<double>(chrono::steady_clock::now() - t0).count();
+        settled += planner.getLastSearchStats().settledNodes;
+        options += frontier.size();
+        largest = max(largest, frontier.size());
+
+        double time = INF, dist, fuel;
+        planner.computeDijkstraRoute(q.first, q.second, 100, route, time, dist, fuel);
+        if (frontier.empty() || fabs(frontier[0].totalTime - time) > 1e-9 * max(1.0, time)) mismatches++;
+    }
+
+    cout << "Grid " << side << "x" << side << " (" << planner.getCityCount() << " cities), " << queries
+         << " random queries, at most " << maxLabels << " labels per city" << endl;
+    cout << fixed << setprecision(3);
+    cout << "  query time       : " << seconds * 1000 / queries << " ms/query" << endl;
+    cout << "  labels settled   : " << (double)settled / queries << " per query" << endl;
+    cout << "  frontier size    : " << (double)options / queries << " on average, " << largest << " at most" << endl;
+    cout << "  fastest option differs from Dijkstra : " << mismatches << endl;
+}
+
+// Replays random traffic changes on one thread while three others keep answering
+// cached-tree and ALT queries (and receipts, whose legs must add up to their totals and
+// take the time their shown traffic gives), then
+// checks the repaired state against fresh Dijkstra searches. A second, smaller run does the
+// same with two threads of hierarchy queries: every change drops the hierarchy, so both
+// readers find it missing and must not build it at the same time.
+void runTrafficBenchmark(int side, int updates) {
+    RoutePlanner planner(false);
+    loadSyntheticMap(planner, generateGridMap(side, side, 42));
+    int n = planner.getCityCount();
+    planner.buildLandmarks(8, AVOID);
+    vector<pair<int, int>> pairs = randomPairs(n, 200, 41);
+    vector<int> sources;
+    for (int q = 0; q < 16; q++) sources.push_back(pairs[q].first);
+
+    vector<int> route;
+    double time, dist, fuel;
+    auto t0 = chrono::steady_clock::now();
+    for (int s : sources) {
+        planner.setTreeCacheCapacity(0);  // Forces a fresh tree to time a full rebuild.
+        planner.setTreeCacheCapacity(64);
+        planner.computeCachedRoute(s, pairs[0].second, 100, route, time, dist, fuel);
+    }
+    double rebuildSec = chrono::duration<double>(chrono::steady_clock::now() - t0).count();
+    for (int s : sources) planner.computeCachedRoute(s, pairs[0].second, 100, route, time, dist, fuel);
+
+    mt19937 rng(43);
+    uniform_int_distribution<int> roadDist(0, planner.getEdgeCount() - 1), levelDist(0, 3);
+    vector<pair<int, TrafficLevel>> changes(updates);
+    for (auto& c : changes) c = {roadDist(rng), (TrafficLevel)levelDist(rng)};
+
+    const int READERS = 3;
+    atomic<bool> done(false), started(false);
+    atomic<long long> queries(0);
+    atomic<int> receiptMismatches(0); // Receipts whose legs disagree with their totals or conditions.
+    vector<thread> queryThreads;
+    for (int r = 0; r < READERS; r++) {
+        queryThreads.emplace_back([&, r]() {
+            uniform_int_distribution<int> pick(0, (int)sources.size() - 1), cityDist(1, n), speedDist(40, 160);
+            mt19937 queryRng(47 + r);
+            vector<int> readerRoute;
+            double t0, d0, f0;
+            while (!done) {
+                int s = sources[pick(queryRng)], t = cityDist(queryRng);
+                planner.computeCachedRoute(s, t, speedDist(queryRng), readerRoute, t0, d0, f0);
+                planner.computeRoute(cityDist(queryRng), t, 100, LANDMARKS, readerRoute, t0, d0, f0);
+                RouteResult receipt = planner.planRoute(sources[pick(queryRng)], t, 100);
+                double legMinutes = 0;
+                bool conditionsAgree = true; // Every leg's time matches the traffic it shows.
+                for (const RouteLeg& leg : receipt.legs) {
+                    legMinutes += leg.minutes;
+                    double shown = leg.distanceKM / 100 * 60 * planner.getTrafficMultiplier(leg.traffic);
+                    if (fabs(shown - leg.minutes) > 1e-9 * max(1.0, leg.minutes)) conditionsAgree = false;
+                }
+                if (receipt.found && (!conditionsAgree || fabs(legMinutes - receipt.totalTime) > 1e-6 * max(1.0, receipt.totalTime))) {
+                    receiptMismatches++;
+                }
+                queries += 3;
+                started = true;
+            }
+        });
+    }
+    while (!started) this_thread::yield(); // The changes start once the readers are busy.
+    double updateSec = 0, slowestMs = 0;
+    auto w0 = chrono::steady_clock::now();
+    for (auto& c : changes) {
+        auto u0 = chrono::steady_clock::now();
+        planner.updateTraffic(c.first, c.second);
+        slowestMs = max(slowestMs, chrono::duration<double, milli>(chrono::steady_clock::now() - u0).count());
+    }
+    updateSec = chrono::duration<double>(chrono::steady_clock::now() - w0).count();
+    done = true;
+    for (auto& t : queryThreads) t.join();
+
+    int mismatches = 0, checked = 0;
+    auto close = [](double a, double b) { return fabs(a - b) <= 1e-9 * max(1.0, fabs(b)); };
+    for (size_t q = 0; q < pairs.size(); q++) {
+        int s = q < 100 ? sources[q % sources.size()] : pairs[q].first, t = pairs[q].second;
+        double refTime = INF, cTime = INF;
+        planner.computeDijkstraRoute(s, t, 100, route, refTime, dist, fuel);
+        if (q < 100) planner.computeCachedRoute(s, t, 100, route, cTime, dist, fuel);
+        else planner.computeRoute(s, t, 100, LANDMARKS, route, cTime, dist, fuel);
+        checked++;
+        if (!close(cTime, refTime)) mismatches++;
+    }
 
-// Enum to define different types of roads.
-enum RoadType {
-    MOTORWAY,   // Represents high-speed motorways.
-    HIGHWAY,    // Represents standard highways.
-    LOCAL       // Represents slower local roads.
-};
+    cout << "Grid " << side << "x" << side << " (" << n << " cities), " << sources.size()
+         << " cached trees, 8 landmarks, " << updates << " traffic changes" << endl;
+    cout << fixed << setprecision(3);
+    cout << "  traffic changes : " << updates / updateSec << " per second ("
+         << updateSec * 1000 / updates << " ms each, repairing every cached tree; slowest "
+         << slowestMs << " ms)" << endl;
+    cout << "  full rebuild    : " << rebuildSec * 1000 << " ms to recompute the " << sources.size() << " trees" << endl;
+    cout << "  queries served  : " << queries << " on " << READERS << " threads while the changes were applied" << endl;
+    cout << "  receipts whose legs disagree with their totals or conditions : " << receiptMismatches << endl;
+    cout << "  answers differing from fresh Dijkstra afterwards : " << mismatches << " of " << checked << endl;
 
-// Structure representing a single connection (road) between cities.
-struct Edge {
-    int destination;      // Stores the ID of the city this road leads to.
-    double distanceKM;    // Stores the length of the road in kilometers.
-    TrafficLevel traffic; // Stores the traffic condition on this road.
-    RoadType type;        // Stores the type of road (Motorway, Highway, etc.).
-    string roadName;      // Stores the name of the road (e.g., "M-2 Motorway").
-};
+    // Hierarchy readers on a small grid (the hierarchy is rebuilt after every change).
+    const int CH_SIDE = 30, CH_UPDATES = 20, CH_READERS = 2;
+    RoutePlanner small(false);
+    loadSyntheticMap(small, generateGridMap(CH_SIDE, CH_SIDE, 42));
+    int smallCities = small.getCityCount();
+    uniform_int_distribution<int> smallRoad(0, small.getEdgeCount() - 1), smallCity(1, smallCities);
+    vector<pair<int, TrafficLevel>> smallChanges(CH_UPDATES);
+    for (auto& c : smallChanges) c = {smallRoad(rng), (TrafficLevel)levelDist(rng)};
+    atomic<bool> smallDone(false);
+    atomic<long long> chQueries(0);
+    vector<thread> readers;
+    for (int r = 0; r < CH_READERS; r++) {
+        readers.emplace_back([&, r]() {
+            mt19937 readerRng(60 + r);
+            vector<int> readerRoute;
+            double t, d, f;
+            while (!smallDone) {
+                small.computeRoute(smallCity(readerRng), smallCity(readerRng), 100, CONTRACTION_HIERARCHY, readerRoute, t, d, f);
+                chQueries++;
+            }
+        });
+    }
+    for (auto& c : smallChanges) {
+        // Let the readers run into the dropped hierarchy before changing it again.
+        long long seen = chQueries;
+        while (chQueries < seen + CH_READERS) this_thread::yield();
+        small.updateTraffic(c.first, c.second);
+    }
+    smallDone = true;
+    for (auto& t : readers) t.join();
+    int chMismatches = 0;
+    for (auto& q : randomPairs(smallCities, 200, 61)) {
+        double refTime = INF, chTime = INF;
+        small.computeDijkstraRoute(q.first, q.second, 100, route, refTime, dist, fuel);
+        small.computeRoute(q.first, q.second, 100, CONTRACTION_HIERARCHY, route, chTime, dist, fuel);
+        if (!close(chTime, refTime)) chMismatches++;
+    }
+    cout << "  hierarchy readers (" << CH_SIDE << "x" << CH_SIDE << " grid, " << CH_READERS << " threads, "
+         << CH_UPDATES << " changes) : " << chQueries << " queries, " << chMismatches
+         << " of 200 differing from Dijkstra afterwards" << endl;
+}
 
-// Structure used in the Priority Queue to order cities by travel time.
-struct PqNode {
-    int id;           // Stores the city ID.
-    double timeCost;  // Stores the total time taken to reach this city.
+// Gives most roads of a grid one of a few shared rush-hour profiles, checks the FIFO
+// property and the no-profile case, and compares query times at night and at rush hour.
+void runTimeDependentBenchmark(int side, int queries) {
+    RoutePlanner planner(false);
+    loadSyntheticMap(planner, generateGridMap(side, side, 42));
+    int n = planner.getCityCount(), roads = planner.getEdgeCount();
+    vector<pair<int, int>> pairs = randomPairs(n, queries, 53);
+    vector<int> route;
 
-    // Overloads the > operator so the Priority Queue works as a Min-Heap (smallest time on top).
-    bool operator>(const PqNode& other) const {
-        return timeCost > other.timeCost; // Returns true if current time is greater than the other.
+    // Without profiles the time-dependent search must match plain Dijkstra exactly.
+    int staticMismatches = 0;
+    for (auto& q : pairs) {
+        double time = INF, dist = 0, fuel = 0, tdTime = INF, tdDist = 0, tdFuel = 0;
+        planner.computeDijkstraRoute(q.first, q.second, 100, route, time, dist, fuel);
+        planner.computeTimeDependentRoute(q.first, q.second, 100, 8 * 60, route, tdTime, tdDist, tdFuel);
+        if (time != tdTime || dist != tdDist || fuel != tdFuel) staticMismatches++;
     }
-};
 
-// ==========================================
-//        CORE ROUTING CLASS
-// ==========================================
-class RoutePlanner {
-private:
-    // Adjacency List: An array of vectors where each index holds a list of roads from that city.
-    vector<Edge> adj[MAX_CITIES];
-    string cityNames[MAX_CITIES]; // Array to store the names of the cities based on their ID.
-    int cityCount;                // Variable to keep track of how many cities have been added.
+    mt19937 rng(59);
+    vector<int> profiles;
+    for (double peak : {1.2, 1.4, 1.6, 1.8, 2.0, 2.5, 3.0, 4.0}) {
+        profiles.push_back(planner.addTrafficProfile(planner.makeRushHourProfile(peak)));
+    }
+    uniform_int_distribution<int> profilePick(0, (int)profiles.size() - 1);
+    uniform_real_distribution<double> chance(0, 1);
+    for (int r = 0; r < roads; r++) {
+        if (chance(rng) < 0.6) planner.setRoadProfile(r, profiles[profilePick(rng)]);
+    }
 
-public:
-    // Constructor to initialize the RoutePlanner object.
-    RoutePlanner() {
-        cityCount = 0;       // Starts the city count at 0.
-        initializeMapData(); // Calls the function to load all hardcoded map data.
+    // FIFO: entering a road later never gets you out earlier.
+    int fifoViolations = 0;
+    uniform_int_distribution<int> roadPick(0, roads - 1);
+    uniform_real_distribution<double> clockPick(0, 1440), gapPick(0, 30);
+    Edge sample = {2, LOW, HIGHWAY, 0, 0, 0};
+    for (int k = 0; k < 20000; k++) {
+        sample.distanceKM = 1 + chance(rng) * 300; // Short and very long roads.
+        sample.profileId = (unsigned short)profiles[profilePick(rng)];
+        double early = clockPick(rng), late = early + gapPick(rng);
+        int speed = 40 + (int)(chance(rng) * 120);
+        if (early + planner.getProfileTravelTime(sample, speed, early) >
+            late + planner.getProfileTravelTime(sample, speed, late) + 1e-9) fifoViolations++;
     }
 
-    // Helper function: converts TrafficLevel enum to a numerical time multiplier.
-    double getTrafficMultiplier(TrafficLevel level) {
-        switch (level) {
-            case LOW: return 1.0;       // No delay.
-            case MODERATE: return 1.2;  // 20% slower.
-            case HIGH: return 1.5;      // 50% slower.
-            case JAMMED: return 2.5;    // 150% slower (2.5x time).
-            default: return 1.0;        // Default fallback is no delay.
+    cout << "Grid " << side << "x" << side << " (" << n << " cities, " << roads << " directed roads), "
+         << queries << " random queries" << endl;
+    cout << fixed << setprecision(3);
+    for (double departure : {3 * 60.0, 8.5 * 60, 18 * 60.0}) {
+        double seconds = 0, minutes = 0;
+        for (auto& q : pairs) {
+            double time = 0, dist, fuel;
+            auto t0 = chrono::steady_clock::now();
+            planner.computeTimeDependentRoute(q.first, q.second, 100, departure, route, time, dist, fuel);
+            seconds += chrono::duration<double>(chrono::steady_clock::now() - t0).count();
+            minutes += time;
         }
+        cout << "  departing " << planner.formatClock(departure) << " : " << seconds * 1000 / queries
+             << " ms/query, average trip " << minutes / queries << " min" << endl;
     }
+    size_t profileBytes = planner.getProfileBytes() + (size_t)roads * sizeof(unsigned short);
+    cout << "  profile storage   : " << profileBytes / 1024.0 << " KiB (" << planner.getProfileCount()
+         << " shared profiles + 2-byte id per road) vs " << (size_t)roads * PROFILE_SLOTS * sizeof(double) / 1024.0
+         << " KiB for 96 doubles per road" << endl;
+    cout << "  FIFO violations   : " << fifoViolations << " of 20000 sampled departures" << endl;
+    cout << "  no-profile answers differing from Dijkstra : " << staticMismatches << endl;
+}
 
-    // Helper function: converts TrafficLevel enum to a readable string.
-    string getTrafficString(TrafficLevel level) {
-        switch (level) {
-            case LOW: return "Clear";       // Returns "Clear" text.
-            case MODERATE: return "Moderate"; // Returns "Moderate" text.
-            case HIGH: return "Heavy";        // Returns "Heavy" text.
-            case JAMMED: return "Jammed";     // Returns "Jammed" text.
-            default: return "Unknown";      // Default fallback text.
-        }
+// Compares startup from the built-in style (addCity/addRoad calls plus the CSR build)
+// with mapping a binary graph file, checks the mapped map answers queries the same way and
+// that damaged files are refused.
+void runGraphFileBenchmark(int side, int queries, const string& path) {
+    SyntheticMap map = generateGridMap(side, side, 42);
+    auto t0 = chrono::steady_clock::now();
+    RoutePlanner built(false);
+    loadSyntheticMap(built, map);
+    double buildMs = chrono::duration<double, milli>(chrono::steady_clock::now() - t0).count();
+    int n = built.getCityCount(), roads = built.getEdgeCount();
+
+    t0 = chrono::steady_clock::now();
+    bool saved = built.saveBinaryGraph(path);
+    double saveMs = chrono::duration<double, milli>(chrono::steady_clock::now() - t0).count();
+    ifstream sizeCheck(path, ios::binary | ios::ate);
+    double fileMiB = saved ? (double)sizeCheck.tellg() / (1 << 20) : 0;
+
+    // Several loads of the same file: each one maps it again, like separate worker processes.
+    const int loads = 5;
+    double loadMs = INF;
+    bool loaded = saved;
+    RoutePlanner mapped(false);
+    for (int k = 0; k < loads && loaded; k++) {
+        RoutePlanner worker(false);
+        t0 = chrono::steady_clock::now();
+        loaded = worker.loadBinaryGraph(path);
+        loadMs = min(loadMs, chrono::duration<double, milli>(chrono::steady_clock::now() - t0).count());
     }
+    loaded = loaded && mapped.loadBinaryGraph(path);
 
-    // Function to calculate fuel efficiency (km/L) based on speed and road type.
-    double calculateFuelEfficiency(int speed, RoadType type) {
-        double baseEfficiency = 16.0; // Sets a baseline efficiency for a standard car.
-        
-        // Reduces efficiency by 4 km/L if driving on local roads (stop-and-go).
-        if (type == LOCAL) baseEfficiency -= 4.0; 
-        
-        // Adjusts efficiency for high speeds (aerodynamic drag).
-        if (speed > 90) {
-            double excess = speed - 90; // Calculates how much over 90 km/h the car is going.
-            // Formula to reduce efficiency quadratically as speed increases.
-            double drop = (excess * excess) / 400.0; 
-            return max(5.0, baseEfficiency - drop); // Returns the result, ensuring it doesn't drop below 5.0.
-        } else if (speed < 40) {
-             // Reduces efficiency by 3 km/L for very low speeds (inefficient engine range).
-            return baseEfficiency - 3.0;
+    vector<pair<int, int>> pairs = randomPairs(n, queries, 61);
+    vector<int> route;
+    int mismatches = 0;
+    double firstMs = 0, builtMs = 0, mappedMs = 0;
+    for (size_t k = 0; k < pairs.size() && loaded; k++) {
+        auto& q = pairs[k];
+        double time = INF, dist = 0, fuel = 0, mTime = INF, mDist = 0, mFuel = 0;
+        t0 = chrono::steady_clock::now();
+        built.computeDijkstraRoute(q.first, q.second, 100, route, time, dist, fuel);
+        builtMs += chrono::duration<double, milli>(chrono::steady_clock::now() - t0).count();
+        t0 = chrono::steady_clock::now();
+        mapped.computeDijkstraRoute(q.first, q.second, 100, route, mTime, mDist, mFuel);
+        double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - t0).count();
+        if (k == 0) firstMs = ms; // Pays for faulting in the pages it touches.
+        mappedMs += ms;
+        if (time != mTime || dist != mDist || fuel != mFuel) mismatches++;
+    }
+
+    // Damages one stored index at a time (an offset, a road target, a name id) and checks
+    // that the file is refused, then puts the original bytes back.
+    int refused = 0;
+    const int damages = 3;
+    GraphFileHeader header;
+    ifstream headerIn(path, ios::binary);
+    bool haveHeader = loaded && (bool)headerIn.read((char*)&header, sizeof(header));
+    headerIn.close();
+    for (int k = 0; k < damages && haveHeader; k++) {
+        unsigned long long at = k == 0 ? header.sectionOffset[SECTION_OFFSETS] + 2 * sizeof(int)
+                              : k == 1 ? header.sectionOffset[SECTION_EDGES] + offsetof(Edge, destination)
+                                       : header.sectionOffset[SECTION_NAME_IDS];
+        int bad = k == 0 ? -1 : k == 1 ? n + 1 : 1 << 30, original = 0;
+        fstream patch(path, ios::in | ios::out | ios::binary);
+        patch.seekg(at);
+        patch.read((char*)&original, sizeof(int));
+        patch.seekp(at);
+        patch.write((const char*)&bad, sizeof(int));
+        patch.flush();
+        RoutePlanner damaged(false);
+        if (!damaged.loadBinaryGraph(path)) refused++;
+        patch.seekp(at);
+        patch.write((const char*)&original, sizeof(int));
+    }
+    remove(path.c_str());
+
+    cout << "Grid " << side << "x" << side << " (" << n << " cities, " << roads << " directed roads)" << endl;
+    if (!loaded) {
+        cout << "  could not write or map " << path << endl;
+        return;
+    }
+    cout << fixed << setprecision(2);
+    cout << "  build from addCity/addRoad : " << buildMs << " ms" << endl;
+    cout << "  write binary graph         : " << saveMs << " ms, " << fileMiB << " MiB" << endl;
+    cout << "  map binary graph           : " << setprecision(3) << loadMs << setprecision(2) << " ms (best of " << loads << ")" << endl;
+    cout << "  first query after mapping  : " << firstMs << " ms" << endl;
+    cout << "  avg query built / mapped   : " << builtMs / queries << " / " << mappedMs / queries << " ms" << endl;
+    cout << "  answers differing          : " << mismatches << " of " << queries << endl;
+    cout << "  damaged files refused      : " << refused << " of " << damages << endl;
+}
+
+// Writes a synthetic map as the three import files (node CSV, road CSV, OSM-like text).
+// Every road becomes a two-node way in the OSM-like file, tagged with speeds that map back
+// onto its traffic level.
+void writeSyntheticExtracts(const SyntheticMap& map, const string& nodeCsv, const string& roadCsv, const string& osmText) {
+    const char* classes[ROAD_TYPE_COUNT] = {"motorway", "primary", "residential"};
+    const char* levels[4] = {"low", "moderate", "high", "jammed"};
+    const int observed[4] = {100, 70, 50, 20};    // Speeds on a 100 km/h road for each level.
+    ofstream nodes(nodeCsv), roads(roadCsv), osm(osmText);
+    nodes << "id,name,lat,lon\n" << setprecision(17);
+    roads << "from,to,length_km,class,name,maxspeed,speed,traffic\n" << setprecision(17);
+    osm << setprecision(17);
+    for (int id = 1; id <= map.cityCount; id++) {
+        long long fileId = 1000000000LL + id;     // Large IDs like real extracts.
+        nodes << fileId << ",City " << id << "," << map.lat[id] << "," << map.lon[id] << "\n";
+        osm << "node " << fileId << " " << map.lat[id] << " " << map.lon[id] << " name=City " << id << "\n";
+    }
+    long long way = 1;
+    for (auto& r : map.roads) {
+        roads << 1000000000LL + r.u << "," << 1000000000LL + r.v << "," << r.distanceKM << "," << classes[r.type]
+              << ",Synthetic Road,,," << levels[r.traffic] << "\n";
+        osm << "way " << way++ << " " << 1000000000LL + r.u << "," << 1000000000LL + r.v << " class=" << classes[r.type]
+            << " maxspeed=100 speed=" << observed[r.traffic] << " name=Synthetic Road\n";
+    }
+}
+
+// Measures the import rate of both formats on one thread and on all threads, and checks the
+// CSV import answers queries exactly like the same map loaded directly.
+void runImportBenchmark(int side, int threads, const string& prefix) {
+    SyntheticMap map = generateGridMap(side, side, 42);
+    string nodeCsv = prefix + "_nodes.csv", roadCsv = prefix + "_roads.csv", osmText = prefix + ".osm.txt";
+    writeSyntheticExtracts(map, nodeCsv, roadCsv, osmText);
+    cout << "Grid " << side << "x" << side << " (" << map.cityCount << " cities, " << map.roads.size() * 2
+         << " directed roads)" << endl;
+
+    RoutePlanner reference(false);
+    loadSyntheticMap(reference, map);
+    vector<int> threadCounts = {1};
+    if (resolveThreadCount(threads) > 1) threadCounts.push_back(resolveThreadCount(threads));
+    for (int t : threadCounts) {
+        RoutePlanner csv(false);
+        RoadNetworkImporter csvImporter(csv, t);
+        bool csvOk = csvImporter.importCsv(nodeCsv, roadCsv);
+        cout << "CSV, " << t << " thread(s)" << (csvOk ? "" : ": could not read the files") << endl;
+        printImportStats(csvImporter.getStats());
+
+        RoutePlanner osm(false);
+        RoadNetworkImporter osmImporter(osm, t);
+        bool osmOk = osmImporter.importOsmText(osmText);
+        cout << "OSM-like text, " << t << " thread(s)" << (osmOk ? "" : ": could not read the file") << endl;
+        printImportStats(osmImporter.getStats());
+
+        int mismatches = 0;
+        vector<int> route;
+        for (auto& q : randomPairs(map.cityCount, 20, 67)) {
+            double time = INF, dist = 0, fuel = 0, cTime = INF, cDist = 0, cFuel = 0;
+            reference.computeDijkstraRoute(q.first, q.second, 100, route, time, dist, fuel);
+            csv.computeDijkstraRoute(q.first, q.second, 100, route, cTime, cDist, cFuel);
+            if (time != cTime || dist != cDist || fuel != cFuel) mismatches++;
         }
-        return baseEfficiency; // Returns base efficiency for optimal speeds (40-90 km/h).
+        cout << "  CSV answers differing from the directly loaded map: " << mismatches << " of 20" << endl;
     }
+    remove(nodeCsv.c_str());
+    remove(roadCsv.c_str());
+    remove(osmText.c_str());
+}
 
-    // ==========================================
-    //      MAP DATA INITIALIZATION
-    // ==========================================
-    // Function to register a city name with an ID.
-    void addCity(int id, string name) {
-        if (id < MAX_CITIES) {          // Checks if the ID is within the valid range.
-            cityNames[id] = name;       // Assigns the name to the array at the given index.
-            cityCount = max(cityCount, id); // Updates total count to the highest ID used.
+// Measures both preprocessing phases of the partition overlay, compares its queries with
+// Dijkstra and the contraction hierarchy, and compares the cost of a traffic update
+// (re-customizing the touched cells) with a full customization and a hierarchy rebuild.
+void runOverlayBenchmark(int side, int queries, int updates) {
+    RoutePlanner planner(false);
+    loadSyntheticMap(planner, generateGridMap(side, side, 42));
+    int n = planner.getCityCount(), roads = planner.getEdgeCount();
+
+    auto t0 = chrono::steady_clock::now();
+    planner.buildPartitionOverlay(vector<int>(), 1);
+    double firstMs = chrono::duration<double, milli>(chrono::steady_clock::now() - t0).count();
+    t0 = chrono::steady_clock::now();
+    planner.customizePartitionOverlay(1);
+    double serialMs = chrono::duration<double, milli>(chrono::steady_clock::now() - t0).count();
+    t0 = chrono::steady_clock::now();
+    planner.customizePartitionOverlay(0);
+    double parallelMs = chrono::duration<double, milli>(chrono::steady_clock::now() - t0).count();
+    t0 = chrono::steady_clock::now();
+    planner.buildContractionHierarchy();
+    double hierarchyMs = chrono::duration<double, milli>(chrono::steady_clock::now() - t0).count();
+
+    const PartitionOverlay& overlay = planner.getPartitionOverlay();
+    cout << "Grid " << side << "x" << side << " (" << n << " cities, " << roads << " directed roads)" << endl;
+    cout << fixed << setprecision(2);
+    for (int l = 0; l < overlay.getLevelCount(); l++) {
+        cout << "  level " << l << ": " << overlay.getCellCount(l) << " cells, " << overlay.getBoundaryCount(l)
+             << " boundary cities" << endl;
+    }
+    cout << "  partition + customization   : " << firstMs << " ms" << endl;
+    cout << "  customization, 1 thread     : " << serialMs << " ms" << endl;
+    cout << "  customization, " << resolveThreadCount(0) << " thread(s)  : " << parallelMs << " ms" << endl;
+    cout << "  contraction hierarchy build : " << hierarchyMs << " ms" << endl;
+    compareModes(planner, randomPairs(n, queries, 71), 100, "Before traffic changes",
+                 {DIJKSTRA, CONTRACTION_HIERARCHY, PARTITION_OVERLAY});
+
+    mt19937 rng(73);
+    uniform_int_distribution<int> roadPick(0, roads - 1), levelPick(0, 3);
+    t0 = chrono::steady_clock::now();
+    for (int k = 0; k < updates; k++) planner.updateTraffic(roadPick(rng), (TrafficLevel)levelPick(rng));
+    double updateMs = chrono::duration<double, milli>(chrono::steady_clock::now() - t0).count();
+    cout << "  traffic update incl. re-customization: " << updateMs / max(1, updates) << " ms each ("
+         << updates << " updates)" << endl;
+    compareModes(planner, randomPairs(n, queries, 79), 100, "After traffic changes", {DIJKSTRA, PARTITION_OVERLAY});
+}
+
+// Prints the Islamabad -> Lahore options of the built-in map, then asks for up to k routes
+// between random pairs of a synthetic grid and reports query time and work against one
+// Dijkstra search, how many options were found, and any option breaking the limits.
+// Grids have no road hierarchy, so fewer long detours are locally optimal than on real maps;
+// 'localOptimality' can be lowered to see more of them.
+void runAlternativeBenchmark(int side, int queries, int k, double localOptimality) {
+    RoutePlanner builtIn;
+    builtIn.findAlternativeRoutes(7, 6, 100, k);
+
+    RoutePlanner planner(false);
+    loadSyntheticMap(planner, generateGridMap(side, side, 42));
+    AlternativeLimits limits;
+    limits.maxRoutes = k;
+    limits.localOptimality = localOptimality;
+    vector<int> route;
+    double seconds = 0, dijkstraSeconds = 0, stretch = 0, sharing = 0;
+    long long settled = 0, dijkstraSettled = 0, options = 0, alternatives = 0;
+    int mismatches = 0, violations = 0;
+    for (auto& q : randomPairs(planner.getCityCount(), queries, 83)) {
+        auto t0 = chrono::steady_clock::now();
+        vector<AlternativeRoute> found = planner.planAlternativeRoutes(q.first, q.second, 100, limits);
+        seconds += chrono::duration<double>(chrono::steady_clock::now() - t0).count();
+        settled += planner.getLastSearchStats().settledNodes;
+
+        double time = INF, dist, fuel;
+        t0 = chrono::steady_clock::now();
+        planner.computeDijkstraRoute(q.first, q.second, 100, route, time, dist, fuel);
+        dijkstraSeconds += chrono::duration<double>(chrono::steady_clock::now() - t0).count();
+        dijkstraSettled += planner.getLastSearchStats().settledNodes;
+
+        if (found.empty() || fabs(found[0].result.totalTime - time) > 1e-9 * max(1.0, time)) mismatches++;
+        options += found.size();
+        for (size_t a = 1; a < found.size(); a++) {
+            alternatives++;
+            stretch += found[a].stretch;
+            sharing += found[a].sharing;
+            if (found[a].stretch > limits.maxStretch + 1e-9 || found[a].sharing > limits.maxSharing + 1e-9) violations++;
         }
     }
 
-    // Function to add a road (edge) between two cities.
-    void addRoad(int u, int v, double dist, TrafficLevel traf, RoadType type, string name) {
-        // Adds connection from City U to City V.
-        adj[u].push_back({v, dist, traf, type, name});
-        // Adds connection from City V to City U (since roads are two-way).
-        adj[v].push_back({u, dist, traf, type, name});
+    cout << "\nGrid " << side << "x" << side << " (" << planner.getCityCount() << " cities), " << queries
+         << " random queries, up to " << k << " routes each, local optimality " << setprecision(2) << localOptimality << endl;
+    cout << fixed << setprecision(3);
+    cout << "  alternatives     : " << seconds * 1000 / queries << " ms/query, "
+         << (double)settled / queries << " settled/query" << endl;
+    cout << "  one Dijkstra     : " << dijkstraSeconds * 1000 / queries << " ms/query, "
+         << (double)dijkstraSettled / queries << " settled/query" << endl;
+    cout << "  routes found     : " << (double)options / queries << " per query" << endl;
+    if (alternatives > 0) {
+        cout << "  alternatives     : " << setprecision(1) << stretch * 100 / alternatives << "% longer, "
+             << sharing * 100 / alternatives << "% shared on average" << endl;
     }
+    cout << "  fastest option differs from Dijkstra : " << mismatches << endl;
+    cout << "  options breaking the limits          : " << violations << endl;
+}
 
-    // Function to hardcode all the cities and roads into the system.
-    void initializeMapData() {
-        // 1. Define Cities
-        addCity(1, "Karachi");      // Adds Karachi as City 1.
-        addCity(2, "Hyderabad");    // Adds Hyderabad as City 2.
-        addCity(3, "Sukkur");       // Adds Sukkur as City 3.
-        addCity(4, "Multan");       // Adds Multan as City 4.
-        addCity(5, "Faisalabad");   // Adds Faisalabad as City 5.
-        addCity(6, "Lahore");       // Adds Lahore as City 6.
-        addCity(7, "Islamabad");    // Adds Islamabad as City 7.
-        addCity(8, "Peshawar");     // Adds Peshawar as City 8.
-        addCity(9, "Quetta");       // Adds Quetta as City 9.
-        addCity(10, "Gwadar");      // Adds Gwadar as City 10.
-        addCity(11, "Sialkot");     // Adds Sialkot as City 11.
-        addCity(12, "Abbottabad");  // Adds Abbottabad as City 12.
-        addCity(13, "Gilgit");      // Adds Gilgit as City 13.
-        addCity(14, "Sahiwal");     // Adds Sahiwal as City 14.
-        addCity(15, "Bahawalpur");  // Adds Bahawalpur as City 15.
+// Prints the 4-hour isochrone of Multan on the built-in map, then computes isochrones of many
+// origins on a synthetic grid on one thread and on all cores, and checks a few of them
+// against one-to-all Dijkstra.
+void runIsochroneBenchmark(int side, int originCount, double minutes) {
+    RoutePlanner builtIn;
+    builtIn.findIsochrone(4, 100, 4);
 
-        // 2. Define Roads (Source, Dest, Dist, Traffic, Type, Name)
-        
-        // South Corridor
-        addRoad(1, 2, 165, JAMMED, MOTORWAY, "M-9 Motorway"); // Adds M-9 from Karachi to Hyd.
-        addRoad(2, 3, 330, MODERATE, HIGHWAY, "N-5 National Hwy"); // Adds N-5 from Hyd to Sukkur.
-        addRoad(3, 4, 420, LOW, MOTORWAY, "M-5 Sukkur-Multan"); // Adds M-5 from Sukkur to Multan.
-        addRoad(3, 9, 390, LOW, HIGHWAY, "N-65 Highway"); // Adds N-65 from Sukkur to Quetta.
-        
-        // Central Corridor
-        addRoad(4, 5, 240, LOW, MOTORWAY, "M-4 Motorway"); // Adds M-4 from Multan to Faisalabad.
-        addRoad(4, 15, 90, MODERATE, HIGHWAY, "N-5 Lodhran"); // Adds road from Multan to Bahawalpur.
-        addRoad(15, 3, 300, LOW, HIGHWAY, "N-5 South"); // Adds road from BWP to Sukkur.
-        addRoad(4, 14, 180, MODERATE, HIGHWAY, "N-5 GT Road"); // Adds road from Multan to Sahiwal.
-        addRoad(14, 6, 170, HIGH, HIGHWAY, "N-5 Okara"); // Adds road from Sahiwal to Lahore.
+    RoutePlanner planner(false);
+    loadSyntheticMap(planner, generateGridMap(side, side, 42));
+    vector<int> origins;
+    for (auto& q : randomPairs(planner.getCityCount(), originCount, 89)) origins.push_back(q.first);
 
-        // Punjab Grid
-        addRoad(5, 6, 150, HIGH, MOTORWAY, "M-3 Motorway"); // Adds M-3 from Fsd to Lahore.
-        addRoad(5, 7, 320, LOW, MOTORWAY, "M-4 (Goa-Pindi)"); // Adds M-4 from Fsd to Islamabad.
-        addRoad(6, 7, 375, MODERATE, MOTORWAY, "M-2 Motorway"); // Adds M-2 from Lahore to Islamabad.
-        addRoad(6, 11, 130, MODERATE, MOTORWAY, "M-11 Sialkot"); // Adds M-11 from Lahore to Sialkot.
-        
-        // North Corridor
-        addRoad(7, 8, 180, LOW, MOTORWAY, "M-1 Motorway"); // Adds M-1 from Islamabad to Peshawar.
-        addRoad(7, 12, 120, HIGH, HIGHWAY, "N-35 Karakoram"); // Adds N-35 from Isb to Abbottabad.
-        addRoad(12, 13, 450, HIGH, HIGHWAY, "KKH (Hazara)"); // Adds KKH from Abbottabad to Gilgit.
+    auto t0 = chrono::steady_clock::now();
+    vector<IsochroneResult> serial = planner.computeIsochrones(origins, 100, minutes, TIME_BUDGET, 1);
+    auto t1 = chrono::steady_clock::now();
+    vector<IsochroneResult> batch = planner.computeIsochrones(origins, 100, minutes, TIME_BUDGET, 0);
+    auto t2 = chrono::steady_clock::now();
 
-        // West Corridor
-        addRoad(1, 10, 650, LOW, HIGHWAY, "N-10 Coastal Hwy"); // Adds Coastal Hwy from Karachi to Gwadar.
-        addRoad(10, 9, 920, LOW, HIGHWAY, "N-85 Highway"); // Adds N-85 from Gwadar to Quetta.
-        addRoad(9, 8, 800, LOW, HIGHWAY, "N-50 Zhob Route"); // Adds N-50 from Quetta to Peshawar.
+    long long cities = 0, cuts = 0;
+    int mismatches = 0;
+    for (size_t k = 0; k < origins.size(); k++) {
+        cities += batch[k].cities.size();
+        cuts += batch[k].cutRoads.size();
+        if (batch[k].cities != serial[k].cities) mismatches++;
+    }
+    vector<double> minTime, fuelConsumed, pathDist;
+    vector<int> parent;
+    int checked = min(originCount, 5);
+    for (int k = 0; k < checked; k++) {
+        planner.computeShortestPaths(origins[k], 100, minTime, parent, fuelConsumed, pathDist);
+        int inside = 0;
+        for (double t : minTime) if (t <= minutes) inside++;
+        bool same = inside == (int)batch[k].cities.size();
+        for (size_t c = 0; same && c < batch[k].cities.size(); c++) {
+            same = fabs(minTime[batch[k].cities[c]] - batch[k].spent[c]) <= 1e-9 * max(1.0, batch[k].spent[c]);
+        }
+        if (!same) mismatches++;
     }
 
-    // ==========================================
-    //      MAIN ALGORITHM (DIJKSTRA)
-    // ==========================================
-    // Main function to calculate the shortest path.
-    void findRoute(int startNode, int endNode, int speed) {
-        // Validates that the input IDs exist in our data.
-        if (startNode < 1 || startNode > cityCount || endNode < 1 || endNode > cityCount) {
-            cout << "Invalid City ID Selected!" << endl; // Prints error if invalid.
-            return; // Exits the function.
+    double serialSec = chrono::duration<double>(t1 - t0).count();
+    double batchSec = chrono::duration<double>(t2 - t1).count();
+    cout << "\nGrid " << side << "x" << side << " (" << planner.getCityCount() << " cities), " << originCount
+         << " origins, " << minutes << " minutes at 100 km/h" << endl;
+    cout << fixed << setprecision(3);
+    cout << "  reachable area   : " << (double)cities / originCount << " cities, "
+         << (double)cuts / originCount << " cut roads per origin" << endl;
+    cout << "  1 thread         : " << serialSec * 1000 / originCount << " ms/origin" << endl;
+    cout << "  " << resolveThreadCount(0) << " thread(s)      : " << batchSec * 1000 / originCount << " ms/origin ("
+         << setprecision(0) << originCount / batchSec << " isochrones/s)" << endl;
+    cout << "  differing results : " << mismatches << endl;
+}
+
+// Starts a query server on a synthetic grid and connects 'clients' local socket clients to
+// it. Each client keeps up to 64 requests outstanding and times every answer; the report
+// gives requests per second, client-side p50/p99 latency, the server's own summary and how
+// many answers differ from Dijkstra on a sample. The server always runs at least 4 workers,
+// so the default 'ch' run has several hierarchy queries in flight at once; every answer is
+// also checked against the same mode queried on one thread, which catches any search state
+// shared between workers.
+void runServerBenchmark(int side, int requests, int clients, const string& modeName) {
+#ifdef _WIN32
+    cout << "The server benchmark needs Unix domain sockets." << endl;
+#else
+    RoutePlanner planner(false);
+    loadSyntheticMap(planner, generateGridMap(side, side, 42));
+    int n = planner.getCityCount();
+    vector<pair<int, int>> pairs = randomPairs(n, requests, 97);
+    clients = max(1, clients);
+    const int WINDOW = 64;    // Requests a client keeps outstanding.
+
+    SearchMode mode;
+    if (!QueryServer::parseMode(modeName, mode)) {
+        cout << "Unknown search mode " << modeName << endl;
+        return;
+    }
+    int workers = max(4, resolveThreadCount(0));
+    QueryServer server(planner, workers);
+    server.start({mode});     // Preprocessing is not part of the measured time.
+    auto t0 = chrono::steady_clock::now();
+    vector<double> latencies(requests, 0);
+    vector<double> minutes(requests, -1);
+    vector<thread> threads;
+    for (int c = 0; c < clients; c++) {
+        int fds[2];
+        if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0) {
+            cout << "Could not create a socket pair." << endl;
+            return;
         }
+        threads.emplace_back(&QueryServer::serveConnection, &server, fds[0]);
+        threads.emplace_back([&, c, fd = fds[1]] {
+            vector<int> mine;
+            for (int r = c; r < requests; r += clients) mine.push_back(r);
+            vector<chrono::steady_clock::time_point> sentAt(requests);
+            mutex windowMutex;
+            condition_variable windowOpen;
+            int outstanding = 0;
+            thread writer([&] {
+                for (int r : mine) {
+                    {
+                        unique_lock<mutex> lock(windowMutex);
+                        windowOpen.wait(lock, [&] { return outstanding < WINDOW; });
+                        outstanding++;
+                    }
+                    string line = to_string(r) + " " + to_string(pairs[r].first) + " " +
+                                  to_string(pairs[r].second) + " 100 " + modeName + "\n";
+                    sentAt[r] = chrono::steady_clock::now();
+                    for (size_t done = 0; done < line.size();) {
+                        ssize_t sent = ::send(fd, line.data() + done, line.size() - done, MSG_NOSIGNAL);
+                        if (sent <= 0) return;
+                        done += (size_t)sent;
+                    }
+                }
+                ::shutdown(fd, SHUT_WR); // No more requests: the server's reader sees the end.
+            });
+            string pending;
+            char buffer[1 << 16];
+            size_t answered = 0;
+            while (answered < mine.size()) {
+                ssize_t got = ::read(fd, buffer, sizeof(buffer));
+                if (got <= 0) break;
+                auto now = chrono::steady_clock::now();
+                pending.append(buffer, (size_t)got);
+                size_t begin = 0;
+                for (size_t end; (end = pending.find('\n', begin)) != string::npos; begin = end + 1) {
+                    int r = -1;
+                    double time = -1;
+                    char status[8] = "";
+                    sscanf(pending.c_str() + begin, "%d %7s %lf", &r, status, &time);
+                    if (r < 0 || r >= requests) continue;
+                    latencies[r] = chrono::duration<double, micro>(now - sentAt[r]).count();
+                    if (string(status) == "OK") minutes[r] = time;
+                    answered++;
+                    {
+                        lock_guard<mutex> lock(windowMutex);
+                        outstanding--;
+                    }
+                    windowOpen.notify_one();
+                }
+                pending.erase(0, begin);
+            }
+            writer.join();
+            ::close(fd);
+        });
+    }
+    for (auto& t : threads) t.join();
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - t0).count();
+    server.stop();
+    string summary = server.latencySummary();
 
-        // DP Arrays and Priority Queue setup
-        priority_queue<PqNode, vector<PqNode>, greater<PqNode>> pq; // Creates a Min-Heap priority queue.
-        vector<double> minTime(MAX_CITIES, INF);    // Initializes all times to Infinity.
-        vector<int> parent(MAX_CITIES, -1);         // Initializes parent array to track the path.
-        vector<double> fuelConsumed(MAX_CITIES, 0.0); // Initializes fuel tracking array.
-        vector<double> pathDist(MAX_CITIES, 0.0);   // Initializes distance tracking array.
+    int mismatches = 0, failed = 0, unstable = 0;
+    for (double m : minutes) if (m < 0) failed++;
+    for (int r = 0; r < requests; r += max(1, requests / 200)) { // Sample checked against Dijkstra.
+        RouteResult expected = planner.planRoute(pairs[r].first, pairs[r].second, 100, DIJKSTRA);
+        if (fabs(expected.totalTime - minutes[r]) > 1e-3 * max(1.0, expected.totalTime)) mismatches++;
+    }
+    for (int r = 0; r < requests; r++) { // Every answer against the same mode on this thread alone.
+        RouteResult expected = planner.planRoute(pairs[r].first, pairs[r].second, 100, mode);
+        if (fabs((expected.found ? expected.totalTime : -1) - minutes[r]) > 1e-3 * max(1.0, expected.totalTime)) unstable++;
+    }
+    vector<double> sorted = latencies;
+    sort(sorted.begin(), sorted.end());
+    auto percentile = [&](double fraction) {
+        return sorted.empty() ? 0.0 : sorted[min(sorted.size() - 1, (size_t)(fraction * sorted.size()))];
+    };
 
-        // Initialize Start Node
-        minTime[startNode] = 0;          // Time to reach start node is 0.
-        pq.push({startNode, 0});         // Adds start node to the queue.
+    cout << "Grid " << side << "x" << side << " (" << n << " cities), " << requests << " '" << modeName
+         << "' requests from " << clients << " client(s), " << workers << " worker(s)" << endl;
+    cout << fixed << setprecision(1);
+    cout << "  throughput       : " << requests / seconds << " requests/s" << endl;
+    cout << "  client latency   : p50 " << percentile(0.5) << " us, p99 " << percentile(0.99) << " us" << endl;
+    cout << "  server           : " << summary << endl;
+    cout << "  failed requests  : " << failed << endl;
+    cout << "  differing from Dijkstra (sample) : " << mismatches << endl;
+    cout << "  differing from one thread        : " << unstable << endl;
+#endif
+}
 
-        // Loop until there are no more nodes to process.
-        while (!pq.empty()) {
-            int u = pq.top().id;         // Gets the city ID with the lowest time cost.
-            double currentTime = pq.top().timeCost; // Gets the time cost of that city.
-            pq.pop();                    // Removes that city from the queue.
+// Reads the resident memory of this process now and at its peak, in MB (0 where unknown).
+void readProcessMemoryMB(double& current, double& peak) {
+    current = peak = 0;
+#ifndef _WIN32
+    long pages = 0, resident = 0;
+    FILE* statm = fopen("/proc/self/statm", "r"); // Linux only; other systems report the peak alone.
+    if (statm) {
+        if (fscanf(statm, "%ld %ld", &pages, &resident) == 2) current = resident * (double)sysconf(_SC_PAGESIZE) / (1 << 20);
+        fclose(statm);
+    }
+    rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) == 0) {
+#ifdef __APPLE__
+        peak = usage.ru_maxrss / double(1 << 20); // Bytes on macOS.
+#else
+        peak = usage.ru_maxrss / 1024.0;          // Kilobytes on Linux.
+#endif
+    }
+#endif
+}
 
-            // Optimization: If we found a faster way to 'u' previously, skip this one.
-            if (currentTime > minTime[u]) continue;
+// Regression benchmark suite: for every topology of 'topologyList' (comma separated from
+// "grid", "geometric" and "scalefree") with a realistic road mix, and every size 10^3, 10^4,
+// ... up to 'maxCities', runs 'queries' random planRoute queries (the search behind findRoute)
+// in each search mode of 'modeList' (comma separated, e.g. "dijkstra,bidir,astar,ch"). Writes one JSON object per line to 'out' so
+// runs of different versions can be compared by a script; progress goes to stderr.
+// The maps and queries depend only on the size and topology, never on the run.
+void runBenchmarkSuite(int maxCities, int queries, const string& modeList, const string& topologyList, ostream& out) {
+    vector<SearchMode> modes;
+    vector<string> modeNames;
+    stringstream list(modeList);
+    for (string name; getline(list, name, ',');) {
+        SearchMode mode;
+        if (!QueryServer::parseMode(name, mode)) {
+            cerr << "Unknown search mode " << name << endl;
+            return;
+        }
+        modes.push_back(mode);
+        modeNames.push_back(name);
+    }
+    const char* known[] = {"grid", "geometric", "scalefree"};
+    vector<int> topologies;
+    stringstream topologyNames(topologyList);
+    for (string name; getline(topologyNames, name, ',');) {
+        int t = (int)(find(begin(known), end(known), name) - begin(known));
+        if (t == 3) {
+            cerr << "Unknown topology " << name << endl;
+            return;
+        }
+        topologies.push_back(t);
+    }
+    const int SPEED = 100;
+    int instrumented = 0;     // Heap pushes and stale pops are only counted with ROUTE_METRICS.
+    METRIC(instrumented = 1);
 
-            // Iterate through all roads connected to the current city 'u'.
-            for (auto& edge : adj[u]) {
-                int v = edge.destination; // Get the neighbor city ID.
-                
-                // --- PHYSICS LOGIC START ---
-                double multiplier = getTrafficMultiplier(edge.traffic); // Get traffic delay factor.
-                
-                // Calculates base time: (Distance / Speed) * 60 to get minutes.
-                double baseTime = (edge.distanceKM / speed) * 60.0;
-                // Calculates real time including traffic delay.
-                double realTime = baseTime * multiplier;
+    for (long long cities = 1000; cities <= maxCities; cities *= 10) {
+        for (int t : topologies) {
+            string topology = known[t];
+            unsigned seed = 1000 + 17 * t + (unsigned)log10((double)cities);
+            auto t0 = chrono::steady_clock::now();
+            SyntheticMap map;
+            if (t == 0) {
+                int side = (int)llround(sqrt((double)cities));
+                map = generateGridMap(side, side, seed);
+            } else if (t == 1) {
+                map = generateGeometricMap((int)cities, seed);
+            } else {
+                map = generateScaleFreeMap((int)cities, seed);
+            }
+            applyRealisticRoadMix(map, seed);
+            auto t1 = chrono::steady_clock::now();
+            RoutePlanner planner(false);
+            loadSyntheticMap(planner, map);
+            size_t twoWayRoads = map.roads.size();
+            SyntheticMap().roads.swap(map.roads); // Only the planner's copy is measured from here.
+            double generateMs = chrono::duration<double, milli>(t1 - t0).count();
+            double loadMs = chrono::duration<double, milli>(chrono::steady_clock::now() - t1).count();
+            int n = planner.getCityCount();
+            vector<pair<int, int>> pairs = randomPairs(n, queries, seed);
 
-                // Relaxation Step: Check if this new path is faster than the known path.
-                if (minTime[u] + realTime < minTime[v]) {
-                    minTime[v] = minTime[u] + realTime; // Update shortest time to v.
-                    parent[v] = u;                      // Set u as the parent of v (for path rebuilding).
-                    pathDist[v] = pathDist[u] + edge.distanceKM; // Update total distance to v.
-                    
-                    // Calculate Fuel for this segment based on road type and speed.
-                    double segmentEff = calculateFuelEfficiency(speed, edge.type);
-                    // Add this segment's fuel usage to total fuel used so far.
-                    fuelConsumed[v] = fuelConsumed[u] + (edge.distanceKM / segmentEff);
-                    
-                    pq.push({v, minTime[v]}); // Add v to the queue to explore its neighbors.
+            for (size_t m = 0; m < modes.size(); m++) {
+                auto p0 = chrono::steady_clock::now();
+                planner.prepareSearchMode(modes[m]);
+                double preprocessMs = chrono::duration<double, milli>(chrono::steady_clock::now() - p0).count();
+
+                vector<double> micros;
+                double settled = 0, relaxed = 0, pushes = 0, stale = 0;
+                int unreachable = 0;
+                for (auto& q : pairs) {
+                    auto q0 = chrono::steady_clock::now();
+                    RouteResult result = planner.planRoute(q.first, q.second, SPEED, modes[m]);
+                    micros.push_back(chrono::duration<double, micro>(chrono::steady_clock::now() - q0).count());
+                    settled += result.stats.settledNodes;
+                    relaxed += result.stats.relaxedEdges;
+                    pushes += result.stats.heapPushes;
+                    stale += result.stats.stalePops;
+                    if (!result.found) unreachable++;
                 }
-                // --- PHYSICS LOGIC END ---
+                sort(micros.begin(), micros.end());
+                auto percentile = [&](double fraction) {
+                    return micros.empty() ? 0.0 : micros[min(micros.size() - 1, (size_t)(fraction * micros.size()))];
+                };
+                double mean = 0;
+                for (double v : micros) mean += v;
+                int count = max(1, (int)micros.size());
+                double rssMB, peakMB;
+                readProcessMemoryMB(rssMB, peakMB);
+
+                char line[768];
+                snprintf(line, sizeof(line),
+                         "{\"suite\":\"routing\",\"format\":1,\"topology\":\"%s\",\"cities\":%d,\"roads\":%zu,"
+                         "\"directed_roads\":%d,\"mode\":\"%s\",\"speed\":%d,\"queries\":%d,\"unreachable\":%d,"
+                         "\"generate_ms\":%.2f,\"load_ms\":%.2f,\"preprocess_ms\":%.2f,"
+                         "\"mean_us\":%.2f,\"p50_us\":%.2f,\"p90_us\":%.2f,\"p99_us\":%.2f,\"max_us\":%.2f,"
+                         "\"settled_mean\":%.1f,\"relaxed_mean\":%.1f,\"heap_pushes_mean\":%.1f,\"stale_pops_mean\":%.1f,"
+                         "\"instrumented\":%d,\"rss_mb\":%.1f,\"peak_rss_mb\":%.1f}",
+                         topology.c_str(), n, twoWayRoads, planner.getEdgeCount(), modeNames[m].c_str(), SPEED,
+                         (int)micros.size(), unreachable, generateMs, loadMs, preprocessMs, mean / count,
+                         percentile(0.5), percentile(0.9), percentile(0.99), percentile(1.0),
+                         settled / count, relaxed / count, pushes / count, stale / count, instrumented, rssMB, peakMB);
+                out << line << endl;
+                cerr << "  " << left << setw(10) << topology << right << setw(9) << n << " cities  "
+                     << left << setw(9) << modeNames[m] << right << fixed << setprecision(1)
+                     << " p50 " << setw(10) << percentile(0.5) << " us  p99 " << setw(10) << percentile(0.99)
+                     << " us  " << setw(10) << settled / count << " settled" << endl;
             }
         }
+    }
+    METRIC(queryMetrics().dump(cerr)); // Histograms over the whole run.
+}
 
-        // Check if the destination is reachable.
-        if (minTime[endNode] == INF) {
-            cout << "\nError: No road connection exists between these cities." << endl; // Prints error if unreachable.
-            return;
-        }
+// Prints the fleet costs of Islamabad -> Lahore on the built-in map, then plans 'tripCount'
+// random trips with random vehicles on a synthetic grid on all cores (at least 4 threads, so
+// concurrent hierarchy queries are exercised even on small machines). Checks every trip's
+// fuel against the vehicle's efficiency curve evaluated road by road and its time against
+// plain Dijkstra on one thread.
+void runFleetBenchmark(int side, int tripCount) {
+    RoutePlanner builtIn;
+    builtIn.findFleetCosts(7, 6, 100);
 
-        // If reachable, print the full receipt/itinerary.
-        printDetailedReceipt(startNode, endNode, parent, minTime[endNode], pathDist[endNode], fuelConsumed[endNode], speed);
+    RoutePlanner planner(false);
+    loadSyntheticMap(planner, generateGridMap(side, side, 42));
+    mt19937 rng(101);
+    uniform_int_distribution<int> vehiclePick(0, VEHICLE_KIND_COUNT - 1), speedPick(50, 120);
+    vector<FleetTrip> trips;
+    for (auto& q : randomPairs(planner.getCityCount(), tripCount, 103)) {
+        trips.push_back({(VehicleKind)vehiclePick(rng), q.first, q.second, speedPick(rng)});
     }
+    planner.prepareSearchMode(CONTRACTION_HIERARCHY);
+    int threads = max(4, resolveThreadCount(0));
+    auto t0 = chrono::steady_clock::now();
+    vector<RouteResult> results = planner.planFleetRoutes(trips, CONTRACTION_HIERARCHY, threads);
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - t0).count();
+    vector<RouteResult> reference = planner.planFleetRoutes(trips, DIJKSTRA, 1);
 
-    // ==========================================
-    //          OUTPUT FORMATTING
-    // ==========================================
-    // Function to print the final results table.
-    void printDetailedReceipt(int start, int end, vector<int>& parent, double totalTime, double totalDist, double totalFuel, int speed) {
-        // Reconstruct path by backtracking from destination to start.
-        vector<int> path;
-        for (int v = end; v != -1; v = parent[v]) {
-            path.push_back(v); // Adds current city to path.
-        }
-
-        cout << "\n";
-        cout << "########################################################" << endl;
-        cout << "              SMART ROUTE NAVIGATOR RESULTS             " << endl;
-        cout << "########################################################" << endl;
-        cout << " Origin      : " << cityNames[start] << endl; // Prints origin city name.
-        cout << " Destination : " << cityNames[end] << endl;   // Prints destination city name.
-        cout << " Avg Speed   : " << speed << " km/h" << endl; // Prints user speed.
-        cout << "--------------------------------------------------------" << endl;
-        // Sets up table headers with specific widths.
-        cout << left << setw(20) << "Leg From -> To" 
-             << setw(18) << "Via Road" 
-             << setw(10) << "Cond." 
-             << "Dist." << endl;
-        cout << "--------------------------------------------------------" << endl;
+    double litres[2] = {0, 0}, cost[2] = {0, 0};
+    int mismatches = 0, wrongRoutes = 0;
+    for (size_t k = 0; k < results.size(); k++) {
+        const RouteResult& r = results[k];
+        if (r.found != reference[k].found || fabs(r.totalTime - reference[k].totalTime) > 1e-6) wrongRoutes++;
+        const VehicleProfile& vehicle = getVehicleProfile(r.vehicle);
+        double expected = 0;
+        for (const RouteLeg& leg : r.legs) {
+            expected += leg.distanceKM / vehicle.efficiency(r.speed, leg.type);
+        }
+        if (fabs(expected - r.totalFuel) > 1e-9 * max(1.0, expected) ||
+            fabs(r.fuelCost - r.totalFuel * vehicle.getFuelPrice()) > 1e-6) mismatches++;
+        litres[vehicle.getFuel()] += r.totalFuel;
+        cost[vehicle.getFuel()] += r.fuelCost;
+    }
+    cout << "\nGrid " << side << "x" << side << " (" << planner.getCityCount() << " cities), " << tripCount
+         << " fleet trips with random vehicles, " << threads << " thread(s)" << endl;
+    cout << fixed << setprecision(1);
+    cout << "  planning         : " << tripCount / seconds << " trips/s" << endl;
+    cout << "  petrol           : " << litres[PETROL] << " L, PKR " << setprecision(0) << cost[PETROL] << endl;
+    cout << "  diesel           : " << setprecision(1) << litres[DIESEL] << " L, PKR " << setprecision(0) << cost[DIESEL] << endl;
+    cout << "  fuel differing from the vehicle curves : " << mismatches << endl;
+    cout << "  times differing from Dijkstra          : " << wrongRoutes << endl;
+}
 
-        // Print Path in correct order (Reverse of the backtracking loop).
-        for (int i = path.size() - 1; i > 0; i--) {
-            int u = path[i];   // Current city.
-            int v = path[i-1]; // Next city in path.
-            
-            // Variables to hold road details for printing.
-            string rName = "Unknown";
-            string tCond = "Unknown";
-            double d = 0;
-            
-            // Loop through edges to find the specific road connecting u and v.
-            for(auto& e : adj[u]) {
-                if(e.destination == v) {
-                    rName = e.roadName;                // Get road name.
-                    tCond = getTrafficString(e.traffic); // Get traffic string.
-                    d = e.distanceKM;                  // Get distance.
-                    break;                             // Stop looking once found.
-                }
-            }
-
-            string leg = cityNames[u] + "->" + cityNames[v]; // Create string "CityA->CityB".
-            // Truncate leg name if too long for cleaner output alignment.
-            if(leg.length() > 18) leg = leg.substr(0, 18);
+// Prints a delivery run over the built-in map, then checks the tour solver on a synthetic
+// grid: local search against the exact order on many small runs, and the full pipeline
+// (matrix, ordering, legs) on one run of 'stopCount' random stops.
+void runTourBenchmark(int side, int stopCount) {
+    RoutePlanner builtIn;
+    builtIn.findTour({7, 1, 3, 5, 10, 12, 14}, 100);
 
-            // Print the row for this leg of the journey.
-            cout << left << setw(20) << leg
-                 << setw(18) << rName 
-                 << setw(10) << tCond 
-                 << d << " km" << endl;
+    RoutePlanner planner(false);
+    loadSyntheticMap(planner, generateGridMap(side, side, 42));
+    planner.prepareSearchMode(CONTRACTION_HIERARCHY);
+    mt19937 rng(211);
+    uniform_int_distribution<int> cityPick(1, planner.getCityCount());
+    auto randomStops = [&](int count) {
+        vector<int> stops;
+        while ((int)stops.size() < count) {
+            int city = cityPick(rng);
+            if (find(stops.begin(), stops.end(), city) == stops.end()) stops.push_back(city);
         }
+        return stops;
+    };
 
-        cout << "--------------------------------------------------------" << endl;
-        
-        // Final Calculations for time and cost.
-        int hrs = (int)totalTime / 60;      // Convert total minutes to hours.
-        int mins = (int)totalTime % 60;     // Get remaining minutes.
-        double cost = totalFuel * PRICE_PETROL; // Calculate total cost.
+    // 1. Local search against Held-Karp on small runs.
+    const int SMALL_RUNS = 50, SMALL_STOPS = 12;
+    int optimal = 0;
+    double worstGap = 0;
+    for (int run = 0; run < SMALL_RUNS; run++) {
+        vector<int> stops = randomStops(SMALL_STOPS);
+        TravelMatrix matrix = planner.computeTravelMatrix(stops, stops, 100);
+        TourSolver solver(matrix.minTime, SMALL_STOPS, true);
+        double exact = solver.tourCost(solver.solve());
+        double heuristic = solver.tourCost(solver.solve(-1, run + 1, 0));
+        if (heuristic <= exact + 1e-6) optimal++;
+        worstGap = max(worstGap, heuristic / exact - 1);
+    }
 
-        // Print the final summary totals.
-        cout << right << setw(35) << "TOTAL DISTANCE : " << setw(10) << totalDist << " km" << endl;
-        cout << right << setw(35) << "ESTIMATED TIME : " << hrs << "h " << mins << "m" << endl;
-        cout << right << setw(35) << "FUEL REQUIRED : " << fixed << setprecision(1) << totalFuel << " L" << endl;
-        cout << right << setw(35) << "EST. FUEL COST : " << "PKR " << setprecision(2) << cost << endl;
-        cout << "########################################################" << endl;
-        cout << "Note: Traffic conditions may vary based on weather." << endl;
+    // 2. One large run end to end.
+    vector<int> stops = randomStops(stopCount);
+    TourResult tour = planner.planTour(stops, 100);
+    TravelMatrix matrix = planner.computeTravelMatrix(stops, stops, 100);
+    TourSolver solver(matrix.minTime, stopCount, true);
+    double greedy = solver.tourCost(solver.nearestNeighbourTour());
+    double legMismatch = 0;
+    for (const RouteResult& leg : tour.legs) {
+        int from = (int)(find(stops.begin(), stops.end(), leg.startNode) - stops.begin());
+        int to = (int)(find(stops.begin(), stops.end(), leg.endNode) - stops.begin());
+        legMismatch = max(legMismatch, fabs(leg.totalTime - matrix.minTime[(size_t)from * stopCount + to]));
     }
 
-    // Function to display the list of cities to the user.
-    void displayMenu() {
-        cout << "\n--- AVAILABLE CITIES ---" << endl;
-        for (int i = 1; i <= cityCount; i++) {
-            // Prints ID and Name in 3 columns for better layout.
-            cout << left << setw(3) << i << ". " << setw(15) << cityNames[i];
-            if (i % 3 == 0) cout << endl; // Inserts a new line every 3 cities.
+    cout << "\nGrid " << side << "x" << side << " (" << planner.getCityCount() << " cities), "
+         << resolveThreadCount(0) << " thread(s)" << endl;
+    cout << fixed << setprecision(2);
+    cout << "  " << SMALL_RUNS << " runs of " << SMALL_STOPS << " stops, local search vs exact : "
+         << optimal << " optimal, worst gap " << worstGap * 100 << "%" << endl;
+    cout << "  " << stopCount << " stops, round trip : " << (tour.found ? "found" : "NOT FOUND") << endl;
+    cout << "    matrix                 : " << tour.matrixMs << " ms" << endl;
+    cout << "    ordering               : " << tour.solveMs << " ms" << endl;
+    cout << "    legs                   : " << tour.legsMs << " ms" << endl;
+    cout << "    tour                   : " << setprecision(1) << tour.totalTime / 60 << " h, "
+         << tour.totalDist << " km (nearest neighbour: " << greedy / 60 << " h, "
+         << setprecision(2) << (1 - tour.totalTime / greedy) * 100 << "% saved)" << endl;
+    cout << "    legs differing from the matrix : " << legMismatch << " min at most" << endl;
+}
+
+// Prints a fleet plan over the built-in map, then solves generated instances on a synthetic
+// grid: orders at random cities with loads of 1-10, the depot in the middle and room for
+// about 12 orders per vehicle (the shape of the usual CVRP benchmark sets). Reports the
+// cost against the savings start (and how many orders that start left out), the search rate
+// and a check that every order is delivered exactly once, at its own city, without
+// overloading a vehicle, with every leg (planned on at least 4 threads) as fast as plain
+// Dijkstra finds it.
+void runVrpBenchmark(int side, int iterations) {
+    RoutePlanner builtIn;
+    FleetProblem sample;
+    sample.depot = 7;
+    sample.capacity = 10;
+    sample.speed = 80;
+    for (int city : {1, 2, 3, 4, 5, 6, 8, 9, 10, 11, 12, 13, 14, 15}) sample.orders.push_back({city, (double)(city % 4 + 1)});
+    builtIn.findFleetPlan(sample);
+
+    RoutePlanner planner(false);
+    loadSyntheticMap(planner, generateGridMap(side, side, 42));
+    planner.prepareSearchMode(CONTRACTION_HIERARCHY);
+    int starts = resolveThreadCount(0), threads = max(4, starts);
+    cout << "\nGrid " << side << "x" << side << " (" << planner.getCityCount() << " cities), " << iterations
+         << " ruin-and-recreate steps per start, " << starts << " start(s) on " << threads << " thread(s)" << endl;
+    cout << left << setw(9) << " Orders" << setw(10) << "Vehicles" << right << setw(14) << "Savings PKR"
+         << setw(10) << "Left out" << setw(14) << "Best PKR" << setw(9) << "Gain" << setw(12) << "Matrix ms" << setw(11) << "Search s"
+         << setw(13) << "Solutions/s" << setw(8) << "Errors" << endl;
+
+    const int sizes[] = {100, 200, 400};
+    for (int run = 0; run < 4; run++) {
+        int orders = sizes[min(run, 2)];
+        mt19937 rng(300 + orders);
+        uniform_int_distribution<int> cityPick(1, planner.getCityCount()), loadPick(1, 10);
+        FleetProblem problem;
+        problem.depot = (side / 2) * side + side / 2 + 1;
+        problem.capacity = 66;
+        double totalLoad = 0;
+        for (int k = 0; k < orders; k++) {
+            problem.orders.push_back({cityPick(rng), (double)loadPick(rng)});
+            totalLoad += problem.orders.back().demand;
         }
-        if (cityCount % 3 != 0) cout << endl; // Ensures final newline if not divisible by 3.
+        if (run == 3) problem.maxVehicles = (int)ceil(totalLoad / problem.capacity); // Fewest vehicles the load allows.
+
+        FleetPlan plan = planner.planFleet(problem, iterations, starts, threads);
+        int errors = plan.found ? 0 : 1;
+        vector<int> delivered(orders, 0);
+        for (size_t r = 0; r < plan.routes.size(); r++) {
+            double load = 0;
+            const vector<int>& stops = plan.routes[r].stops;
+            const vector<int>& served = plan.orders[r];
+            if (served.size() + 2 != stops.size()) errors++;
+            for (size_t k = 0; k < served.size() && k + 2 < stops.size(); k++) {
+                int o = served[k];
+                if (o < 0 || o >= orders || problem.orders[o].city != stops[k + 1]) {
+                    errors++;
+                    continue;
+                }
+                delivered[o]++;
+                load += problem.orders[o].demand;
+            }
+            if (load > problem.capacity || fabs(load - plan.loads[r]) > 1e-9) errors++;
+            for (const RouteResult& leg : plan.routes[r].legs) {
+                RouteResult check = planner.planRoute(leg.startNode, leg.endNode, problem.speed, DIJKSTRA, problem.vehicle);
+                if (!leg.found || fabs(leg.totalTime - check.totalTime) > 1e-6) errors++;
+            }
+        }
+        for (int o = 0; o < orders; o++) errors += delivered[o] != 1;
+
+        string label = to_string(orders) + (problem.maxVehicles > 0 ? "*" : "");
+        cout << " " << left << setw(8) << label << setw(10) << plan.routes.size() << right << fixed << setprecision(0)
+             << setw(14) << plan.savingsCost << setw(10) << plan.savingsUnassigned << setw(14) << plan.totalCost;
+        // The gain only compares like with like: a start that left orders out isn't cheaper.
+        if (plan.savingsUnassigned == 0) cout << setprecision(2) << setw(8) << (1 - plan.totalCost / plan.savingsCost) * 100 << "%";
+        else cout << setw(9) << "-";
+        cout << setprecision(1)
+             << setw(12) << plan.matrixMs << setw(11) << setprecision(2) << plan.solveMs / 1000
+             << setw(13) << setprecision(0) << plan.solutions / (plan.solveMs / 1000) << setw(8) << errors << endl;
     }
-};
+    cout << " (* = fleet limited to the fewest vehicles the total load allows; \"Left out\" counts the orders" << endl;
+    cout << "  the savings start could not fit, which the search then worked in)" << endl;
+}
 
 // ==========================================
 //            MAIN EXECUTION
 // ==========================================
-int main() {
+int main(int argc, char* argv[]) {
+    // Benchmark mode: "--bench-csr [gridSide] [queries]" instead of the interactive menu.
+    if (argc > 1 && string(argv[1]) == "--bench-csr") {
+        int side = argc > 2 ? atoi(argv[2]) : 300;   // Default 300x300 = 90,000 cities.
+        int queries = argc > 3 ? atoi(argv[3]) : 20; // Default 20 searches per layout.
+        runCsrBenchmark(side, queries);
+        return 0;
+    }
+    // Benchmark mode: "--bench-bidir [gridSide] [queries]".
+    if (argc > 1 && string(argv[1]) == "--bench-bidir") {
+        int side = argc > 2 ? atoi(argv[2]) : 300;
+        int queries = argc > 3 ? atoi(argv[3]) : 100;
+        runBidirectionalBenchmark(side, queries);
+        return 0;
+    }
+    // Benchmark mode: "--bench-astar [gridSide] [queries]".
+    if (argc > 1 && string(argv[1]) == "--bench-astar") {
+        int side = argc > 2 ? atoi(argv[2]) : 300;
+        int queries = argc > 3 ? atoi(argv[3]) : 100;
+        runAStarBenchmark(side, queries);
+        return 0;
+    }
+    // Benchmark mode: "--bench-ch [gridSide] [queries]".
+    if (argc > 1 && string(argv[1]) == "--bench-ch") {
+        int side = argc > 2 ? atoi(argv[2]) : 300;
+        int queries = argc > 3 ? atoi(argv[3]) : 100;
+        runHierarchyBenchmark(side, queries);
+        return 0;
+    }
+    // Benchmark mode: "--bench-crp [gridSide] [queries] [trafficUpdates]".
+    if (argc > 1 && string(argv[1]) == "--bench-crp") {
+        int side = argc > 2 ? atoi(argv[2]) : 200;
+        int queries = argc > 3 ? atoi(argv[3]) : 100;
+        int updates = argc > 4 ? atoi(argv[4]) : 100;
+        runOverlayBenchmark(side, queries, updates);
+        return 0;
+    }
+    // Benchmark mode: "--bench-alternatives [gridSide] [queries] [routes] [localOptimality]".
+    if (argc > 1 && string(argv[1]) == "--bench-alternatives") {
+        int side = argc > 2 ? atoi(argv[2]) : 300;
+        int queries = argc > 3 ? atoi(argv[3]) : 50;
+        int k = argc > 4 ? atoi(argv[4]) : 3;
+        double alpha = argc > 5 ? atof(argv[5]) : 0.25;
+        runAlternativeBenchmark(side, queries, k, alpha);
+        return 0;
+    }
+    // Benchmark mode: "--bench-isochrone [gridSide] [origins] [minutes]".
+    if (argc > 1 && string(argv[1]) == "--bench-isochrone") {
+        int side = argc > 2 ? atoi(argv[2]) : 300;
+        int origins = argc > 3 ? atoi(argv[3]) : 200;
+        double minutes = argc > 4 ? atof(argv[4]) : 60;
+        runIsochroneBenchmark(side, origins, minutes);
+        return 0;
+    }
+    // Benchmark mode: "--bench-alt [gridSide] [queries] [landmarks]".
+    if (argc > 1 && string(argv[1]) == "--bench-alt") {
+        int side = argc > 2 ? atoi(argv[2]) : 300;
+        int queries = argc > 3 ? atoi(argv[3]) : 100;
+        int k = argc > 4 ? atoi(argv[4]) : 16;
+        runLandmarkBenchmark(side, queries, k);
+        return 0;
+    }
+    // Benchmark mode: "--bench-matrix [gridSide] [origins] [destinations]".
+    if (argc > 1 && string(argv[1]) == "--bench-matrix") {
+        int side = argc > 2 ? atoi(argv[2]) : 150;
+        int sources = argc > 3 ? atoi(argv[3]) : 500;
+        int targets = argc > 4 ? atoi(argv[4]) : 5000;
+        runMatrixBenchmark(side, sources, targets);
+        return 0;
+    }
+    // Benchmark mode: "--bench-queues [largestGridSide] [queries]".
+    if (argc > 1 && string(argv[1]) == "--bench-queues") {
+        int side = argc > 2 ? atoi(argv[2]) : 300;
+        int queries = argc > 3 ? atoi(argv[3]) : 200;
+        runQueueBenchmark(side, queries);
+        return 0;
+    }
+    // Benchmark mode: "--bench-tree-cache [gridSide] [queries]".
+    if (argc > 1 && string(argv[1]) == "--bench-tree-cache") {
+        int side = argc > 2 ? atoi(argv[2]) : 300;
+        int queries = argc > 3 ? atoi(argv[3]) : 50;
+        runTreeCacheBenchmark(side, queries);
+        return 0;
+    }
+    // Benchmark mode: "--bench-pareto [gridSide] [queries] [labelsPerCity]".
+    if (argc > 1 && string(argv[1]) == "--bench-pareto") {
+        int side = argc > 2 ? atoi(argv[2]) : 100;
+        int queries = argc > 3 ? atoi(argv[3]) : 50;
+        int maxLabels = argc > 4 ? atoi(argv[4]) : 8;
+        runParetoBenchmark(side, queries, maxLabels);
+        return 0;
+    }
+    // Benchmark mode: "--bench-traffic [gridSide] [changes]".
+    if (argc > 1 && string(argv[1]) == "--bench-traffic") {
+        int side = argc > 2 ? atoi(argv[2]) : 300;
+        int updates = argc > 3 ? atoi(argv[3]) : 5000;
+        runTrafficBenchmark(side, updates);
+        return 0;
+    }
+    // Benchmark mode: "--bench-td [gridSide] [queries]".
+    if (argc > 1 && string(argv[1]) == "--bench-td") {
+        int side = argc > 2 ? atoi(argv[2]) : 300;
+        int queries = argc > 3 ? atoi(argv[3]) : 50;
+        runTimeDependentBenchmark(side, queries);
+        return 0;
+    }
+    // Benchmark mode: "--bench-mmap [gridSide] [queries] [file]".
+    if (argc > 1 && string(argv[1]) == "--bench-mmap") {
+        int side = argc > 2 ? atoi(argv[2]) : 1000;  // Default 1000x1000 = 4 million directed roads.
+        int queries = argc > 3 ? atoi(argv[3]) : 20;
+        runGraphFileBenchmark(side, queries, argc > 4 ? argv[4] : "bench_graph.bin");
+        return 0;
+    }
+    // Converter mode: "--convert-graph <file> [gridSide]" writes the built-in map (or a
+    // synthetic grid) as a binary graph file.
+    if (argc > 2 && string(argv[1]) == "--convert-graph") {
+        bool grid = argc > 3;
+        RoutePlanner source(!grid);
+        if (grid) loadSyntheticMap(source, generateGridMap(atoi(argv[3]), atoi(argv[3]), 42));
+        if (!source.saveBinaryGraph(argv[2])) {
+            cout << "Could not write " << argv[2] << endl;
+            return 1;
+        }
+        cout << "Wrote " << source.getCityCount() << " cities and " << source.getEdgeCount() << " directed roads to " << argv[2] << endl;
+        return 0;
+    }
+    // Benchmark mode: "--bench-import [gridSide] [threads] [filePrefix]".
+    if (argc > 1 && string(argv[1]) == "--bench-import") {
+        int side = argc > 2 ? atoi(argv[2]) : 500;
+        int threads = argc > 3 ? atoi(argv[3]) : 0;
+        runImportBenchmark(side, threads, argc > 4 ? argv[4] : "bench_import");
+        return 0;
+    }
+    // Import modes: "--import-csv <nodes.csv> <roads.csv> [graphFile]" and
+    // "--import-osm <extract.txt> [graphFile]" import a map, report the rate and optionally
+    // save it as a binary graph file.
+    if ((argc > 3 && string(argv[1]) == "--import-csv") || (argc > 2 && string(argv[1]) == "--import-osm")) {
+        bool csv = string(argv[1]) == "--import-csv";
+        RoutePlanner imported(false);
+        RoadNetworkImporter importer(imported);
+        if (!(csv ? importer.importCsv(argv[2], argv[3]) : importer.importOsmText(argv[2]))) {
+            cout << "Could not read the input files." << endl;
+            return 1;
+        }
+        printImportStats(importer.getStats());
+        int output = csv ? 4 : 3;
+        if (argc > output && !imported.saveBinaryGraph(argv[output])) {
+            cout << "Could not write " << argv[output] << endl;
+            return 1;
+        }
+        return 0;
+    }
+    // Mapped graph mode: "--route-file <file> <startId> <destinationId> <speed>".
+    if (argc > 5 && string(argv[1]) == "--route-file") {
+        RoutePlanner app(false);
+        if (!app.loadBinaryGraph(argv[2])) {
+            cout << "Could not load " << argv[2] << endl;
+            return 1;
+        }
+        app.findRoute(atoi(argv[3]), atoi(argv[4]), atoi(argv[5]));
+        return 0;
+    }
+    // Departure time mode: "--depart <startId> <destinationId> <speed> <HH:MM>" on the built-in map.
+    if (argc > 5 && string(argv[1]) == "--depart") {
+        int hours = 0, minutes = 0;
+        sscanf(argv[5], "%d:%d", &hours, &minutes);
+        RoutePlanner app;
+        app.findRouteDepartingAt(atoi(argv[2]), atoi(argv[3]), atoi(argv[4]), hours * 60.0 + minutes);
+        return 0;
+    }
+    // Route options mode: "--pareto <startId> <destinationId> <speed>" on the built-in map.
+    if (argc > 4 && string(argv[1]) == "--pareto") {
+        RoutePlanner app;
+        app.findParetoRoutes(atoi(argv[2]), atoi(argv[3]), atoi(argv[4]));
+        return 0;
+    }
+    // Fleet mode: "--fleet <startId> <destinationId> <speed>" compares the cost of one trip
+    // for every vehicle on the built-in map.
+    if (argc > 4 && string(argv[1]) == "--fleet") {
+        RoutePlanner app;
+        app.findFleetCosts(atoi(argv[2]), atoi(argv[3]), atoi(argv[4]));
+        return 0;
+    }
+    // Benchmark mode: "--bench-fleet [gridSide] [trips]".
+    if (argc > 1 && string(argv[1]) == "--bench-fleet") {
+        int side = argc > 2 ? atoi(argv[2]) : 300;
+        int trips = argc > 3 ? atoi(argv[3]) : 2000;
+        runFleetBenchmark(side, trips);
+        return 0;
+    }
+    // Delivery run mode: "--tour <speed> <depotId> <stopId>... [open] [fuel] [car|truck|bus]" on
+    // the built-in map. "open" ends the run at the last stop instead of back at the depot and
+    // "fuel" orders the stops for the least fuel instead of the least time.
+    if (argc > 3 && string(argv[1]) == "--tour") {
+        vector<int> stops;
+        bool roundTrip = true;
+        TourObjective objective = TOUR_TIME;
+        VehicleKind vehicle = PETROL_CAR;
+        for (int k = 3; k < argc; k++) {
+            string arg = argv[k];
+            if (arg == "open") roundTrip = false;
+            else if (arg == "fuel") objective = TOUR_FUEL;
+            else if (!parseVehicleName(arg, vehicle)) stops.push_back(atoi(argv[k]));
+        }
+        RoutePlanner app;
+        app.findTour(stops, atoi(argv[2]), roundTrip, vehicle, objective);
+        return 0;
+    }
+    // Benchmark mode: "--bench-tour [gridSide] [stops]".
+    if (argc > 1 && string(argv[1]) == "--bench-tour") {
+        int side = argc > 2 ? atoi(argv[2]) : 300;
+        int stops = argc > 3 ? atoi(argv[3]) : 200;
+        runTourBenchmark(side, stops);
+        return 0;
+    }
+    // Fleet routing mode: "--vrp <speed> <capacity> <vehicles> <depotId> <cityId[:load]>... [car|truck|bus]"
+    // on the built-in map. Vehicles 0 means as many as needed; an order without a load takes 1.
+    if (argc > 5 && string(argv[1]) == "--vrp") {
+        FleetProblem problem;
+        problem.speed = atoi(argv[2]);
+        problem.capacity = atof(argv[3]);
+        problem.maxVehicles = atoi(argv[4]);
+        problem.depot = atoi(argv[5]);
+        for (int k = 6; k < argc; k++) {
+            if (parseVehicleName(argv[k], problem.vehicle)) continue;
+            int city = 0;
+            double load = 1;
+            sscanf(argv[k], "%d:%lf", &city, &load);
+            problem.orders.push_back({city, load});
+        }
+        RoutePlanner app;
+        app.findFleetPlan(problem);
+        return 0;
+    }
+    // Benchmark mode: "--bench-vrp [gridSide] [iterations]".
+    if (argc > 1 && string(argv[1]) == "--bench-vrp") {
+        int side = argc > 2 ? atoi(argv[2]) : 300;
+        int iterations = argc > 3 ? atoi(argv[3]) : 20000;
+        runVrpBenchmark(side, iterations);
+        return 0;
+    }
+    // Alternative routes mode: "--alternatives <startId> <destinationId> <speed> [routes]" on the built-in map.
+    if (argc > 4 && string(argv[1]) == "--alternatives") {
+        RoutePlanner app;
+        app.findAlternativeRoutes(atoi(argv[2]), atoi(argv[3]), atoi(argv[4]), argc > 5 ? atoi(argv[5]) : 3);
+        return 0;
+    }
+
+    // Isochrone mode: "--isochrone <originId> <speed> <hours> [fuel [car|truck|bus]]" on the
+    // built-in map; with "fuel" the budget is litres of the vehicle's fuel instead of hours.
+    if (argc > 4 && string(argv[1]) == "--isochrone") {
+        RoutePlanner app;
+        bool fuel = argc > 5 && string(argv[5]) == "fuel";
+        VehicleKind vehicle = PETROL_CAR;
+        if (argc > 6 && !parseVehicleName(argv[6], vehicle)) {
+            cout << "Unknown vehicle " << argv[6] << " (car, truck or bus)" << endl;
+            return 1;
+        }
+        app.findIsochrone(atoi(argv[2]), atoi(argv[3]), atof(argv[4]), fuel ? FUEL_BUDGET : TIME_BUDGET, vehicle);
+        return 0;
+    }
+    // Server modes: "--serve [graphFile] [workers]" answers request lines from stdin on stdout;
+    // "--serve-socket <path> [graphFile] [workers]" listens on a Unix domain socket until a
+    // client sends "shutdown". Without a graph file the built-in map is served.
+    if (argc > 1 && (string(argv[1]) == "--serve" || (argc > 2 && string(argv[1]) == "--serve-socket"))) {
+        bool socketMode = string(argv[1]) == "--serve-socket";
+        int graphArg = socketMode ? 3 : 2;
+        bool fromFile = argc > graphArg && string(argv[graphArg]) != "-";
+        RoutePlanner app(!fromFile);
+        if (fromFile && !app.loadBinaryGraph(argv[graphArg])) {
+            cerr << "Could not load " << argv[graphArg] << endl;
+            return 1;
+        }
+        QueryServer server(app, argc > graphArg + 1 ? atoi(argv[graphArg + 1]) : 0);
+        server.start();
+        bool served = true;
+        if (socketMode) {
+            served = server.serveUnixSocket(argv[2]);
+        } else {
+            ios::sync_with_stdio(false);
+            server.serveStream(cin, cout);
+        }
+        server.stop();
+        if (!served) {
+            cerr << "Could not listen on " << argv[2] << endl;
+            return 1;
+        }
+        cerr << server.latencySummary() << endl;
+        return 0;
+    }
+    // Benchmark mode: "--bench-server [gridSide] [requests] [clients] [mode]".
+    if (argc > 1 && string(argv[1]) == "--bench-server") {
+        int side = argc > 2 ? atoi(argv[2]) : 300;
+        int requests = argc > 3 ? atoi(argv[3]) : 20000;
+        int clients = argc > 4 ? atoi(argv[4]) : 4;
+        runServerBenchmark(side, requests, clients, argc > 5 ? argv[5] : "ch");
+        return 0;
+    }
+    // Benchmark suite: "--bench-suite [maxCities] [queries] [modes] [topologies] [outputFile]"
+    // writes one JSON line per topology, size and search mode (to stdout without an output file).
+    if (argc > 1 && string(argv[1]) == "--bench-suite") {
+        // The default run takes about a minute. Larger runs (up to 10^7 cities) should name their
+        // modes and topologies: the hubs of a scale-free map form a dense core that takes the
+        // contraction hierarchy minutes to contract beyond 10^4 cities.
+        int maxCities = argc > 2 ? atoi(argv[2]) : 10000;
+        int queries = argc > 3 ? atoi(argv[3]) : 200;
+        string modes = argc > 4 ? argv[4] : "dijkstra,bidir,astar,ch";
+        string topologies = argc > 5 ? argv[5] : "grid,geometric,scalefree";
+        if (argc > 6) {
+            ofstream file(argv[6]);
+            if (!file) {
+                cerr << "Could not write " << argv[6] << endl;
+                return 1;
+            }
+            runBenchmarkSuite(maxCities, queries, modes, topologies, file);
+        } else {
+            runBenchmarkSuite(maxCities, queries, modes, topologies, cout);
+        }
+        return 0;
+    }
     RoutePlanner app;       // Creates an instance of the RoutePlanner application.
-    int source, dest, speedInput; // Variables to store user inputs.
+    int source, dest, speedInput, vehicleInput; // Variables to store user inputs.
     char choice = 'y';      // Variable to control the main loop (y/n).
 
     // Main loop keeps program running until user chooses to exit.
@@ -381,8 +7781,16 @@ int main() {
             cin.clear(); cin.ignore(1000, '\n');
         }
 
+        // Input Validation Loop for the Vehicle (sets the fuel curve and fuel price).
+        while (true) {
+            cout << "Select Vehicle (1 = Petrol Car, 2 = Diesel Truck, 3 = Bus): ";
+            if (cin >> vehicleInput && vehicleInput >= 1 && vehicleInput <= VEHICLE_KIND_COUNT) break;
+            cout << "Invalid Input! Please enter 1, 2 or 3." << endl;
+            cin.clear(); cin.ignore(1000, '\n');
+        }
+
         // Runs the pathfinding algorithm with the gathered inputs.
-        app.findRoute(source, dest, speedInput);
+        app.findRoute(source, dest, speedInput, DIJKSTRA, (VehicleKind)(vehicleInput - 1));
 
         // Asks user if they want to restart.
         cout << "\nDo you want to plan another trip? (y/n): ";